@@ -0,0 +1,393 @@
+/**
+ * \file
+ *
+ * Decoder for binary deferred-format log records, see binlog.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "binlog.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+enum {
+	BINLOG_STATE_TEXT = 0,  /* outside a frame */
+	BINLOG_STATE_TYPE,      /* STX received */
+	BINLOG_STATE_BODY,      /* header and payload */
+	BINLOG_STATE_SUM,       /* checksum */
+	BINLOG_STATE_SKIP,      /* rest of a rejected frame */
+};
+
+/** Header size of both frame types: id(u16) + count(u8) */
+#define BINLOG_HEADER_SIZE      3
+
+/** Pool slot header: id(u8) + size(u8), the text follows */
+#define BINLOG_SLOT_HEADER      2
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _get_u32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Append an integer conversion to \a out.
+ */
+static uint32_t _put_number(char *out, uint32_t pos, uint32_t size,
+			    uint32_t value, bool negative, uint32_t base,
+			    bool upper, uint32_t width, bool left, bool zero)
+{
+	const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	char tmp[12];
+	uint32_t n = 0, len;
+
+	do {
+		tmp[n++] = digits[value % base];
+		value /= base;
+	} while (value);
+	len = n + (negative ? 1 : 0);
+
+	if (negative && zero && pos < size)
+		out[pos++] = '-';
+	if (!left) {
+		for (; len < width && pos < size; width--)
+			out[pos++] = zero ? '0' : ' ';
+	}
+	if (negative && !zero && pos < size)
+		out[pos++] = '-';
+	while (n && pos < size)
+		out[pos++] = tmp[--n];
+	if (left) {
+		for (; len < width && pos < size; width--)
+			out[pos++] = ' ';
+	}
+	return pos;
+}
+
+/**
+ * Handle a complete log record.
+ */
+static void _expand_record(struct _binlog *bl)
+{
+	char line[BINLOG_LINE_SIZE];
+	uint32_t args[BINLOG_MAX_ARGS];
+	uint16_t id = bl->frame[0] | (bl->frame[1] << 8);
+	uint32_t argc = bl->frame[2];
+	uint32_t i, len;
+
+	for (i = 0; i < argc; i++)
+		args[i] = _get_u32(&bl->frame[BINLOG_HEADER_SIZE + 4 * i]);
+
+	if (id < BINLOG_MAX_FORMATS && bl->formats[id]) {
+		len = binlog_format(line, sizeof(line), bl->formats[id], args, argc);
+		bl->records++;
+	} else {
+		/* no format: keep the raw record visible */
+		len = binlog_format(line, sizeof(line), "<fmt %u>", (uint32_t[]){ id }, 1);
+		for (i = 0; i < argc; i++)
+			len += binlog_format(&line[len], sizeof(line) - len, " %08x",
+					     &args[i], 1);
+		bl->unknown++;
+	}
+	bl->line(bl->arg, line, len);
+}
+
+/**
+ * Get the pool slot holding the text of a format, NULL for a build time
+ * format or none.
+ */
+static uint8_t* _pool_slot(struct _binlog *bl, const char *text)
+{
+	if (text < bl->pool || text >= &bl->pool[BINLOG_POOL_SIZE])
+		return NULL;
+	return (uint8_t *)text - BINLOG_SLOT_HEADER;
+}
+
+/**
+ * Squeeze the slots which no ID refers to out of the pool.
+ */
+static void _compact_pool(struct _binlog *bl)
+{
+	uint32_t from = 0, to = 0, len;
+	uint8_t *slot;
+
+	while (from < bl->pool_used) {
+		slot = (uint8_t *)&bl->pool[from];
+		len = BINLOG_SLOT_HEADER + slot[1] + 1;
+		if (bl->formats[slot[0]] == &bl->pool[from + BINLOG_SLOT_HEADER]) {
+			memmove(&bl->pool[to], slot, len);
+			bl->formats[slot[0]] = &bl->pool[to + BINLOG_SLOT_HEADER];
+			to += len;
+		}
+		from += len;
+	}
+	bl->pool_used = to;
+}
+
+/**
+ * Handle a complete format definition.
+ */
+static void _define_format(struct _binlog *bl)
+{
+	uint16_t id = bl->frame[0] | (bl->frame[1] << 8);
+	uint32_t len = bl->frame[2];
+	uint8_t *slot;
+	char *text;
+
+	if (id >= BINLOG_MAX_FORMATS) {
+		bl->errors++;
+		return;
+	}
+
+	/* the previous text of the ID makes room for the new one */
+	slot = _pool_slot(bl, bl->formats[id]);
+	if (slot == NULL || len > slot[1]) {
+		if (bl->pool_used + BINLOG_SLOT_HEADER + len + 1 > BINLOG_POOL_SIZE)
+			_compact_pool(bl);
+		if (bl->pool_used + BINLOG_SLOT_HEADER + len + 1 > BINLOG_POOL_SIZE) {
+			bl->errors++;
+			return;
+		}
+		slot = (uint8_t *)&bl->pool[bl->pool_used];
+		slot[0] = id;
+		slot[1] = len;
+		bl->pool_used += BINLOG_SLOT_HEADER + len + 1;
+	}
+
+	text = (char *)&slot[BINLOG_SLOT_HEADER];
+	memcpy(text, &bl->frame[BINLOG_HEADER_SIZE], len);
+	text[len] = 0;
+	bl->formats[id] = text;
+	bl->defined++;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a decoder with the build time formats.
+ *
+ * \param bl    Decoder instance.
+ * \param text  Called with the runs of bytes outside frames.
+ * \param line  Called with every expanded record.
+ * \param arg   Argument passed to the callbacks.
+ */
+void binlog_init(struct _binlog *bl, binlog_text_t text, binlog_line_t line,
+		 void *arg)
+{
+	memset(bl, 0, sizeof(*bl));
+	bl->text = text;
+	bl->line = line;
+	bl->arg = arg;
+	binlog_add_formats(bl, binlog_builtin_formats, binlog_builtin_format_count);
+}
+
+/**
+ * \brief Register formats, replacing entries with the same IDs.
+ */
+void binlog_add_formats(struct _binlog *bl, const struct _binlog_format *formats,
+			uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		if (formats[i].id < BINLOG_MAX_FORMATS)
+			bl->formats[formats[i].id] = formats[i].text;
+	}
+}
+
+/**
+ * \brief Feed a segment of the receive stream.
+ *
+ * Text outside frames is handed on in place, without copying.
+ */
+void binlog_feed(struct _binlog *bl, const uint8_t *data, uint32_t len)
+{
+	const uint8_t *text = data;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		switch (bl->state) {
+		case BINLOG_STATE_TEXT:
+			if (c == BINLOG_STX) {
+				if (&data[i] > text)
+					bl->text(bl->arg, text, &data[i] - text);
+				bl->state = BINLOG_STATE_TYPE;
+			}
+			continue;
+
+		case BINLOG_STATE_TYPE:
+			if (c == BINLOG_TYPE_LOG || c == BINLOG_TYPE_FORMAT) {
+				bl->type = c;
+				bl->sum = c;
+				bl->pos = 0;
+				bl->need = BINLOG_HEADER_SIZE;
+				bl->state = BINLOG_STATE_BODY;
+			} else {
+				/* not a frame, give the STX back to the text
+				 * path */
+				static const uint8_t stx = BINLOG_STX;
+
+				bl->errors++;
+				bl->text(bl->arg, &stx, 1);
+				/* a second STX may start a frame itself,
+				 * other text goes on from this byte */
+				if (c != BINLOG_STX) {
+					bl->state = BINLOG_STATE_TEXT;
+					text = &data[i];
+				}
+			}
+			continue;
+
+		case BINLOG_STATE_BODY:
+			bl->frame[bl->pos++] = c;
+			bl->sum ^= c;
+			if (bl->pos == BINLOG_HEADER_SIZE) {
+				if (bl->type == BINLOG_TYPE_LOG) {
+					if (bl->frame[2] > BINLOG_MAX_ARGS) {
+						/* arguments and sum are not text */
+						bl->errors++;
+						bl->need = 4 * bl->frame[2] + 1;
+						bl->state = BINLOG_STATE_SKIP;
+						continue;
+					}
+					bl->need += 4 * bl->frame[2];
+				} else {
+					bl->need += bl->frame[2];
+				}
+			}
+			if (bl->pos == bl->need)
+				bl->state = BINLOG_STATE_SUM;
+			continue;
+
+		case BINLOG_STATE_SUM:
+			bl->state = BINLOG_STATE_TEXT;
+			text = &data[i + 1];
+			if (c != bl->sum)
+				bl->errors++;
+			else if (bl->type == BINLOG_TYPE_LOG)
+				_expand_record(bl);
+			else
+				_define_format(bl);
+			continue;
+
+		case BINLOG_STATE_SKIP:
+			if (--bl->need == 0) {
+				bl->state = BINLOG_STATE_TEXT;
+				text = &data[i + 1];
+			}
+			continue;
+		}
+	}
+
+	if (bl->state == BINLOG_STATE_TEXT && &data[len] > text)
+		bl->text(bl->arg, text, &data[len] - text);
+}
+
+/**
+ * \brief Expand a format string with 32-bit arguments.
+ *
+ * \param out   Destination, not NUL terminated.
+ * \param size  Destination size.
+ * \param fmt   Format string.
+ * \param args  Argument words.
+ * \param argc  Number of argument words, missing ones print as '?'.
+ *
+ * \return Number of characters written.
+ */
+uint32_t binlog_format(char *out, uint32_t size, const char *fmt,
+		       const uint32_t *args, uint32_t argc)
+{
+	uint32_t pos = 0, arg = 0;
+
+	while (*fmt && pos < size) {
+		uint32_t width = 0, value;
+		bool left = false, zero = false;
+
+		if (*fmt != '%') {
+			out[pos++] = *fmt++;
+			continue;
+		}
+		fmt++;
+
+		for (;; fmt++) {
+			if (*fmt == '-')
+				left = true;
+			else if (*fmt == '0')
+				zero = true;
+			else
+				break;
+		}
+		while (*fmt >= '0' && *fmt <= '9')
+			width = width * 10 + (*fmt++ - '0');
+		while (*fmt == 'l' || *fmt == 'h')
+			fmt++;
+
+		if (*fmt == 0)
+			break;
+		if (*fmt == '%') {
+			out[pos++] = *fmt++;
+			continue;
+		}
+		if (arg >= argc) {
+			out[pos++] = '?';
+			fmt++;
+			continue;
+		}
+
+		value = args[arg++];
+		switch (*fmt++) {
+		case 'd':
+		case 'i':
+			if ((int32_t)value < 0)
+				pos = _put_number(out, pos, size, -value, true, 10,
+						  false, width, left, zero);
+			else
+				pos = _put_number(out, pos, size, value, false, 10,
+						  false, width, left, zero);
+			break;
+		case 'u':
+			pos = _put_number(out, pos, size, value, false, 10, false,
+					  width, left, zero);
+			break;
+		case 'x':
+			pos = _put_number(out, pos, size, value, false, 16, false,
+					  width, left, zero);
+			break;
+		case 'X':
+			pos = _put_number(out, pos, size, value, false, 16, true,
+					  width, left, zero);
+			break;
+		case 'p':
+			if (pos + 2 <= size) {
+				out[pos++] = '0';
+				out[pos++] = 'x';
+			}
+			pos = _put_number(out, pos, size, value, false, 16, false,
+					  8, false, true);
+			break;
+		case 'c':
+			/* a control character would end or cut the line */
+			out[pos++] = value >= 0x20 && value < 0x7F ? value : '.';
+			break;
+		default:
+			/* strings and floats cannot travel as a raw word */
+			out[pos++] = '?';
+			break;
+		}
+	}
+	return pos;
+}
@@ -0,0 +1,122 @@
+/**
+ * \file
+ *
+ * Decoder for binary deferred-format log records.
+ *
+ * Targets send a format ID and raw argument words instead of formatted
+ * text; the console expands them locally with a format table. Records are
+ * framed inside the normal text stream, every byte outside a frame is
+ * passed through unchanged:
+ *
+ *   STX 'L' id(u16) argc(u8) arg0(u32) .. argc-1(u32) sum    log record
+ *   STX 'F' id(u16) len(u8) text[len] sum                    format definition
+ *
+ * Multi-byte fields are little-endian, sum is the XOR of all bytes between
+ * STX and sum. Formats are registered at build time (binlog_formats.c) or
+ * received as 'F' frames over the same link, which then replace the build
+ * time entry of the same ID.
+ *
+ * Received formats live in a pool as id(u8) size(u8) text[size + 1]. A
+ * redefinition which fits the slot of the previous text of its ID reuses
+ * it, so a device which announces its formats again on every reconnect
+ * takes no more space. A longer one gets a new slot; when the pool is
+ * full, the slots no ID refers to any more are squeezed out first.
+ *
+ * A log record with more than BINLOG_MAX_ARGS arguments is skipped to its
+ * end, its bytes do not reach the text path.
+ *
+ * Supported conversions: %d %i %u %x %X %c %p %%, with '-' and '0' flags
+ * and a field width. Length modifiers are accepted and ignored, arguments
+ * are 32-bit. %c prints characters outside printable ASCII as '.'.
+ */
+
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define BINLOG_STX              0x02
+#define BINLOG_TYPE_LOG         'L'
+#define BINLOG_TYPE_FORMAT      'F'
+
+/** Number of format IDs, IDs are direct indexes into the format table and
+ * fit the id byte of a pool slot */
+#define BINLOG_MAX_FORMATS      256
+/** Most arguments in a record */
+#define BINLOG_MAX_ARGS         8
+/** Storage for formats received over the link */
+#define BINLOG_POOL_SIZE        4096
+/** Longest expanded record */
+#define BINLOG_LINE_SIZE        128
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _binlog_format {
+	uint16_t id;
+	const char *text;
+};
+
+/** Run of bytes outside frames, passed in place */
+typedef void (*binlog_text_t)(void *arg, const uint8_t *data, uint32_t len);
+/** Expanded record, without line terminator */
+typedef void (*binlog_line_t)(void *arg, const char *line, uint32_t len);
+
+struct _binlog {
+	binlog_text_t text;
+	binlog_line_t line;
+	void *arg;
+
+	const char *formats[BINLOG_MAX_FORMATS];
+	char pool[BINLOG_POOL_SIZE];
+	uint32_t pool_used;
+
+	/* frame being received */
+	uint8_t state;
+	uint8_t type;
+	uint8_t sum;
+	uint16_t need;
+	uint16_t pos;
+	uint8_t frame[3 + 255];
+
+	/* statistics */
+	uint32_t records;       /* records expanded */
+	uint32_t defined;       /* formats received over the link */
+	uint32_t errors;        /* bad checksum, type or size, pool full */
+	uint32_t unknown;       /* records with no format */
+};
+
+/*----------------------------------------------------------------------------
+ *        Variables
+ *----------------------------------------------------------------------------*/
+
+/** Build time format table, see binlog_formats.c */
+extern const struct _binlog_format binlog_builtin_formats[];
+extern const uint32_t binlog_builtin_format_count;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void binlog_init(struct _binlog *bl, binlog_text_t text,
+			binlog_line_t line, void *arg);
+
+extern void binlog_add_formats(struct _binlog *bl,
+			       const struct _binlog_format *formats,
+			       uint32_t count);
+
+extern void binlog_feed(struct _binlog *bl, const uint8_t *data, uint32_t len);
+
+extern uint32_t binlog_format(char *out, uint32_t size, const char *fmt,
+			      const uint32_t *args, uint32_t argc);
+
+#endif /* _BINLOG_H_ */
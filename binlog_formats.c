@@ -0,0 +1,24 @@
+/**
+ * \file
+ *
+ * Build time format table of the binary log decoder.
+ *
+ * Keep the IDs in sync with the table the targets are built with. Entries
+ * can be replaced at run time by 'F' frames, see binlog.h.
+ */
+
+#include "binlog.h"
+
+const struct _binlog_format binlog_builtin_formats[] = {
+	{ 1,  "boot: reset cause 0x%02x, rev %u" },
+	{ 2,  "clk: PLLA %u MHz, MCK %u MHz" },
+	{ 3,  "net: eth%u link up %u Mbps" },
+	{ 4,  "WARN: sensor %u timeout, retry %u" },
+	{ 5,  "ERROR: sensor %u not responding" },
+	{ 6,  "adc: ch%u = %d mV" },
+	{ 7,  "irq: %u spurious, last source %u" },
+	{ 8,  "assert: %p line %u" },
+};
+
+const uint32_t binlog_builtin_format_count =
+	sizeof(binlog_builtin_formats) / sizeof(binlog_builtin_formats[0]);
@@ -0,0 +1,275 @@
+/**
+ * \file
+ *
+ * Record and replay of UART receive streams, see capture.h for the format.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "capture.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Encode a varint delay followed by the data byte.
+ *
+ * \return Record length in bytes.
+ */
+static uint32_t _encode_record(uint8_t *rec, uint32_t delay, uint8_t data)
+{
+	uint32_t n = 0;
+
+	while (delay >= 0x80) {
+		rec[n++] = (delay & 0x7F) | 0x80;
+		delay >>= 7;
+	}
+	rec[n++] = delay;
+	rec[n++] = data;
+	return n;
+}
+
+/**
+ * \brief Drop the oldest record of the ring.
+ */
+static void _drop_oldest(struct _capture *cap)
+{
+	uint32_t n = 0;
+
+	/* varint bytes have bit 7 set except the last one */
+	while (cap->buffer[(cap->tail + n) % cap->size] & 0x80)
+		n++;
+	n += 2;
+
+	cap->tail = (cap->tail + n) % cap->size;
+	cap->used -= n;
+	cap->records--;
+	cap->evicted++;
+}
+
+/**
+ * \brief Decode the record at the replay position.
+ *
+ * The delay of the very first record is ignored: it is relative to a byte
+ * which is not part of the blob.
+ */
+static void _replay_fetch(struct _replay *rp)
+{
+	uint32_t delay = 0;
+	uint32_t shift = 0;
+
+	rp->has_next = false;
+	while (rp->pos < rp->size) {
+		uint8_t b = rp->data[rp->pos++];
+
+		if (shift < 32)
+			delay |= (uint32_t)(b & 0x7F) << shift;
+		shift += 7;
+		if ((b & 0x80) == 0) {
+			if (rp->pos >= rp->size)
+				return;	/* truncated record */
+			rp->next = rp->data[rp->pos++];
+			if (rp->bytes > 0)
+				rp->due_us += delay;
+			rp->has_next = true;
+			return;
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a capture ring on the given memory.
+ *
+ * \param cap     Capture instance.
+ * \param buffer  Ring memory.
+ * \param size    Ring size in bytes.
+ * \param freq    Frequency of the counter given to capture_record(), in Hz.
+ */
+void capture_init(struct _capture *cap, uint8_t *buffer, uint32_t size,
+		  uint32_t freq)
+{
+	assert(freq >= 16);
+
+	memset(cap, 0, sizeof(*cap));
+	cap->buffer = buffer;
+	cap->size = size;
+	cap->us_scale = (uint32_t)(((uint64_t)1000000 << 16) / freq);
+}
+
+/**
+ * \brief Empty the ring and start recording.
+ */
+void capture_start(struct _capture *cap)
+{
+	cap->head = 0;
+	cap->tail = 0;
+	cap->used = 0;
+	cap->records = 0;
+	cap->evicted = 0;
+	cap->frac = 0;
+	cap->first = true;
+	cap->running = true;
+}
+
+/**
+ * \brief Stop recording, the ring content is kept.
+ */
+void capture_stop(struct _capture *cap)
+{
+	cap->running = false;
+}
+
+/**
+ * \brief Record one received byte. Safe to call from the receive interrupt.
+ *
+ * \param cap     Capture instance.
+ * \param data    Received byte.
+ * \param raw     Arrival time, counter value (free running, may wrap once
+ *                between two bytes).
+ */
+void capture_record(struct _capture *cap, uint8_t data, uint32_t raw)
+{
+	uint8_t rec[CAPTURE_MAX_RECORD_SIZE];
+	uint32_t delay, n, i;
+
+	if (!cap->running)
+		return;
+
+	if (cap->first) {
+		delay = 0;
+	} else {
+		uint64_t us = (uint64_t)(raw - cap->last_raw) * cap->us_scale +
+			      cap->frac;
+
+		cap->frac = us & 0xFFFF;
+		us >>= 16;
+		delay = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+	}
+	cap->last_raw = raw;
+	cap->first = false;
+
+	n = _encode_record(rec, delay, data);
+	if (n > cap->size)
+		return;
+
+	while (cap->size - cap->used < n)
+		_drop_oldest(cap);
+
+	for (i = 0; i < n; i++) {
+		cap->buffer[cap->head] = rec[i];
+		if (++cap->head >= cap->size)
+			cap->head = 0;
+	}
+	cap->used += n;
+	cap->records++;
+}
+
+/**
+ * \brief Copy the ring into a standalone blob suitable for replay_start().
+ *
+ * \param cap   Capture instance.
+ * \param out   Destination buffer.
+ * \param size  Destination size in bytes.
+ *
+ * \return Blob length in bytes, 0 if \a out is too small.
+ */
+uint32_t capture_export(const struct _capture *cap, uint8_t *out, uint32_t size)
+{
+	uint32_t first;
+
+	if (size < CAPTURE_HEADER_SIZE + cap->used)
+		return 0;
+
+	out[0] = CAPTURE_MAGIC0;
+	out[1] = CAPTURE_MAGIC1;
+	out[2] = CAPTURE_MAGIC2;
+	out[3] = CAPTURE_MAGIC3;
+	out[4] = CAPTURE_VERSION;
+	out[5] = out[6] = out[7] = 0;
+	out += CAPTURE_HEADER_SIZE;
+
+	first = cap->size - cap->tail;
+	if (first >= cap->used) {
+		memcpy(out, &cap->buffer[cap->tail], cap->used);
+	} else {
+		memcpy(out, &cap->buffer[cap->tail], first);
+		memcpy(&out[first], cap->buffer, cap->used - first);
+	}
+	return CAPTURE_HEADER_SIZE + cap->used;
+}
+
+/**
+ * \brief Prepare a replay of a capture blob.
+ *
+ * \param rp      Replay instance.
+ * \param blob    Blob produced by capture_export().
+ * \param size    Blob length in bytes.
+ * \param speed   1 for real time, N for N times faster, REPLAY_SPEED_MAX
+ *                to deliver bytes as fast as they are requested.
+ * \param now_us  Current time in microseconds.
+ *
+ * \return 0 on success, -1 if the blob header is not recognized.
+ */
+int replay_start(struct _replay *rp, const uint8_t *blob, uint32_t size,
+		 uint32_t speed, uint32_t now_us)
+{
+	memset(rp, 0, sizeof(*rp));
+
+	if (size < CAPTURE_HEADER_SIZE ||
+	    blob[0] != CAPTURE_MAGIC0 || blob[1] != CAPTURE_MAGIC1 ||
+	    blob[2] != CAPTURE_MAGIC2 || blob[3] != CAPTURE_MAGIC3 ||
+	    blob[4] != CAPTURE_VERSION)
+		return -1;
+
+	rp->data = blob + CAPTURE_HEADER_SIZE;
+	rp->size = size - CAPTURE_HEADER_SIZE;
+	rp->speed = speed;
+	rp->start_us = now_us;
+	_replay_fetch(rp);
+	return 0;
+}
+
+/**
+ * \brief Get the next byte if it is due.
+ *
+ * \param rp      Replay instance.
+ * \param now_us  Current time in microseconds.
+ * \param data    Returned byte.
+ *
+ * \return true if a byte was returned, false if none is due yet or the
+ *         replay is finished.
+ */
+bool replay_next(struct _replay *rp, uint32_t now_us, uint8_t *data)
+{
+	if (!rp->has_next)
+		return false;
+
+	if (rp->speed != REPLAY_SPEED_MAX) {
+		uint64_t elapsed = (uint64_t)(now_us - rp->start_us) * rp->speed;
+		if (elapsed < rp->due_us)
+			return false;
+	}
+
+	*data = rp->next;
+	rp->bytes++;
+	_replay_fetch(rp);
+	return true;
+}
+
+/**
+ * \brief Check whether all records were delivered.
+ */
+bool replay_done(const struct _replay *rp)
+{
+	return !rp->has_next;
+}
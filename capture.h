@@ -0,0 +1,120 @@
+/**
+ * \file
+ *
+ * Record and replay of UART receive streams.
+ *
+ * A capture stream is a sequence of records, one per received byte:
+ *
+ *   [delay varint][data byte]
+ *
+ * The delay is the time since the previous byte in microseconds, encoded
+ * as a little-endian base-128 varint (7 bits per byte, bit 7 set when more
+ * bytes follow). At 115200 baud back-to-back bytes are 87 us apart, so a
+ * busy stream costs two bytes per received byte.
+ *
+ * The recorder writes records into a RAM ring and overwrites the oldest
+ * records when it runs out of space. capture_export() turns the ring into a
+ * standalone blob (header + records) that can be dumped, stored, linked into
+ * a firmware image and fed back with the replayer.
+ *
+ * The recorder is given raw values of a free running counter and converts
+ * the delays to microseconds with a 16.16 fixed point factor, keeping the
+ * fraction for the next delay: the receive interrupt pays a multiply per
+ * byte and never a divide, and rounding does not add up over a burst.
+ *
+ * Neither side touches the hardware: the caller provides the time base, so
+ * both compile unchanged for the target and for a host build, see
+ * host/replay.c.
+ */
+
+#ifndef _CAPTURE_H_
+#define _CAPTURE_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Blob header: "UCAP", format version, 3 reserved bytes */
+#define CAPTURE_MAGIC0          'U'
+#define CAPTURE_MAGIC1          'C'
+#define CAPTURE_MAGIC2          'A'
+#define CAPTURE_MAGIC3          'P'
+#define CAPTURE_VERSION         1
+#define CAPTURE_HEADER_SIZE     8
+
+/** Largest record: 5 bytes of varint delay + 1 data byte */
+#define CAPTURE_MAX_RECORD_SIZE 6
+
+/** Replay speed value meaning "as fast as the input path accepts" */
+#define REPLAY_SPEED_MAX        0
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _capture {
+	uint8_t *buffer;    /* record ring */
+	uint32_t size;      /* ring size in bytes */
+	uint32_t head;      /* next write index */
+	uint32_t tail;      /* index of the oldest record */
+	uint32_t used;      /* bytes held in the ring */
+	uint32_t us_scale;  /* microseconds per counter tick, 16.16 */
+	uint32_t last_raw;  /* counter value of the previous byte */
+	uint32_t frac;      /* fraction of a microsecond left over, 0.16 */
+	uint32_t records;   /* records held in the ring */
+	uint32_t evicted;   /* records overwritten since capture_start() */
+	bool running;
+	bool first;         /* next record is the first one since start */
+};
+
+struct _replay {
+	const uint8_t *data; /* records, header stripped */
+	uint32_t size;
+	uint32_t pos;
+	uint32_t speed;      /* 1 = real time, N = N times faster, 0 = max */
+	uint32_t start_us;   /* replay clock origin */
+	uint64_t due_us;     /* capture time of the next record */
+	uint32_t bytes;      /* bytes delivered so far */
+	bool has_next;
+	uint8_t next;        /* decoded data byte of the pending record */
+};
+
+/*----------------------------------------------------------------------------
+ *        Variables
+ *----------------------------------------------------------------------------*/
+
+/** Capture blob linked into the image, see replay_data.c */
+extern const uint8_t replay_data[];
+extern const uint32_t replay_data_size;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void capture_init(struct _capture *cap, uint8_t *buffer, uint32_t size,
+			 uint32_t freq);
+
+extern void capture_start(struct _capture *cap);
+
+extern void capture_stop(struct _capture *cap);
+
+extern void capture_record(struct _capture *cap, uint8_t data, uint32_t raw);
+
+extern uint32_t capture_export(const struct _capture *cap, uint8_t *out,
+			       uint32_t size);
+
+extern int replay_start(struct _replay *rp, const uint8_t *blob, uint32_t size,
+			uint32_t speed, uint32_t now_us);
+
+extern bool replay_next(struct _replay *rp, uint32_t now_us, uint8_t *data);
+
+extern bool replay_done(const struct _replay *rp);
+
+#endif /* _CAPTURE_H_ */
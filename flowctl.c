@@ -0,0 +1,80 @@
+/**
+ * \file
+ *
+ * Watermark based receive flow control, see flowctl.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "flowctl.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize flow control and release the handshake line.
+ *
+ * \param fc       Flow control instance.
+ * \param high     Ring level at which the sender is stopped.
+ * \param low      Ring level at which the sender is released.
+ * \param set_rts  Handshake line driver.
+ * \param clock    Time source of the statistics.
+ * \param arg      Argument passed to \a set_rts.
+ */
+void flowctl_init(struct _flowctl *fc, uint32_t high, uint32_t low,
+		  flowctl_rts_t set_rts, flowctl_clock_t clock, void *arg)
+{
+	assert(low < high);
+
+	memset(fc, 0, sizeof(*fc));
+	fc->high = high;
+	fc->low = low;
+	fc->set_rts = set_rts;
+	fc->clock = clock;
+	fc->arg = arg;
+	fc->set_rts(fc->arg, false);
+}
+
+/**
+ * \brief Producer side, called after a byte was stored.
+ *
+ * \param fc      Flow control instance.
+ * \param level   Ring level after the store.
+ */
+void flowctl_on_fill(struct _flowctl *fc, uint32_t level)
+{
+	if (fc->stopped || level < fc->high)
+		return;
+
+	fc->set_rts(fc->arg, true);
+	fc->since_us = fc->clock();
+	fc->events++;
+	fc->stopped = true;
+}
+
+/**
+ * \brief Consumer side, called after bytes were drained.
+ *
+ * \param fc      Flow control instance.
+ * \param level   Ring level after draining.
+ */
+void flowctl_on_drain(struct _flowctl *fc, uint32_t level)
+{
+	uint32_t duration;
+
+	if (!fc->stopped || level > fc->low)
+		return;
+
+	duration = fc->clock() - fc->since_us;
+	fc->total_us += duration;
+	if (duration > fc->max_us)
+		fc->max_us = duration;
+	fc->stopped = false;
+	fc->set_rts(fc->arg, false);
+}
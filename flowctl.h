@@ -0,0 +1,64 @@
+/**
+ * \file
+ *
+ * Watermark based receive flow control.
+ *
+ * The producer side reports the receive ring level after each stored byte
+ * and asserts backpressure (RTS high, "stop sending") when the level reaches
+ * the high watermark. The consumer side reports the level after draining
+ * and releases backpressure once it has fallen to the low watermark. The
+ * gap between the watermarks keeps RTS from toggling on every byte.
+ *
+ * The pin is driven and the time is read through callbacks, so the state
+ * machine can be run against a host model of the link as well as the
+ * USART. The time is only read when backpressure is applied or released,
+ * the receive interrupt pays a compare per byte.
+ */
+
+#ifndef _FLOWCTL_H_
+#define _FLOWCTL_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Drive the handshake line, \a stop true asks the sender to pause */
+typedef void (*flowctl_rts_t)(void *arg, bool stop);
+
+/** Current time in microseconds, free running */
+typedef uint32_t (*flowctl_clock_t)(void);
+
+struct _flowctl {
+	uint32_t high;          /* stop at or above this level */
+	uint32_t low;           /* release at or below this level */
+	flowctl_rts_t set_rts;
+	flowctl_clock_t clock;
+	void *arg;
+	volatile bool stopped;
+	uint32_t since_us;      /* time backpressure was applied */
+
+	/* statistics */
+	uint32_t events;        /* times backpressure was applied */
+	uint64_t total_us;      /* accumulated backpressure time */
+	uint32_t max_us;        /* longest backpressure period */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void flowctl_init(struct _flowctl *fc, uint32_t high, uint32_t low,
+			 flowctl_rts_t set_rts, flowctl_clock_t clock, void *arg);
+
+extern void flowctl_on_fill(struct _flowctl *fc, uint32_t level);
+
+extern void flowctl_on_drain(struct _flowctl *fc, uint32_t level);
+
+#endif /* _FLOWCTL_H_ */
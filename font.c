@@ -549,6 +549,98 @@ const uint8_t pCharset6x8[] =
 0x00,0x7F,0x7F,0x7F,0x7F,0x7F  // Symbol 7F
 };
 
+/*----------------------------------------------------------------------------
+ *        Glyphs outside ASCII, drawn for the 10x14 cell
+ *----------------------------------------------------------------------------*/
+
+const struct _font_ext_glyph font_ext10x14[NB_FONT_EXT] = {
+	/* U+00B0 degree sign */
+	{ 0x00B0, {
+		0x3C00, 0x6600, 0x6600, 0x3C00, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+00B1 plus-minus sign */
+	{ 0x00B1, {
+		0x0000, 0x0000, 0x0C00, 0x0C00, 0x0C00, 0xFFC0, 0xFFC0,
+		0x0C00, 0x0C00, 0x0C00, 0x0000, 0xFFC0, 0xFFC0, 0x0000,
+	} },
+	/* U+00B2 superscript two */
+	{ 0x00B2, {
+		0x3C00, 0x6600, 0x0600, 0x0C00, 0x1800, 0x3000, 0x7E00,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+00B3 superscript three */
+	{ 0x00B3, {
+		0x3C00, 0x6600, 0x0600, 0x1C00, 0x0600, 0x6600, 0x3C00,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+00B5 micro sign */
+	{ 0x00B5, {
+		0x0000, 0x0000, 0xC0C0, 0xC0C0, 0xC0C0, 0xC0C0, 0xC0C0,
+		0xC0C0, 0xC0C0, 0xE1C0, 0xFFC0, 0xDEC0, 0xC000, 0xC000,
+	} },
+	/* U+00D7 multiplication sign */
+	{ 0x00D7, {
+		0x0000, 0x0000, 0x0000, 0xC0C0, 0xE1C0, 0x7380, 0x3F00,
+		0x1E00, 0x3F00, 0x7380, 0xE1C0, 0xC0C0, 0x0000, 0x0000,
+	} },
+	/* U+00F7 division sign */
+	{ 0x00F7, {
+		0x0000, 0x0000, 0x0C00, 0x0C00, 0x0000, 0x0000, 0xFFC0,
+		0xFFC0, 0x0000, 0x0000, 0x0C00, 0x0C00, 0x0000, 0x0000,
+	} },
+	/* U+00E4 latin small letter a with diaeresis */
+	{ 0x00E4, {
+		0x0000, 0x3300, 0x3300, 0x0000, 0x3F00, 0x7F80, 0x00C0,
+		0x3FC0, 0x7FC0, 0xC0C0, 0xC0C0, 0xE1C0, 0x7FC0, 0x3EC0,
+	} },
+	/* U+00F6 latin small letter o with diaeresis */
+	{ 0x00F6, {
+		0x0000, 0x3300, 0x3300, 0x0000, 0x3F00, 0x7F80, 0xE1C0,
+		0xC0C0, 0xC0C0, 0xC0C0, 0xC0C0, 0xE1C0, 0x7F80, 0x3F00,
+	} },
+	/* U+00FC latin small letter u with diaeresis */
+	{ 0x00FC, {
+		0x0000, 0x3300, 0x3300, 0x0000, 0xC0C0, 0xC0C0, 0xC0C0,
+		0xC0C0, 0xC0C0, 0xC0C0, 0xC0C0, 0xE1C0, 0x7F80, 0x3F00,
+	} },
+	/* U+00E9 latin small letter e with acute */
+	{ 0x00E9, {
+		0x0600, 0x0C00, 0x1800, 0x0000, 0x3F00, 0x7F80, 0xE1C0,
+		0xC0C0, 0xFFC0, 0xFFC0, 0xC000, 0xE000, 0x7F80, 0x3F80,
+	} },
+	/* U+03A9 greek capital letter omega */
+	{ 0x03A9, {
+		0x3F00, 0x7F80, 0xE1C0, 0xC0C0, 0xC0C0, 0xC0C0, 0xC0C0,
+		0xC0C0, 0xE1C0, 0x7380, 0x3300, 0x3300, 0xF3C0, 0xF3C0,
+	} },
+	/* U+2022 bullet */
+	{ 0x2022, {
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x1E00, 0x3F00,
+		0x3F00, 0x3F00, 0x1E00, 0x0000, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+2026 horizontal ellipsis */
+	{ 0x2026, {
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000,
+		0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0xCCC0, 0xCCC0,
+	} },
+	/* U+2190 leftwards arrow */
+	{ 0x2190, {
+		0x0000, 0x0000, 0x0000, 0x1800, 0x3000, 0x6000, 0xFFC0,
+		0xFFC0, 0x6000, 0x3000, 0x1800, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+2192 rightwards arrow */
+	{ 0x2192, {
+		0x0000, 0x0000, 0x0000, 0x0600, 0x0300, 0x0180, 0xFFC0,
+		0xFFC0, 0x0180, 0x0300, 0x0600, 0x0000, 0x0000, 0x0000,
+	} },
+	/* U+20AC euro sign */
+	{ 0x20AC, {
+		0x1F80, 0x3FC0, 0x7000, 0x6000, 0xFC00, 0xFC00, 0x6000,
+		0x6000, 0xFC00, 0xFC00, 0x6000, 0x7000, 0x3FC0, 0x1F80,
+	} },
+};
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
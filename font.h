@@ -59,6 +59,17 @@ struct _font_parameters
 #define NB_FONT 4
 extern struct _font_parameters font_param[NB_FONT];
 
+/** Glyph of a character outside ASCII, in the 10x14 cell: bit 15 of a row
+ * is the leftmost pixel. Other fonts scale it to their cell. */
+struct _font_ext_glyph
+{
+    uint16_t codepoint;  /* Unicode, BMP */
+    uint16_t rows[14];
+} ;
+
+#define NB_FONT_EXT 17
+extern const struct _font_ext_glyph font_ext10x14[NB_FONT_EXT];
+
 extern const uint8_t pCharset10x14[];
 extern const uint8_t pCharset10x8[];
 extern const uint8_t pCharset8x8[];
@@ -0,0 +1,269 @@
+/**
+ * \file
+ *
+ * Decoder of link level frames, see framing.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "framing.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+enum {
+	FRAMING_STATE_TEXT = 0, /* outside a frame */
+	FRAMING_STATE_FRAME,    /* SLIP or COBS payload */
+	FRAMING_STATE_ESCAPE,   /* SLIP ESC received */
+	FRAMING_STATE_DISCARD,  /* bad SLIP or COBS frame, up to its end */
+	FRAMING_STATE_LEN0,     /* SOH received */
+	FRAMING_STATE_LEN1,
+	FRAMING_STATE_DATA,     /* length-prefixed payload */
+	FRAMING_STATE_SKIP,     /* length-prefixed payload too long */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static bool _is_text(const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if ((c < 0x20 && c != '\t' && c != '\r' && c != '\n') || c == 0x7F)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Hand on a complete payload.
+ */
+static void _deliver(struct _framing *f)
+{
+	if (f->len == 0)
+		return;
+
+	if (_is_text(f->buffer, f->len)) {
+		/* a text frame is a line, the buffer has room for the end */
+		if (f->buffer[f->len - 1] != '\n')
+			f->buffer[f->len++] = '\n';
+		f->lines++;
+		f->text(f->arg, f->buffer, f->len);
+	} else {
+		f->frames++;
+		f->frame(f->arg, f->buffer, f->len);
+	}
+}
+
+/**
+ * Append a decoded byte to the payload, drop the frame if it is too long.
+ */
+static void _put(struct _framing *f, uint8_t c)
+{
+	if (f->len == FRAMING_MAX_FRAME) {
+		f->errors++;
+		f->state = FRAMING_STATE_DISCARD;
+		return;
+	}
+	f->buffer[f->len++] = c;
+}
+
+static void _start(struct _framing *f, uint8_t state)
+{
+	f->state = state;
+	f->len = 0;
+	f->code = 0xFF;         /* no zero before the first COBS block */
+	f->left = 0;
+}
+
+/**
+ * Handle a byte inside a SLIP frame.
+ *
+ * \return true at the end of the frame.
+ */
+static bool _slip(struct _framing *f, uint8_t c)
+{
+	if (f->state == FRAMING_STATE_ESCAPE) {
+		f->state = FRAMING_STATE_FRAME;
+		if (c == FRAMING_SLIP_ESC_END) {
+			_put(f, FRAMING_SLIP_END);
+		} else if (c == FRAMING_SLIP_ESC_ESC) {
+			_put(f, FRAMING_SLIP_ESC);
+		} else {
+			f->errors++;
+			f->state = FRAMING_STATE_DISCARD;
+		}
+		return false;
+	}
+
+	if (c == FRAMING_SLIP_END) {
+		if (f->state == FRAMING_STATE_FRAME && f->len == 0)
+			return false;   /* leading END */
+		if (f->state == FRAMING_STATE_FRAME)
+			_deliver(f);
+		return true;
+	}
+	if (f->state == FRAMING_STATE_FRAME) {
+		if (c == FRAMING_SLIP_ESC)
+			f->state = FRAMING_STATE_ESCAPE;
+		else
+			_put(f, c);
+	}
+	return false;
+}
+
+/**
+ * Handle a byte inside a COBS frame.
+ *
+ * \return true at the end of the frame.
+ */
+static bool _cobs(struct _framing *f, uint8_t c)
+{
+	if (c == FRAMING_COBS_DELIMITER) {
+		if (f->state == FRAMING_STATE_FRAME && f->len == 0 &&
+		    f->code == 0xFF && f->left == 0)
+			return false;   /* leading delimiter */
+		if (f->state == FRAMING_STATE_FRAME) {
+			if (f->left)
+				f->errors++;    /* truncated block */
+			else
+				_deliver(f);
+		}
+		return true;
+	}
+	if (f->state != FRAMING_STATE_FRAME)
+		return false;
+
+	if (f->left == 0) {
+		/* block code: a zero ended the previous block unless it was
+		 * a full one */
+		if (f->code != 0xFF)
+			_put(f, 0);
+		f->code = c;
+		f->left = c - 1;
+	} else {
+		_put(f, c);
+		f->left--;
+	}
+	return false;
+}
+
+/**
+ * Handle a byte of a length-prefixed frame.
+ *
+ * \return true at the end of the frame.
+ */
+static bool _length(struct _framing *f, uint8_t c)
+{
+	switch (f->state) {
+	case FRAMING_STATE_LEN0:
+		f->remaining = c;
+		f->state = FRAMING_STATE_LEN1;
+		return false;
+
+	case FRAMING_STATE_LEN1:
+		f->remaining |= c << 8;
+		if (f->remaining == 0)
+			return true;
+		if (f->remaining > FRAMING_MAX_FRAME) {
+			f->errors++;
+			f->state = FRAMING_STATE_SKIP;
+		} else {
+			f->state = FRAMING_STATE_DATA;
+		}
+		return false;
+
+	case FRAMING_STATE_DATA:
+		_put(f, c);
+		if (--f->remaining)
+			return false;
+		_deliver(f);
+		return true;
+
+	default:
+		return --f->remaining == 0;
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the decoder.
+ *
+ * \param f      Decoder instance.
+ * \param mode   FRAMING_xxx, FRAMING_NONE passes everything through.
+ * \param text   Receives text outside frames and text frames.
+ * \param frame  Receives binary frame payloads.
+ * \param arg    Argument passed to \a text and \a frame.
+ */
+void framing_init(struct _framing *f, uint8_t mode, framing_out_t text,
+		  framing_out_t frame, void *arg)
+{
+	memset(f, 0, sizeof(*f));
+	f->mode = mode;
+	f->text = text;
+	f->frame = frame;
+	f->arg = arg;
+}
+
+/**
+ * \brief Feed a segment of the receive stream.
+ *
+ * Text outside frames is handed on in place, without copying.
+ */
+void framing_feed(struct _framing *f, const uint8_t *data, uint32_t len)
+{
+	const uint8_t *text = data;
+	uint32_t i;
+	bool end;
+
+	if (f->mode == FRAMING_NONE) {
+		f->text(f->arg, data, len);
+		return;
+	}
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if (f->state == FRAMING_STATE_TEXT) {
+			if ((f->mode == FRAMING_SLIP && c == FRAMING_SLIP_END) ||
+			    (f->mode == FRAMING_COBS && c == FRAMING_COBS_DELIMITER)) {
+				_start(f, FRAMING_STATE_FRAME);
+			} else if (f->mode == FRAMING_LENGTH && c == FRAMING_SOH) {
+				_start(f, FRAMING_STATE_LEN0);
+			} else {
+				continue;
+			}
+			if (&data[i] > text)
+				f->text(f->arg, text, &data[i] - text);
+			continue;
+		}
+
+		if (f->mode == FRAMING_SLIP)
+			end = _slip(f, c);
+		else if (f->mode == FRAMING_COBS)
+			end = _cobs(f, c);
+		else
+			end = _length(f, c);
+
+		if (end) {
+			f->state = FRAMING_STATE_TEXT;
+			text = &data[i + 1];
+		}
+	}
+
+	if (f->state == FRAMING_STATE_TEXT && &data[len] > text)
+		f->text(f->arg, text, &data[len] - text);
+}
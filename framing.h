@@ -0,0 +1,90 @@
+/**
+ * \file
+ *
+ * Decoder of link level frames in the receive stream: SLIP, COBS or
+ * length-prefixed.
+ *
+ * Devices which send binary telemetry wrap their output in frames. Bytes
+ * outside frames pass through unchanged, so plain text may be mixed with
+ * frames:
+ *
+ *   SLIP    END payload END, END = 0xC0, ESC = 0xDB (RFC 1055)
+ *   COBS    0x00 encoded payload 0x00
+ *   LENGTH  SOH len(u16) payload[len], SOH = 0x01, len little-endian
+ *
+ * An empty SLIP or COBS frame (two delimiters in a row) starts a frame, so
+ * senders may put a delimiter before and after every frame. A frame
+ * payload made of printable characters, tabs and line ends is log text and
+ * is handed on as a line; any other payload is a binary frame.
+ *
+ * Text outside frames is handed on in place, frame payloads are decoded
+ * into a buffer of FRAMING_MAX_FRAME bytes. Longer frames are dropped.
+ */
+
+#ifndef _FRAMING_H_
+#define _FRAMING_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Framings */
+enum {
+	FRAMING_NONE = 0,
+	FRAMING_SLIP,
+	FRAMING_COBS,
+	FRAMING_LENGTH,
+};
+
+#define FRAMING_SLIP_END        0xC0
+#define FRAMING_SLIP_ESC        0xDB
+#define FRAMING_SLIP_ESC_END    0xDC
+#define FRAMING_SLIP_ESC_ESC    0xDD
+#define FRAMING_COBS_DELIMITER  0x00
+#define FRAMING_SOH             0x01
+
+/** Longest frame payload */
+#define FRAMING_MAX_FRAME       256
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Output of the decoder: text, or a binary frame payload */
+typedef void (*framing_out_t)(void *arg, const uint8_t *data, uint32_t len);
+
+struct _framing {
+	uint8_t mode;          /* FRAMING_xxx */
+	framing_out_t text;
+	framing_out_t frame;
+	void *arg;
+
+	uint8_t state;
+	uint8_t code;          /* COBS block code */
+	uint8_t left;          /* COBS bytes left in the block */
+	uint16_t remaining;    /* length-prefixed bytes left in the frame */
+	uint16_t len;
+	uint8_t buffer[FRAMING_MAX_FRAME + 1];
+
+	/* statistics */
+	uint32_t frames;       /* binary frames */
+	uint32_t lines;        /* text frames */
+	uint32_t errors;       /* bad encoding or too long */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void framing_init(struct _framing *f, uint8_t mode, framing_out_t text,
+			 framing_out_t frame, void *arg);
+
+extern void framing_feed(struct _framing *f, const uint8_t *data, uint32_t len);
+
+#endif /* _FRAMING_H_ */
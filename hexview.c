@@ -0,0 +1,327 @@
+/**
+ * \file
+ *
+ * Hex view rendering, see hexview.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "hexview.h"
+
+#include "lcd_color.h"
+#include "lcd_draw.h"
+#include "lcd_font.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Bytes of the tile pool: every printable character and the offset
+ * digits, at 8 bpp and the largest glyphs */
+#define TILE_POOL_SIZE	((LCD_FONT_GLYPHS + 16) * 16 * LCD_GLYPH_MAX_ROWS)
+
+/** Glyph of every nibble value */
+static const char _nibble_glyph[16] = {
+	'0', '1', '2', '3', '4', '5', '6', '7',
+	'8', '9', 'A', 'B', 'C', 'D', 'E', 'F',
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Tiles of the characters of the hex views, shared by all of them */
+static uint32_t _tile_pool[TILE_POOL_SIZE / 4];
+
+/** Tile of every printable character in the text color, and of every
+ * nibble in the offset color; NULL for the ones drawn with lcd_draw_char() */
+static const uint8_t *_text_tile[LCD_FONT_GLYPHS];
+static const uint8_t *_offset_tile[16];
+
+/** What the tiles were made for, see _make_tiles() */
+static struct {
+	uint32_t fg;
+	uint32_t bg;
+	uint32_t offset_color;
+	uint8_t width;
+	uint8_t height;		/* 0 if no tile was made */
+	bool valid;
+} _tiles;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Write back the cache lines covering the given rows so the LCDC sees them.
+ */
+static void _clean_rows(const struct _hexview *hv, uint32_t row, uint32_t n)
+{
+	lcd_clean_rows(hv->y + row * hv->row_height, n * hv->row_height);
+}
+
+/**
+ * Render one tile from the pool.
+ *
+ * \return The tile, NULL if it cannot be drawn as one or the pool is full.
+ */
+static const uint8_t *_make_tile(uint32_t *used, uint8_t c, uint32_t color)
+{
+	uint8_t *tile = (uint8_t *)_tile_pool + *used;
+	uint32_t n;
+
+	n = lcd_make_char_tile(c, tile, sizeof(_tile_pool) - *used, _tiles.width,
+			       color, _tiles.bg);
+	if (n == 0)
+		return NULL;
+	*used += (n + 3) & ~3u;	/* keep tiles word aligned */
+	return tile;
+}
+
+/**
+ * Render the tiles of the view colors and the selected font, unless they
+ * are up to date. Hex digits come first, so they get tiles even if the
+ * pool cannot hold every character.
+ */
+static void _make_tiles(const struct _hexview *hv)
+{
+	uint8_t glyph_width, glyph_height;
+	uint32_t used = 0;
+	uint32_t i;
+
+	if (_tiles.valid && _tiles.fg == hv->fg && _tiles.bg == hv->bg &&
+	    _tiles.offset_color == hv->offset_color &&
+	    _tiles.width == (hv->pitch < 16 ? hv->pitch : 16))
+		return;
+
+	lcd_get_glyph_size(&glyph_width, &glyph_height);
+	_tiles.fg = hv->fg;
+	_tiles.bg = hv->bg;
+	_tiles.offset_color = hv->offset_color;
+	_tiles.width = hv->pitch < 16 ? hv->pitch : 16;
+	_tiles.height = 0;
+	_tiles.valid = true;
+	memset(_text_tile, 0, sizeof(_text_tile));
+
+	for (i = 0; i < 16; i++) {
+		_offset_tile[i] = _make_tile(&used, _nibble_glyph[i],
+					     hv->offset_color);
+		_text_tile[_nibble_glyph[i] - LCD_FONT_FIRST_CHAR] =
+			_make_tile(&used, _nibble_glyph[i], hv->fg);
+	}
+	for (i = '!'; i <= '~'; i++) {	/* spaces stay blank */
+		if (_text_tile[i - LCD_FONT_FIRST_CHAR] == NULL)
+			_text_tile[i - LCD_FONT_FIRST_CHAR] =
+				_make_tile(&used, i, hv->fg);
+	}
+	if (used)
+		_tiles.height = glyph_height;
+}
+
+/**
+ * Draw the characters of a row one per pitch, so the columns line up
+ * whatever the advance of the font: the ones with a tile in one copy per
+ * canvas row, the others one by one.
+ */
+static void _draw_cells(const struct _hexview *hv, uint32_t y,
+			const char *text, const uint8_t *const *tiles)
+{
+	uint32_t i;
+
+	if (_tiles.height)
+		lcd_draw_tiles(hv->x, y, tiles, HEXVIEW_ROW_CHARS, hv->pitch,
+			       _tiles.width, _tiles.height);
+	for (i = 0; text[i]; i++) {
+		if (text[i] != ' ' && tiles[i] == NULL)
+			lcd_draw_char(hv->x + i * hv->pitch, y, text[i],
+				      i < HEXVIEW_OFFSET_CHARS ? hv->offset_color
+							       : hv->fg);
+	}
+}
+
+/**
+ * Draw the row starting at stream offset \a offset, blank if no byte of it
+ * was received.
+ */
+static void _draw_row(const struct _hexview *hv, uint32_t row, uint64_t offset)
+{
+	char text[HEXVIEW_ROW_CHARS + 1];
+	const uint8_t *tiles[HEXVIEW_ROW_CHARS];
+	uint32_t hex = HEXVIEW_OFFSET_CHARS;
+	uint32_t ascii = HEXVIEW_OFFSET_CHARS + 4 * 9 + 1;
+	uint32_t y = hv->y + row * hv->row_height;
+	uint32_t count, i;
+	bool staged;
+	int shift;
+
+	staged = lcd_begin_band(y, hv->row_height);
+	lcd_draw_filled_rectangle(hv->x, y, hv->x + hv->width - 1,
+				  y + hv->row_height - 1, hv->bg);
+	if (offset >= hv->total) {
+		if (staged)
+			lcd_end_band();
+		return;
+	}
+
+	count = hv->total - offset;
+	if (count > HEXVIEW_ROW_BYTES)
+		count = HEXVIEW_ROW_BYTES;
+
+	memset(text, ' ', sizeof(text) - 1);
+	memset(tiles, 0, sizeof(tiles));
+	for (i = 0, shift = 20; shift >= 0; i++, shift -= 4) {
+		uint32_t nibble = (offset >> shift) & 0xF;
+
+		text[i] = _nibble_glyph[nibble];
+		tiles[i] = _offset_tile[nibble];
+	}
+
+	for (i = 0; i < count; i++, ascii++) {
+		uint8_t c = hv->buffer[(offset + i) & hv->mask];
+		char a = (c >= 0x20 && c < 0x7F) ? c : '.';
+
+		text[hex] = _nibble_glyph[c >> 4];
+		tiles[hex] = _text_tile[text[hex] - LCD_FONT_FIRST_CHAR];
+		text[hex + 1] = _nibble_glyph[c & 0xF];
+		tiles[hex + 1] = _text_tile[text[hex + 1] - LCD_FONT_FIRST_CHAR];
+		hex += (i & 3) == 3 ? 3 : 2;
+		text[ascii] = a;
+		tiles[ascii] = _text_tile[a - LCD_FONT_FIRST_CHAR];
+	}
+	text[ascii] = 0;
+
+	_draw_cells(hv, y, text, tiles);
+	if (staged)
+		lcd_end_band();
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty hex view.
+ *
+ * \param hv          Hex view instance.
+ * \param buffer      Byte ring.
+ * \param size        Ring size, a power of 2 holding at least every row.
+ * \param x           X-coordinate of the text area.
+ * \param y           Y-coordinate of the text area.
+ * \param width       Text area width in pixels.
+ * \param pitch       Character pitch in pixels.
+ * \param rows        Number of text rows.
+ * \param row_height  Row pitch in pixels.
+ * \param fg          Text color.
+ * \param bg          Background color.
+ */
+void hexview_init(struct _hexview *hv, uint8_t *buffer, uint32_t size,
+		  uint32_t x, uint32_t y, uint32_t width, uint16_t pitch,
+		  uint16_t rows, uint16_t row_height, uint32_t fg, uint32_t bg)
+{
+	assert((size & (size - 1)) == 0);
+	assert(size >= (uint32_t)rows * HEXVIEW_ROW_BYTES);
+
+	hv->buffer = buffer;
+	hv->mask = size - 1;
+	hv->total = 0;
+	hv->x = x;
+	hv->y = y;
+	hv->width = width;
+	hv->pitch = pitch;
+	hv->rows = rows;
+	hv->row_height = row_height;
+	hv->fg = fg;
+	hv->bg = bg;
+	hv->offset_color = COLOR_DARKGRAY;
+	hv->frames = 0;
+	hexview_reset(hv);
+}
+
+/**
+ * \brief Forget what is on screen, the next render repaints every row.
+ *
+ * The character tiles are made again too: call it after the font, the
+ * colors or the canvas changed.
+ */
+void hexview_reset(struct _hexview *hv)
+{
+	_tiles.valid = false;
+	hv->top = 0;
+	hv->end = hv->total;
+	hv->redraw = true;
+}
+
+/**
+ * \brief Append received bytes. Only copies them, nothing is drawn.
+ */
+void hexview_put(struct _hexview *hv, const uint8_t *data, uint32_t len)
+{
+	uint32_t size = hv->mask + 1;
+	uint32_t pos, n;
+
+	if (len > size) {
+		/* only the newest bytes fit */
+		hv->total += len - size;
+		data += len - size;
+		len = size;
+	}
+
+	pos = hv->total & hv->mask;
+	n = size - pos;
+	if (n > len)
+		n = len;
+	memcpy(&hv->buffer[pos], data, n);
+	memcpy(hv->buffer, data + n, len - n);
+	hv->total += len;
+}
+
+/**
+ * \brief Check whether hexview_render() has anything to do.
+ */
+bool hexview_dirty(const struct _hexview *hv)
+{
+	return hv->redraw || hv->end != hv->total;
+}
+
+/**
+ * \brief Bring the screen up to date with the stream.
+ *
+ * If the screen does not scroll, only the row which received bytes and
+ * the new rows are drawn.
+ */
+void hexview_render(struct _hexview *hv)
+{
+	uint64_t total = hv->total;
+	uint64_t row_count = (total + HEXVIEW_ROW_BYTES - 1) / HEXVIEW_ROW_BYTES;
+	uint64_t top;
+	uint32_t row, from, to;
+
+	if (!hexview_dirty(hv))
+		return;
+	_make_tiles(hv);
+
+	top = row_count > hv->rows ? (row_count - hv->rows) * HEXVIEW_ROW_BYTES : 0;
+	to = (row_count * HEXVIEW_ROW_BYTES - top) / HEXVIEW_ROW_BYTES;
+
+	if (!hv->redraw && top == hv->top) {
+		/* no scrolling, redraw from the row the previous frame ended in */
+		from = (hv->end - top) / HEXVIEW_ROW_BYTES;
+		for (row = from; row < to; row++)
+			_draw_row(hv, row, top + row * HEXVIEW_ROW_BYTES);
+		_clean_rows(hv, from, to - from);
+	} else {
+		for (row = 0; row < hv->rows; row++)
+			_draw_row(hv, row, top + row * HEXVIEW_ROW_BYTES);
+		_clean_rows(hv, 0, hv->rows);
+	}
+
+	hv->top = top;
+	hv->end = total;
+	hv->redraw = false;
+	hv->frames++;
+}
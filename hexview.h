@@ -0,0 +1,93 @@
+/**
+ * \file
+ *
+ * Hex view: renders the tail of a byte stream as a hex dump into a screen
+ * region, for links carrying binary protocols.
+ *
+ * Every row shows the stream offset, 16 bytes in hex and the same bytes as
+ * ASCII, non-printable ones as '.':
+ *
+ *   oooooo xxxxxxxx xxxxxxxx xxxxxxxx xxxxxxxx  aaaaaaaaaaaaaaaa
+ *
+ * Bytes are appended to a ring provided by the caller at input rate with
+ * hexview_put(), which only copies them. hexview_render() runs at frame
+ * rate and rasterizes the rows shown: while the screen does not scroll only
+ * the row which received bytes and the new rows are drawn, and rows which
+ * scrolled off between two frames are never formatted. Hex digits come
+ * from a nibble to glyph table, no conversion runs per byte.
+ *
+ * The characters are rendered once, for the font and colors of the view,
+ * into tiles of canvas pixels (see lcd_make_tile()): a row is then drawn
+ * with one copy per character and canvas row instead of masking every
+ * glyph. Text the tiles cannot hold, rotated, scaled or anti-aliased, is
+ * drawn character by character.
+ */
+
+#ifndef _HEXVIEW_H_
+#define _HEXVIEW_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Bytes shown on a row */
+#define HEXVIEW_ROW_BYTES	16
+
+/** Characters taken by the offset column, "oooooo " */
+#define HEXVIEW_OFFSET_CHARS	7
+
+/** Characters of a row */
+#define HEXVIEW_ROW_CHARS	(HEXVIEW_OFFSET_CHARS + 4 * 9 + 1 + HEXVIEW_ROW_BYTES)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _hexview {
+	uint8_t *buffer;       /* byte ring */
+	uint32_t mask;         /* ring size - 1 */
+	uint64_t total;        /* bytes received, offset of the next byte */
+
+	uint32_t x;            /* top-left corner of the text area */
+	uint32_t y;
+	uint32_t width;        /* text area width in pixels */
+	uint16_t pitch;        /* character pitch in pixels */
+	uint16_t rows;         /* text rows */
+	uint16_t row_height;   /* glyph height + line spacing */
+	uint32_t fg;           /* text color */
+	uint32_t bg;           /* background color */
+	uint32_t offset_color; /* color of the offset column */
+
+	uint64_t top;          /* offset shown on the first row */
+	uint64_t end;          /* total at the previous render */
+	bool redraw;           /* repaint every row on the next render */
+
+	/* statistics */
+	uint32_t frames;       /* renders that touched the screen */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void hexview_init(struct _hexview *hv, uint8_t *buffer, uint32_t size,
+			 uint32_t x, uint32_t y, uint32_t width, uint16_t pitch,
+			 uint16_t rows, uint16_t row_height, uint32_t fg,
+			 uint32_t bg);
+
+extern void hexview_reset(struct _hexview *hv);
+
+extern void hexview_put(struct _hexview *hv, const uint8_t *data, uint32_t len);
+
+extern bool hexview_dirty(const struct _hexview *hv);
+
+extern void hexview_render(struct _hexview *hv);
+
+#endif /* _HEXVIEW_H_ */
@@ -0,0 +1,181 @@
+/**
+ * \file
+ *
+ * Host model of the watermark handshake: a sender, the receive ring and a
+ * consumer which stalls, run on a simulated clock against flowctl.c.
+ *
+ * The sender sends back to back while RTS is low. It notices RTS high
+ * only after a reaction time and then still sends what its transmit FIFO
+ * holds. The consumer drains the ring in chunks and stops for a while after
+ * each one, as the main loop does while it renders a frame. Every scenario
+ * checks that the ring never overflows and that the line toggles once per
+ * backpressure period, then prints the statistics the firmware reports.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o flowctl_model \
+ *       host/flowctl_model.c flowctl.c ring.c
+ *   ./flowctl_model
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "flowctl.h"
+#include "ring.h"
+
+#include <stdio.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Same ring and watermarks as the firmware, see main.c */
+#define RX_RING_SIZE		4096
+#define RX_HIGH_WATERMARK	(RX_RING_SIZE * 3 / 4)
+#define RX_LOW_WATERMARK	(RX_RING_SIZE / 4)
+#define RX_DRAIN_CHUNK		256
+
+/** Simulated time */
+#define SIM_DURATION_NS		(2000ULL * 1000 * 1000)
+
+struct _scenario {
+	const char *name;
+	uint32_t baudrate;
+	uint32_t reaction_ns;   /* sender delay to see RTS change */
+	uint32_t fifo;          /* bytes the sender sends after it saw RTS */
+	uint32_t drain_ns;      /* consumer time per drained byte */
+	uint32_t stall_ns;      /* consumer pause after every chunk */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const struct _scenario scenarios[] = {
+	{ "fast consumer",     115200,  20000,  16,  200,       0 },
+	{ "frame stalls",      115200,  20000,  16,  200, 50000000 },
+	{ "921600, stalls",    921600,  20000,  64,  200, 2000000 },
+	{ "921600, slow, lazy", 921600, 500000, 128, 2000, 5000000 },
+};
+
+static uint64_t sim_ns;
+static bool rts_stop;
+static uint64_t rts_changed_ns;
+static uint32_t rts_toggles;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _set_rts(void *arg, bool stop)
+{
+	(void)arg;
+	if (stop != rts_stop) {
+		rts_stop = stop;
+		rts_changed_ns = sim_ns;
+		rts_toggles++;
+	}
+}
+
+static uint32_t _clock_us(void)
+{
+	return (uint32_t)(sim_ns / 1000);
+}
+
+/**
+ * Run one scenario.
+ *
+ * \return true if the ring never overflowed.
+ */
+static bool _run(const struct _scenario *sc)
+{
+	static uint8_t buffer[RX_RING_SIZE];
+	struct _ring ring;
+	struct _flowctl fc;
+	uint64_t byte_ns = 10ULL * 1000000000 / sc->baudrate;
+	uint64_t next_tx = 0, next_drain = 0;
+	uint64_t sent = 0, drained = 0;
+	uint32_t slack = 0, peak = 0, n;
+	bool paused = false;
+	const uint8_t *data;
+
+	sim_ns = 0;
+	rts_stop = true;
+	rts_toggles = 0;
+	ring_init(&ring, buffer, sizeof(buffer));
+	flowctl_init(&fc, RX_HIGH_WATERMARK, RX_LOW_WATERMARK, _set_rts,
+		     _clock_us, NULL);
+	rts_toggles = 0;
+
+	while (sim_ns < SIM_DURATION_NS) {
+		/* sender: it sees RTS after its reaction time, then empties
+		 * its FIFO before it stops */
+		if (sim_ns >= next_tx) {
+			bool stop_seen = rts_stop &&
+					 sim_ns - rts_changed_ns >= sc->reaction_ns;
+
+			if (!stop_seen) {
+				paused = false;
+				slack = sc->fifo;
+			}
+			if (!stop_seen || slack) {
+				if (stop_seen)
+					slack--;
+				if (!ring_put(&ring, (uint8_t)sent))
+					return false;
+				sent++;
+				flowctl_on_fill(&fc, ring_count(&ring));
+				if (ring_count(&ring) > peak)
+					peak = ring_count(&ring);
+			} else {
+				paused = true;
+			}
+			next_tx = sim_ns + byte_ns;
+		}
+
+		/* consumer: a chunk, then a stall */
+		if (sim_ns >= next_drain) {
+			n = ring_peek(&ring, &data);
+			if (n > RX_DRAIN_CHUNK)
+				n = RX_DRAIN_CHUNK;
+			ring_consume(&ring, n);
+			drained += n;
+			flowctl_on_drain(&fc, ring_count(&ring));
+			next_drain = sim_ns + (uint64_t)n * sc->drain_ns +
+				     (n ? sc->stall_ns : 1000);
+		}
+
+		sim_ns = next_tx < next_drain ? next_tx : next_drain;
+	}
+
+	printf("%-20s %7u B/s in, peak %4u, %4u stops, %4u toggles, "
+	       "stopped %4u ms (max %u us)%s\n",
+	       sc->name, (unsigned)(drained * 1000000000 / SIM_DURATION_NS),
+	       (unsigned)peak, (unsigned)fc.events, (unsigned)rts_toggles,
+	       (unsigned)(fc.total_us / 1000), (unsigned)fc.max_us,
+	       paused ? ", sender paused" : "");
+
+	/* one stop and one release per backpressure period */
+	return rts_toggles == 2 * fc.events - (fc.stopped ? 1 : 0);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	unsigned i;
+	int bad = 0;
+
+	for (i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		if (!_run(&scenarios[i])) {
+			printf("%-20s FAILED\n", scenarios[i].name);
+			bad++;
+		}
+	}
+	printf("bad %d of %u\n", bad, i);
+	return bad != 0;
+}
@@ -0,0 +1,248 @@
+/**
+ * \file
+ *
+ * Host benchmark of the LZSS stage: decode throughput against the byte
+ * rate of a 921600 baud link.
+ *
+ * A generated log is compressed in blocks by a greedy heatshrink
+ * compatible encoder and wrapped in SO 'Z' frames between plain text,
+ * for a few window and lookahead sizes. Every stream is first decoded
+ * once and checked against the log, then decoded repeatedly in receive
+ * ring sized chunks for at least a second of host time.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o lzss_bench host/lzss_bench.c \
+ *       lzss.c
+ *   ./lzss_bench
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lzss.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the generated log */
+#define LOG_SIZE		(256 * 1024)
+/** Uncompressed bytes per frame */
+#define BLOCK_SIZE		1024
+/** Segment size, as drained from the receive ring */
+#define RX_DRAIN_CHUNK		256
+/** 921600 baud, 8N1 */
+#define LINK_BYTES_PER_S	92160.0
+/** Minimum host time per measure */
+#define BENCH_MIN_SECONDS	1.0
+
+struct _bitwriter {
+	uint8_t *out;
+	uint32_t len;
+	uint32_t acc;
+	uint32_t nbits;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const char intro[] = "plain text before the frames\r\n";
+static uint8_t log_text[LOG_SIZE];
+static uint8_t stream[LOG_SIZE * 2];
+static uint8_t decoded[LOG_SIZE * 2];
+static uint32_t decoded_len;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	static uint32_t seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+/**
+ * Fill the log with timestamped lines built from a small vocabulary.
+ */
+static void _make_log(void)
+{
+	static const char *words[] = {
+		"sensor", "timeout", "retry", "ERROR", "WARN", "adc", "ch",
+		"mV", "link", "up", "irq", "dma", "done", "queue", "full",
+	};
+	uint32_t pos = 0, line = 0;
+	char buf[128];
+	int n;
+
+	while (pos < LOG_SIZE) {
+		n = snprintf(buf, sizeof(buf), "[%6u.%03u] %s %u %s %s\r\n",
+			     line / 100, line % 100 * 10,
+			     words[_rand() % 15], _rand() % 1000,
+			     words[_rand() % 15], words[_rand() % 15]);
+		if (pos + n > LOG_SIZE)
+			n = LOG_SIZE - pos;
+		memcpy(&log_text[pos], buf, n);
+		pos += n;
+		line++;
+	}
+}
+
+static void _put_bits(struct _bitwriter *w, uint32_t value, uint32_t count)
+{
+	while (count--) {
+		w->acc = (w->acc << 1) | ((value >> count) & 1);
+		if (++w->nbits == 8) {
+			w->out[w->len++] = w->acc;
+			w->acc = 0;
+			w->nbits = 0;
+		}
+	}
+}
+
+/**
+ * Compress one block as a heatshrink stream, greedy longest match.
+ *
+ * \return Compressed length.
+ */
+static uint32_t _encode(uint8_t *out, const uint8_t *in, uint32_t len,
+			uint32_t window_bits, uint32_t count_bits)
+{
+	struct _bitwriter w = { out, 0, 0, 0 };
+	uint32_t window = 1 << window_bits, max = 1 << count_bits;
+	uint32_t i = 0, off, n, best, best_off;
+
+	while (i < len) {
+		best = 0;
+		best_off = 0;
+		for (off = 1; off <= window && off <= i; off++) {
+			for (n = 0; n < max && i + n < len &&
+			     in[i + n - off] == in[i + n]; n++)
+				;
+			if (n > best) {
+				best = n;
+				best_off = off;
+			}
+		}
+		if (best >= 2) {
+			_put_bits(&w, 0, 1);
+			_put_bits(&w, best_off - 1, window_bits);
+			_put_bits(&w, best - 1, count_bits);
+			i += best;
+		} else {
+			_put_bits(&w, 1, 1);
+			_put_bits(&w, in[i], 8);
+			i++;
+		}
+	}
+	if (w.nbits)
+		_put_bits(&w, 0, 8 - w.nbits);
+	return w.len;
+}
+
+/**
+ * Build the stream: a text line, then the log in frames.
+ *
+ * \return Stream length.
+ */
+static uint32_t _make_stream(uint32_t window_bits, uint32_t count_bits)
+{
+	uint32_t len = sizeof(intro) - 1, pos, n, c;
+
+	memcpy(stream, intro, len);
+	for (pos = 0; pos < LOG_SIZE; pos += n) {
+		n = LOG_SIZE - pos < BLOCK_SIZE ? LOG_SIZE - pos : BLOCK_SIZE;
+		c = _encode(&stream[len + 5], &log_text[pos], n, window_bits,
+			    count_bits);
+		stream[len] = LZSS_SO;
+		stream[len + 1] = LZSS_MAGIC;
+		stream[len + 2] = (window_bits << 4) | count_bits;
+		stream[len + 3] = c & 0xFF;
+		stream[len + 4] = c >> 8;
+		len += 5 + c;
+	}
+	return len;
+}
+
+static void _collect(void *arg, const uint8_t *data, uint32_t len)
+{
+	if (arg) {
+		memcpy(&decoded[decoded_len], data, len);
+		decoded_len += len;
+	}
+}
+
+static void _feed(struct _lzss *z, uint32_t len)
+{
+	uint32_t pos, n;
+
+	for (pos = 0; pos < len; pos += n) {
+		n = len - pos < RX_DRAIN_CHUNK ? len - pos : RX_DRAIN_CHUNK;
+		lzss_feed(z, &stream[pos], n);
+	}
+}
+
+/**
+ * Check and time the decoding of one stream.
+ *
+ * \return true if the stream decoded to the log.
+ */
+static bool _bench(uint32_t window_bits, uint32_t count_bits)
+{
+	static struct _lzss z;
+	uint32_t len = _make_stream(window_bits, count_bits);
+	uint64_t in = 0, out = 0;
+	double seconds;
+	clock_t start;
+	bool ok;
+
+	decoded_len = 0;
+	lzss_init(&z, _collect, &z);
+	_feed(&z, len);
+	ok = decoded_len == sizeof(intro) - 1 + LOG_SIZE && z.errors == 0 &&
+	     memcmp(decoded, intro, sizeof(intro) - 1) == 0 &&
+	     memcmp(&decoded[sizeof(intro) - 1], log_text, LOG_SIZE) == 0;
+
+	lzss_init(&z, _collect, NULL);
+	start = clock();
+	do {
+		_feed(&z, len);
+		in += len;
+		out += sizeof(intro) - 1 + LOG_SIZE;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while (seconds < BENCH_MIN_SECONDS);
+
+	printf("window 2^%-2u lookahead 2^%u: ratio %4.2f, %6.1f MB/s in, "
+	       "%6.1f MB/s out, %5.0fx the link%s\n",
+	       (unsigned)window_bits, (unsigned)count_bits,
+	       (double)LOG_SIZE / len, in / seconds / 1e6, out / seconds / 1e6,
+	       in / seconds / LINK_BYTES_PER_S, ok ? "" : ", BAD OUTPUT");
+	return ok;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	int bad = 0;
+
+	_make_log();
+	bad += !_bench(8, 4);
+	bad += !_bench(10, 4);
+	bad += !_bench(10, 6);
+	bad += !_bench(6, 3);
+	printf("bad %d of 4\n", bad);
+	return bad != 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * \file
+ *
+ * Host benchmark of the keyword matcher: MB/s of log text scanned with
+ * a list of more than 50 keywords.
+ *
+ * The keywords are compiled case-insensitively as the firmware does. A
+ * generated log is tagged line by line with match_run() and with a naive
+ * search of every keyword in every line; the tags of both must agree.
+ * Both are then timed for at least a second of host time.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o match_bench host/match_bench.c \
+ *       match.c
+ *   ./match_bench
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "match.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the generated log */
+#define LOG_SIZE		(1024 * 1024)
+/** Minimum host time per measure */
+#define BENCH_MIN_SECONDS	1.0
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const struct _match_pattern keywords[] = {
+	{ "panic", 0 }, { "assert", 0 }, { "fatal", 0 }, { "oops", 0 },
+	{ "hard fault", 0 }, { "stack overflow", 0 }, { "watchdog", 0 },
+	{ "abort", 0 }, { "bus error", 0 }, { "segfault", 0 },
+	{ "error", 1 }, { "fail", 1 }, { "timeout", 1 }, { "overrun", 1 },
+	{ "underrun", 1 }, { "crc", 1 }, { "nack", 1 }, { "refused", 1 },
+	{ "denied", 1 }, { "corrupt", 1 }, { "invalid", 1 }, { "lost", 1 },
+	{ "not responding", 1 }, { "unreachable", 1 }, { "dropped", 1 },
+	{ "warn", 2 }, { "retry", 2 }, { "slow", 2 }, { "deprecated", 2 },
+	{ "fallback", 2 }, { "degraded", 2 }, { "throttl", 2 },
+	{ "low battery", 2 }, { "high temp", 2 }, { "busy", 2 },
+	{ "resend", 2 }, { "backoff", 2 }, { "full", 2 }, { "stall", 2 },
+	{ "link up", 3 }, { "link down", 3 }, { "boot", 3 }, { "reset", 3 },
+	{ "suspend", 3 }, { "resume", 3 }, { "connected", 3 },
+	{ "disconnected", 3 }, { "mounted", 3 }, { "calibrat", 3 },
+	{ "firmware", 3 }, { "update", 3 }, { "sensor", 4 }, { "adc", 4 },
+	{ "dma", 4 }, { "irq", 4 }, { "usb", 4 }, { "spi", 4 }, { "i2c", 4 },
+	{ "uart", 4 }, { "eth0", 4 },
+};
+
+static const char *words[] = {
+	"sensor", "poll", "value", "ok", "done", "Timeout", "retry", "ERROR",
+	"Warn", "adc", "ch3", "mV", "link", "up", "irq", "dma", "queue",
+	"full", "start", "stop", "frame", "rx", "tx", "bytes", "ready",
+	"idle", "task", "heap", "free", "tick",
+};
+
+static uint16_t table[MATCH_MAX_STATES * (1 + MATCH_MAX_CLASSES)];
+static struct _match matcher;
+static char log_text[LOG_SIZE];
+static uint32_t log_len;
+static uint32_t line_count;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	static uint32_t seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+/**
+ * Fill the log with lines of 4 to 12 words.
+ */
+static void _make_log(void)
+{
+	uint32_t n, i;
+	int len;
+
+	while (log_len < LOG_SIZE - 256) {
+		len = sprintf(&log_text[log_len], "[%8u]", (unsigned)line_count);
+		n = 4 + _rand() % 9;
+		for (i = 0; i < n; i++)
+			len += sprintf(&log_text[log_len + len], " %s",
+				       words[_rand() % ARRAY_SIZE(words)]);
+		log_text[log_len + len++] = '\n';
+		log_len += len;
+		line_count++;
+	}
+}
+
+/**
+ * Tag the lines with the automaton, as the firmware does per line.
+ */
+static uint32_t _tag_automaton(uint16_t *tags)
+{
+	const char *line = log_text, *end = log_text + log_len, *eol;
+	uint32_t n = 0, sum = 0;
+	uint16_t state;
+
+	while (line < end) {
+		eol = memchr(line, '\n', end - line);
+		state = MATCH_ROOT;
+		tags[n] = match_run(&matcher, &state, (const uint8_t *)line,
+				    eol - line);
+		sum += tags[n++];
+		line = eol + 1;
+	}
+	return sum;
+}
+
+static bool _contains(const char *line, uint32_t len, const char *word)
+{
+	uint32_t wlen = strlen(word), i, j;
+
+	for (i = 0; i + wlen <= len; i++) {
+		for (j = 0; j < wlen; j++) {
+			if (tolower((unsigned char)line[i + j]) != word[j])
+				break;
+		}
+		if (j == wlen)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Tag the lines by searching every keyword in every line.
+ */
+static uint32_t _tag_naive(uint16_t *tags)
+{
+	const char *line = log_text, *end = log_text + log_len, *eol;
+	uint32_t n = 0, sum = 0, k;
+
+	while (line < end) {
+		eol = memchr(line, '\n', end - line);
+		tags[n] = 0;
+		for (k = 0; k < ARRAY_SIZE(keywords); k++) {
+			if (_contains(line, eol - line, keywords[k].text))
+				tags[n] |= 1 << keywords[k].tag;
+		}
+		sum += tags[n++];
+		line = eol + 1;
+	}
+	return sum;
+}
+
+/**
+ * Time a tagger.
+ *
+ * \return Log text scanned in MB/s.
+ */
+static double _time(uint32_t (*tag)(uint16_t *), uint16_t *tags)
+{
+	clock_t start = clock();
+	double seconds;
+	uint64_t bytes = 0;
+	volatile uint32_t sink = 0;
+
+	do {
+		sink += tag(tags);
+		bytes += log_len;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while (seconds < BENCH_MIN_SECONDS);
+	(void)sink;
+	return bytes / seconds / 1e6;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	static uint16_t tags[LOG_SIZE / 16], expect[LOG_SIZE / 16];
+	uint32_t i, bad = 0;
+	double automaton, naive;
+
+	if (match_compile(&matcher, keywords, ARRAY_SIZE(keywords), true,
+			  table, ARRAY_SIZE(table)) < 0) {
+		printf("keywords do not fit the automaton\n");
+		return 1;
+	}
+	_make_log();
+
+	_tag_automaton(tags);
+	_tag_naive(expect);
+	for (i = 0; i < line_count; i++)
+		bad += tags[i] != expect[i];
+
+	automaton = _time(_tag_automaton, tags);
+	naive = _time(_tag_naive, expect);
+	printf("%u keywords, %u states, %u classes, table %u bytes\n",
+	       (unsigned)ARRAY_SIZE(keywords), (unsigned)matcher.states,
+	       (unsigned)matcher.classes,
+	       (unsigned)(matcher.states * (1 + matcher.classes) * 2));
+	printf("%u lines: automaton %.1f MB/s, naive search %.1f MB/s\n",
+	       (unsigned)line_count, automaton, naive);
+	printf("bad %u of %u\n", (unsigned)bad, (unsigned)line_count);
+	return bad != 0;
+}
@@ -0,0 +1,351 @@
+/**
+ * \file
+ *
+ * Host driver of the replayer: feeds a capture blob through the receive
+ * path of the example, receive ring, pipeline stages and line store, and
+ * prints the lines it assembles.
+ *
+ * The clock is simulated. The receive interrupt is modelled by putting
+ * every record into the ring at its capture time, the main loop by a drain
+ * of the ring every drain period. The driver reports the latency of the
+ * bytes between their arrival and the drain which decoded them, then the
+ * host throughput of the decoding path with the blob replayed as fast as
+ * it is consumed.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o replay host/replay.c capture.c \
+ *       ring.c pipeline.c framing.c lzss.c binlog.c binlog_formats.c \
+ *       line_store.c replay_data.c
+ *   ./replay [blob [drain period in us [slip|cobs]]]
+ *
+ * Without a blob file the capture linked into the firmware is replayed,
+ * see replay_data.c.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "binlog.h"
+#include "capture.h"
+#include "framing.h"
+#include "line_store.h"
+#include "lzss.h"
+#include "pipeline.h"
+#include "ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Same sizes as the firmware, see main.c */
+#define RX_RING_SIZE		4096
+#define RX_DRAIN_CHUNK		256
+#define HISTORY_LINE_COUNT	1024
+
+/** Default main loop period of the simulation */
+#define DRAIN_PERIOD_US		1000
+
+/** Minimum host time spent on the throughput measure */
+#define BENCH_MIN_SECONDS	1.0
+
+struct _host_channel {
+	struct _ring ring;
+	uint8_t rx_buffer[RX_RING_SIZE];
+	uint32_t arrival[RX_RING_SIZE]; /* arrival time of every ring byte */
+	uint32_t overruns;
+
+	struct _pipeline pipe;
+	struct _framing framing;
+	struct _pipe_stage framing_stage;
+	struct _lzss lzss;
+	struct _pipe_stage lzss_stage;
+	struct _binlog binlog;
+	struct _pipe_stage binlog_stage;
+
+	struct _line_store store;
+	struct _line lines[HISTORY_LINE_COUNT];
+	uint16_t tags[HISTORY_LINE_COUNT];
+	bool line_open;
+	uint32_t stamp;
+
+	uint32_t frames;
+	bool print;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _host_channel channel;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _framing_stage(struct _pipe_stage *stage, const uint8_t *data,
+			   uint32_t len)
+{
+	framing_feed((struct _framing *)stage->ctx, data, len);
+}
+
+static void _framing_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _framing_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_frame((struct _pipe_stage *)arg, data, len);
+}
+
+static void _lzss_stage(struct _pipe_stage *stage, const uint8_t *data,
+			uint32_t len)
+{
+	lzss_feed((struct _lzss *)stage->ctx, data, len);
+}
+
+static void _lzss_out(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _binlog_stage(struct _pipe_stage *stage, const uint8_t *data,
+			  uint32_t len)
+{
+	binlog_feed((struct _binlog *)stage->ctx, data, len);
+}
+
+static void _binlog_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _binlog_line(void *arg, const char *line, uint32_t len)
+{
+	static const uint8_t eol = '\n';
+
+	pipe_emit((struct _pipe_stage *)arg, (const uint8_t *)line, len);
+	pipe_emit((struct _pipe_stage *)arg, &eol, 1);
+}
+
+/**
+ * Text sink: assemble lines like the text path of the firmware.
+ */
+static void _rx_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct _host_channel *ch = (struct _host_channel *)arg;
+	const struct _line *line;
+	uint32_t i, seq;
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		if (!ch->line_open) {
+			line_store_stamp(&ch->store, ch->stamp);
+			ch->line_open = true;
+		}
+		if (c == '\n') {
+			seq = line_store_commit(&ch->store);
+			ch->line_open = false;
+			if (ch->print) {
+				line = line_store_get(&ch->store, seq);
+				printf("%10u  %.*s\n", (unsigned)line_stamp(line),
+				       line->len, line->text);
+			}
+		} else if (c >= 0x20) {
+			line_store_putc(&ch->store, c);
+		} else if (c == 0x08) {
+			line_store_backspace(&ch->store);
+		}
+	}
+}
+
+static void _rx_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct _host_channel *ch = (struct _host_channel *)arg;
+
+	ch->frames++;
+	if (ch->print)
+		printf("%10s  [frame, %u bytes]\n", "", (unsigned)len);
+	(void)data;
+}
+
+/**
+ * Set up the receive path of the channel, stages in firmware order.
+ */
+static void _channel_init(struct _host_channel *ch, uint8_t framing, bool print)
+{
+	memset(ch, 0, sizeof(*ch));
+	ch->print = print;
+	ring_init(&ch->ring, ch->rx_buffer, sizeof(ch->rx_buffer));
+	line_store_init(&ch->store, ch->lines, ch->tags, HISTORY_LINE_COUNT);
+	pipeline_init(&ch->pipe, _rx_text, _rx_frame, ch);
+	if (framing != FRAMING_NONE) {
+		framing_init(&ch->framing, framing, _framing_text,
+			     _framing_frame, &ch->framing_stage);
+		pipeline_add(&ch->pipe, &ch->framing_stage, "framing",
+			     _framing_stage, &ch->framing);
+	}
+	lzss_init(&ch->lzss, _lzss_out, &ch->lzss_stage);
+	pipeline_add(&ch->pipe, &ch->lzss_stage, "lzss", _lzss_stage, &ch->lzss);
+	binlog_init(&ch->binlog, _binlog_text, _binlog_line, &ch->binlog_stage);
+	pipeline_add(&ch->pipe, &ch->binlog_stage, "binlog", _binlog_stage,
+		     &ch->binlog);
+}
+
+/**
+ * Receive interrupt: store a byte and its arrival time.
+ */
+static void _rx_put(struct _host_channel *ch, uint8_t c, uint32_t now)
+{
+	ch->arrival[ch->ring.head & ch->ring.mask] = now;
+	if (!ring_put(&ch->ring, c))
+		ch->overruns++;
+}
+
+/**
+ * Main loop: drain the ring in chunks, adding up the byte latencies.
+ */
+static void _rx_drain(struct _host_channel *ch, uint32_t now,
+		      uint64_t *latency, uint32_t *max_latency)
+{
+	const uint8_t *data, *eol;
+	uint32_t len, i, wait;
+
+	while ((len = ring_peek(&ch->ring, &data)) != 0) {
+		if (len > RX_DRAIN_CHUNK)
+			len = RX_DRAIN_CHUNK;
+		/* segments end after a line end and take the arrival time of
+		 * their first byte, as the line marks of the firmware do */
+		eol = memchr(data, '\n', len);
+		if (eol)
+			len = eol - data + 1;
+		ch->stamp = ch->arrival[ch->ring.tail & ch->ring.mask];
+		for (i = 0; i < len; i++) {
+			wait = now - ch->arrival[(ch->ring.tail + i) & ch->ring.mask];
+			*latency += wait;
+			if (wait > *max_latency)
+				*max_latency = wait;
+		}
+		pipeline_feed(&ch->pipe, data, len);
+		ring_consume(&ch->ring, len);
+	}
+}
+
+/**
+ * Replay the blob on the simulated clock and print what it decodes to.
+ */
+static int _replay(const uint8_t *blob, uint32_t size, uint32_t period,
+		   uint8_t framing)
+{
+	struct _replay rp;
+	uint64_t latency = 0;
+	uint32_t max_latency = 0;
+	uint32_t now = 0, next;
+	uint8_t c;
+
+	_channel_init(&channel, framing, true);
+	if (replay_start(&rp, blob, size, 1, now) < 0) {
+		fprintf(stderr, "blob not recognized\n");
+		return -1;
+	}
+
+	while (!replay_done(&rp) || ring_count(&channel.ring)) {
+		next = now + period;
+		while (!replay_done(&rp) && rp.due_us <= next) {
+			now = rp.due_us;
+			replay_next(&rp, now, &c);
+			_rx_put(&channel, c, now);
+		}
+		now = next;
+		_rx_drain(&channel, now, &latency, &max_latency);
+	}
+
+	printf("\n%u bytes over %u us, %u lines, %u frames, %u overruns\n",
+	       (unsigned)rp.bytes, (unsigned)now,
+	       (unsigned)line_store_end(&channel.store),
+	       (unsigned)channel.frames, (unsigned)channel.overruns);
+	printf("drain every %u us: byte latency mean %u us, max %u us\n",
+	       (unsigned)period,
+	       rp.bytes ? (unsigned)(latency / rp.bytes) : 0,
+	       (unsigned)max_latency);
+	printf("lzss %u frames, %u errors; binlog %u records, %u errors\n",
+	       (unsigned)channel.lzss.frames, (unsigned)channel.lzss.errors,
+	       (unsigned)channel.binlog.records, (unsigned)channel.binlog.errors);
+	return 0;
+}
+
+/**
+ * Time the decoding path with the blob delivered as fast as it drains.
+ */
+static void _bench(const uint8_t *blob, uint32_t size, uint8_t framing)
+{
+	struct _replay rp;
+	uint64_t bytes = 0;
+	uint8_t c;
+	clock_t start = clock();
+	double seconds;
+
+	do {
+		_channel_init(&channel, framing, false);
+		replay_start(&rp, blob, size, REPLAY_SPEED_MAX, 0);
+		while (!replay_done(&rp)) {
+			const uint8_t *data;
+			uint32_t len;
+
+			while (ring_free(&channel.ring) &&
+			       replay_next(&rp, 0, &c))
+				ring_put(&channel.ring, c);
+			while ((len = ring_peek(&channel.ring, &data)) != 0) {
+				pipeline_feed(&channel.pipe, data, len);
+				ring_consume(&channel.ring, len);
+			}
+		}
+		bytes += rp.bytes;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while (seconds < BENCH_MIN_SECONDS);
+
+	printf("host throughput %.1f MB/s (921600 baud is 0.09 MB/s)\n",
+	       bytes / seconds / 1e6);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+	const uint8_t *blob = replay_data;
+	uint32_t size = replay_data_size;
+	uint32_t period = DRAIN_PERIOD_US;
+	uint8_t framing = FRAMING_NONE;
+	static uint8_t file[16 * 1024 * 1024];
+	FILE *f;
+
+	if (argc > 1) {
+		f = fopen(argv[1], "rb");
+		if (!f) {
+			perror(argv[1]);
+			return 1;
+		}
+		size = fread(file, 1, sizeof(file), f);
+		fclose(f);
+		blob = file;
+	}
+	if (argc > 2)
+		period = strtoul(argv[2], NULL, 0);
+	if (argc > 3)
+		framing = strcmp(argv[3], "cobs") ? FRAMING_SLIP : FRAMING_COBS;
+
+	if (_replay(blob, size, period, framing) < 0)
+		return 1;
+	_bench(blob, size, framing);
+	return 0;
+}
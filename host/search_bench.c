@@ -0,0 +1,225 @@
+/**
+ * \file
+ *
+ * Host benchmark of the history search: query latency against history
+ * size, trigram index against a scan of every line.
+ *
+ * Histories of growing size are filled with generated log lines and
+ * indexed with a posting pool of SEARCH_POSTINGS_PER_LINE postings per
+ * line, as the firmware sizes it. Every query is answered by search_find()
+ * and by a naive scan back from the newest line, which must agree on the
+ * line found; then both are timed. The queries cover a word in every
+ * line, a word in a single old line, a word in no line and a two letter
+ * query, which search_find() answers by scanning. The table also shows
+ * the postings a line takes and the share of the history the pool
+ * indexes; build with -DSEARCH_POSTINGS_PER_LINE=32 to see the cost of a
+ * smaller pool.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o search_bench \
+ *       host/search_bench.c search.c line_store.c
+ *   ./search_bench
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "line_store.h"
+#include "search.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Postings per history line, see main.c */
+#ifndef SEARCH_POSTINGS_PER_LINE
+#define SEARCH_POSTINGS_PER_LINE	64
+#endif
+
+/** Largest history measured */
+#define MAX_LINES		8192
+/** Minimum host time per measure */
+#define BENCH_MIN_SECONDS	0.2
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const char *words[] = {
+	"sensor", "poll", "value", "ok", "done", "timeout", "retry", "error",
+	"warn", "adc", "ch3", "mV", "link", "up", "irq", "dma", "queue",
+	"full", "start", "stop", "frame", "rx", "tx", "bytes", "ready",
+	"idle", "task", "heap", "free", "tick",
+};
+
+static const char *queries[] = { "app:", "needle", "absent", "rx" };
+
+static struct _line lines[MAX_LINES];
+static uint16_t tags[MAX_LINES];
+static struct _search_posting postings[MAX_LINES * SEARCH_POSTINGS_PER_LINE];
+static struct _line_store store;
+static struct _search search;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	static uint32_t seed = 1;
+
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static void _put_line(const char *text)
+{
+	while (*text)
+		line_store_putc(&store, *text++);
+	search_add(&search, line_store_commit(&store));
+}
+
+/**
+ * Fill a history of \a count slots, one old line holds "needle".
+ */
+static void _fill(uint32_t count)
+{
+	char buf[LINE_MAX_CHARS + 1];
+	uint32_t i, k, n;
+	int len;
+
+	line_store_init(&store, lines, tags, count);
+	search_init(&search, &store, postings, count * SEARCH_POSTINGS_PER_LINE);
+	for (i = 0; i < count - 1; i++) {
+		len = sprintf(buf, "[%6u.%06u] app:", i / 100, i % 100 * 10000);
+		n = 2 + _rand() % 8;
+		for (k = 0; k < n; k++)
+			len += sprintf(&buf[len], " %s",
+				       words[_rand() % ARRAY_SIZE(words)]);
+		if (i == count / 8)
+			sprintf(&buf[len], " needle");
+		_put_line(buf);
+	}
+}
+
+/**
+ * Share of the history whose postings are all in the pool, in percent.
+ */
+static uint32_t _indexed(void)
+{
+	uint32_t lines = line_store_end(&store) - line_store_first(&store);
+	uint32_t oldest;
+
+	if (search.count <= search.mask)
+		return 100;
+	oldest = search.postings[search.count & search.mask].seq;
+	return 100 * (line_store_end(&store) - oldest - 1) / lines;
+}
+
+/**
+ * Case folded substring check, as search.c scans.
+ */
+static bool _contains(const char *text, const char *query)
+{
+	uint32_t i;
+
+	for (; *text; text++) {
+		for (i = 0; query[i]; i++) {
+			if (!text[i] || tolower((unsigned char)text[i]) !=
+					tolower((unsigned char)query[i]))
+				break;
+		}
+		if (!query[i])
+			return true;
+	}
+	return false;
+}
+
+static bool _naive(const char *query, uint32_t *seq)
+{
+	uint32_t first = line_store_first(&store);
+	uint32_t s = line_store_end(&store);
+
+	while (s != first) {
+		const struct _line *line = line_store_get(&store, --s);
+
+		if (_contains(line->text, query)) {
+			*seq = s;
+			return true;
+		}
+	}
+	return false;
+}
+
+static double _time_find(const char *query)
+{
+	uint32_t seq, runs = 0;
+	clock_t start = clock();
+	double seconds;
+
+	do {
+		search_find(&search, query, line_store_end(&store), &seq);
+		runs++;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while (seconds < BENCH_MIN_SECONDS);
+	return seconds * 1e6 / runs;
+}
+
+static double _time_naive(const char *query)
+{
+	uint32_t seq, runs = 0;
+	clock_t start = clock();
+	double seconds;
+
+	do {
+		_naive(query, &seq);
+		runs++;
+		seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+	} while (seconds < BENCH_MIN_SECONDS);
+	return seconds * 1e6 / runs;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t count, q, bad = 0, checks = 0;
+	uint32_t got, expect;
+	bool found, present;
+
+	printf("%6s %9s %8s", "lines", "postings", "indexed");
+	for (q = 0; q < ARRAY_SIZE(queries); q++)
+		printf(" %16s", queries[q]);
+	printf("   (us, index / scan)\n");
+
+	for (count = 256; count <= MAX_LINES; count *= 2) {
+		_fill(count);
+		printf("%6u %9.1f %7u%%", (unsigned)(count - 1),
+		       (double)search.count / search.lines,
+		       (unsigned)_indexed());
+		for (q = 0; q < ARRAY_SIZE(queries); q++) {
+			found = search_find(&search, queries[q],
+					    line_store_end(&store), &got);
+			present = _naive(queries[q], &expect);
+			bad += found != present || (found && got != expect);
+			checks++;
+			printf(" %7.2f/%8.2f", _time_find(queries[q]),
+			       _time_naive(queries[q]));
+		}
+		printf("\n");
+	}
+	printf("bad %u of %u\n", (unsigned)bad, (unsigned)checks);
+	return bad != 0;
+}
@@ -0,0 +1,323 @@
+/**
+ * \file
+ *
+ * Host check of the receive pipeline with recorded streams: framing, LZSS
+ * and binlog stages in firmware order, fed in segments of every size.
+ *
+ * The SLIP stream mixes plain text, a text frame, binary frames with
+ * escaped bytes, a binlog format definition and records (one with too
+ * many arguments, one with an unknown format, one in the middle of a
+ * line), a stray STX and an LZSS frame. The COBS stream mixes plain text,
+ * text frames and binary frames holding zeros. The plain stream, without
+ * framing, has doubled STX bytes in text and before a record, and %c
+ * arguments which are control characters. For every segment size the
+ * text reaching the end of the pipeline and the binary frames must be the
+ * ones recorded with the stream.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o stream_test host/stream_test.c \
+ *       pipeline.c framing.c lzss.c binlog.c binlog_formats.c
+ *   ./stream_test
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "binlog.h"
+#include "framing.h"
+#include "lzss.h"
+#include "pipeline.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+/** Most frames in a stream */
+#define MAX_FRAMES		4
+
+struct _frame {
+	const uint8_t *data;
+	uint32_t len;
+};
+
+struct _stream {
+	const char *name;
+	uint8_t framing;
+	const uint8_t *data;
+	uint32_t len;
+	const char *text;
+	struct _frame frames[MAX_FRAMES];
+};
+
+struct _output {
+	uint8_t text[1024];
+	uint32_t text_len;
+	uint8_t frames[MAX_FRAMES][FRAMING_MAX_FRAME];
+	uint32_t frame_len[MAX_FRAMES];
+	uint32_t frame_count;
+	uint32_t text_calls;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/* Recorded streams, each followed by the text and the frames it carries */
+
+static const uint8_t slip_stream[] = {
+	0x62, 0x6F, 0x6F, 0x74, 0x3A, 0x20, 0x53, 0x41, 0x4D, 0x39, 0x58, 0x36,
+	0x30, 0x20, 0x72, 0x65, 0x76, 0x20, 0x42, 0x0D, 0x0A, 0xC0, 0x73, 0x6C,
+	0x69, 0x70, 0x20, 0x74, 0x65, 0x78, 0x74, 0x20, 0x66, 0x72, 0x61, 0x6D,
+	0x65, 0xC0, 0xC0, 0x10, 0xDB, 0xDC, 0xDB, 0xDD, 0x7F, 0x00, 0x01, 0xC0,
+	0x02, 0x46, 0x20, 0x00, 0x0C, 0x74, 0x65, 0x6D, 0x70, 0x20, 0x25, 0x64,
+	0x2E, 0x25, 0x75, 0x20, 0x43, 0x1A, 0x61, 0x66, 0x74, 0x65, 0x72, 0x20,
+	0x66, 0x6F, 0x72, 0x6D, 0x61, 0x74, 0x0A, 0x02, 0x4C, 0x20, 0x00, 0x02,
+	0x15, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x7E, 0x02, 0x78, 0x20,
+	0x73, 0x74, 0x72, 0x61, 0x79, 0x20, 0x53, 0x54, 0x58, 0x0A, 0x02, 0x4C,
+	0x21, 0x00, 0x09, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x03,
+	0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x06,
+	0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x09,
+	0x00, 0x00, 0x00, 0x65, 0x61, 0x66, 0x74, 0x65, 0x72, 0x20, 0x62, 0x61,
+	0x64, 0x20, 0x72, 0x65, 0x63, 0x6F, 0x72, 0x64, 0x0A, 0x6D, 0x69, 0x64,
+	0x2D, 0x6C, 0x69, 0x6E, 0x65, 0x20, 0x02, 0x4C, 0x33, 0x00, 0x01, 0xEF,
+	0xBE, 0xAD, 0xDE, 0x5C, 0x0E, 0x5A, 0x84, 0x23, 0x00, 0xB1, 0xDB, 0xED,
+	0xB7, 0x0B, 0x95, 0x96, 0xE7, 0x73, 0xB2, 0xD9, 0x24, 0x16, 0xCB, 0x4D,
+	0xBA, 0xCB, 0x20, 0xB7, 0x80, 0xC6, 0x14, 0x13, 0xFB, 0xA5, 0xDE, 0xDE,
+	0x13, 0xF0, 0x98, 0xDA, 0x01, 0xA2, 0x29, 0x10, 0xC0, 0x05, 0x06, 0x62,
+	0x69, 0x6E, 0x61, 0x72, 0x79, 0x20, 0x61, 0x66, 0x74, 0x65, 0x72, 0x20,
+	0x6C, 0x7A, 0x73, 0x73, 0xC0, 0x65, 0x6E, 0x64, 0x0A,
+};
+
+static const char slip_text[] =
+	"boot: SAM9X60 rev B\r\n"
+	"slip text frame\n"
+	"after format\n"
+	"temp 21.5 C\n"
+	"\x02""x stray STX\n"
+	"after bad record\n"
+	"mid-line <fmt 51> deadbeef\n"
+	"compressed line one\n"
+	"compressed line two\n"
+	"compressed line three\n"
+	"end\n";
+
+static const uint8_t slip_frame0[] = {
+	0x10, 0xC0, 0xDB, 0x7F, 0x00, 0x01,
+};
+
+static const uint8_t slip_frame1[] = {
+	0x05, 0x06, 0x62, 0x69, 0x6E, 0x61, 0x72, 0x79, 0x20, 0x61, 0x66, 0x74,
+	0x65, 0x72, 0x20, 0x6C, 0x7A, 0x73, 0x73,
+};
+
+static const uint8_t cobs_stream[] = {
+	0x63, 0x6F, 0x62, 0x73, 0x20, 0x6C, 0x69, 0x6E, 0x6B, 0x20, 0x75, 0x70,
+	0x0D, 0x0A, 0x00, 0x11, 0x63, 0x6F, 0x62, 0x73, 0x20, 0x74, 0x65, 0x78,
+	0x74, 0x20, 0x66, 0x72, 0x61, 0x6D, 0x65, 0x0A, 0x00, 0x00, 0x01, 0x02,
+	0x11, 0x01, 0x03, 0x22, 0xFF, 0x00, 0x62, 0x65, 0x74, 0x77, 0x65, 0x65,
+	0x6E, 0x20, 0x66, 0x72, 0x61, 0x6D, 0x65, 0x73, 0x0A, 0x00, 0x01, 0x28,
+	0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C,
+	0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18,
+	0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,
+	0x25, 0x26, 0x27, 0x00, 0x00, 0x0C, 0x6E, 0x6F, 0x20, 0x6C, 0x69, 0x6E,
+	0x65, 0x20, 0x65, 0x6E, 0x64, 0x00, 0x65, 0x6E, 0x64, 0x0A,
+};
+
+static const char cobs_text[] =
+	"cobs link up\r\n"
+	"cobs text frame\n"
+	"between frames\n"
+	"no line end\n"
+	"end\n";
+
+static const uint8_t cobs_frame0[] = {
+	0x00, 0x11, 0x00, 0x00, 0x22, 0xFF,
+};
+
+static const uint8_t cobs_frame1[] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B,
+	0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+	0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23,
+	0x24, 0x25, 0x26, 0x27,
+};
+
+static const uint8_t plain_stream[] = {
+	0x70, 0x6C, 0x61, 0x69, 0x6E, 0x20, 0x73, 0x74, 0x61, 0x72, 0x74, 0x0A,
+	0x61, 0x02, 0x02, 0x62, 0x0A, 0x02, 0x46, 0x40, 0x00, 0x0B, 0x6B, 0x65,
+	0x79, 0x20, 0x25, 0x63, 0x25, 0x63, 0x25, 0x63, 0x7C, 0x60, 0x02, 0x02,
+	0x4C, 0x40, 0x00, 0x03, 0x6B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x0A, 0x00, 0x00, 0x00, 0x6E, 0x65, 0x6E, 0x64, 0x0A,
+};
+
+static const char plain_text[] =
+	"plain start\n"
+	"a\x02\x02""b\n"
+	"\x02""key k..|\n"
+	"end\n";
+
+static const struct _stream streams[] = {
+	{
+		"slip", FRAMING_SLIP, slip_stream, sizeof(slip_stream), slip_text,
+		{ { slip_frame0, sizeof(slip_frame0) },
+		  { slip_frame1, sizeof(slip_frame1) } },
+	}, {
+		"cobs", FRAMING_COBS, cobs_stream, sizeof(cobs_stream), cobs_text,
+		{ { cobs_frame0, sizeof(cobs_frame0) },
+		  { cobs_frame1, sizeof(cobs_frame1) } },
+	}, {
+		"plain", FRAMING_NONE, plain_stream, sizeof(plain_stream),
+		plain_text, { { NULL, 0 } },
+	},
+};
+
+static const uint32_t segment_sizes[] = { 1, 2, 3, 5, 8, 13, 64, 4096 };
+
+static struct _pipeline pipe;
+static struct _framing framing;
+static struct _pipe_stage framing_stage;
+static struct _lzss lzss;
+static struct _pipe_stage lzss_stage;
+static struct _binlog binlog;
+static struct _pipe_stage binlog_stage;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _framing_stage(struct _pipe_stage *stage, const uint8_t *data,
+			   uint32_t len)
+{
+	framing_feed((struct _framing *)stage->ctx, data, len);
+}
+
+static void _framing_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _framing_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_frame((struct _pipe_stage *)arg, data, len);
+}
+
+static void _lzss_stage(struct _pipe_stage *stage, const uint8_t *data,
+			uint32_t len)
+{
+	lzss_feed((struct _lzss *)stage->ctx, data, len);
+}
+
+static void _lzss_out(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _binlog_stage(struct _pipe_stage *stage, const uint8_t *data,
+			  uint32_t len)
+{
+	binlog_feed((struct _binlog *)stage->ctx, data, len);
+}
+
+static void _binlog_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _binlog_line(void *arg, const char *line, uint32_t len)
+{
+	static const uint8_t eol = '\n';
+
+	pipe_emit((struct _pipe_stage *)arg, (const uint8_t *)line, len);
+	pipe_emit((struct _pipe_stage *)arg, &eol, 1);
+}
+
+static void _rx_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct _output *out = (struct _output *)arg;
+
+	if (out->text_len + len <= sizeof(out->text))
+		memcpy(&out->text[out->text_len], data, len);
+	out->text_len += len;
+	out->text_calls++;
+}
+
+static void _rx_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct _output *out = (struct _output *)arg;
+
+	if (out->frame_count < MAX_FRAMES) {
+		memcpy(out->frames[out->frame_count], data, len);
+		out->frame_len[out->frame_count] = len;
+	}
+	out->frame_count++;
+}
+
+/**
+ * Feed a stream in segments and check what comes out of the pipeline.
+ *
+ * \return true if the text and frames are the recorded ones.
+ */
+static bool _check(const struct _stream *st, uint32_t segment)
+{
+	static struct _output out;
+	uint32_t pos, n, i, frames = 0;
+	bool ok;
+
+	memset(&out, 0, sizeof(out));
+	pipeline_init(&pipe, _rx_text, _rx_frame, &out);
+	framing_init(&framing, st->framing, _framing_text, _framing_frame,
+		     &framing_stage);
+	pipeline_add(&pipe, &framing_stage, "framing", _framing_stage, &framing);
+	lzss_init(&lzss, _lzss_out, &lzss_stage);
+	pipeline_add(&pipe, &lzss_stage, "lzss", _lzss_stage, &lzss);
+	binlog_init(&binlog, _binlog_text, _binlog_line, &binlog_stage);
+	pipeline_add(&pipe, &binlog_stage, "binlog", _binlog_stage, &binlog);
+
+	for (pos = 0; pos < st->len; pos += n) {
+		n = st->len - pos < segment ? st->len - pos : segment;
+		pipeline_feed(&pipe, &st->data[pos], n);
+	}
+
+	while (frames < MAX_FRAMES && st->frames[frames].data)
+		frames++;
+	ok = out.text_len == strlen(st->text) &&
+	     memcmp(out.text, st->text, out.text_len) == 0 &&
+	     out.frame_count == frames;
+	for (i = 0; ok && i < frames; i++)
+		ok = out.frame_len[i] == st->frames[i].len &&
+		     memcmp(out.frames[i], st->frames[i].data,
+			    st->frames[i].len) == 0;
+
+	printf("%s, %4u byte segments: %3u text bytes in %3u calls, "
+	       "%u frames%s\n", st->name, (unsigned)segment,
+	       (unsigned)out.text_len, (unsigned)out.text_calls,
+	       (unsigned)out.frame_count, ok ? "" : ", MISMATCH");
+	if (!ok)
+		printf("%.*s\n", (int)out.text_len, out.text);
+	return ok;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t s, i, bad = 0, checks = 0;
+
+	for (s = 0; s < ARRAY_SIZE(streams); s++) {
+		for (i = 0; i < ARRAY_SIZE(segment_sizes); i++) {
+			bad += !_check(&streams[s], segment_sizes[i]);
+			checks++;
+		}
+	}
+	printf("bad %u of %u\n", (unsigned)bad, (unsigned)checks);
+	return bad != 0;
+}
@@ -0,0 +1,264 @@
+/**
+ * \file
+ *
+ * Host check of the incremental view rendering against full repaints.
+ *
+ * view.c is built against a character screen: every character is one
+ * pixel wide and every row one pixel high, so the drawing calls write a
+ * grid of characters. Lines are committed and collapsed the way the
+ * firmware does, and after every render the screen drawn incrementally
+ * must equal a repaint of the same store from scratch. A row showing the
+ * skipped lines marker is left out, a repaint has no lines to skip.
+ *
+ * The fixed sequences are the ones the repeat count shortcut has to get
+ * right; random runs then mix new lines, some reaching the repeat count
+ * cells, repeats and renders, without and with the time column. The store
+ * measures the lines for the view as the firmware sets it up.
+ *
+ * Build and run from the example directory:
+ *
+ *   gcc -std=gnu99 -O2 -Wall -Wextra -I. -o view_test host/view_test.c \
+ *       view.c line_store.c
+ *   ./view_test
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lcd_draw.h"
+#include "lcd_font.h"
+#include "line_store.h"
+#include "view.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+/** Screen of the view, one character per pixel */
+#define SCREEN_WIDTH		VIEW_COLUMNS
+#define SCREEN_ROWS		6
+
+/** History slots */
+#define STORE_LINES		16
+
+/** Steps of the random run */
+#define RANDOM_STEPS		20000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Screen the drawing calls write */
+static char (*screen)[SCREEN_WIDTH];
+
+static char incremental[SCREEN_ROWS][SCREEN_WIDTH];
+static char repainted[SCREEN_ROWS][SCREEN_WIDTH];
+
+static struct _line lines[STORE_LINES];
+static uint16_t tags[STORE_LINES];
+static struct _line_store store;
+static struct _view view;
+
+static uint32_t seed = 1;
+
+/*----------------------------------------------------------------------------
+ *        Drawing calls of view.c
+ *----------------------------------------------------------------------------*/
+
+bool lcd_begin_band(uint32_t y, uint32_t height)
+{
+	(void)y;
+	(void)height;
+	return false;
+}
+
+void lcd_end_band(void)
+{
+}
+
+void lcd_clean_rows(uint32_t y, uint32_t height)
+{
+	(void)y;
+	(void)height;
+}
+
+void lcd_draw_filled_rectangle(uint32_t x1, uint32_t y1, uint32_t x2,
+			       uint32_t y2, uint32_t color)
+{
+	uint32_t y;
+
+	(void)color;
+	for (y = y1; y <= y2 && y < SCREEN_ROWS; y++)
+		memset(&screen[y][x1], ' ', x2 + 1 - x1);
+}
+
+void lcd_draw_string(uint32_t x, uint32_t y, const char *text, uint32_t color)
+{
+	(void)color;
+	for (; *text && x < SCREEN_WIDTH; text++, x++)
+		screen[y][x] = *text;
+}
+
+uint32_t lcd_char_advance(uint8_t c)
+{
+	(void)c;
+	return 1;
+}
+
+int32_t lcd_char_kerning(uint8_t prev, uint8_t c)
+{
+	(void)prev;
+	(void)c;
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Advance of a character to the store, one cell as drawn.
+ */
+static uint32_t _advance(char prev, char ch)
+{
+	return lcd_char_kerning(prev, ch) + lcd_char_advance(ch);
+}
+
+static uint32_t _rand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+/**
+ * Receive a line: it is collapsed into the newest line if equal to it.
+ */
+static void _add(const char *text)
+{
+	for (; *text; text++)
+		line_store_putc(&store, *text);
+	if (!line_store_collapse(&store))
+		line_store_commit(&store);
+}
+
+/**
+ * Render and compare with a repaint from scratch.
+ *
+ * \return true if both screens are the same.
+ */
+static bool _render(void)
+{
+	static struct _view fresh;
+	uint32_t row;
+	bool ok;
+
+	screen = incremental;
+	view_render(&view);
+
+	screen = repainted;
+	memset(repainted, '#', sizeof(repainted));
+	fresh = view;
+	view_reset(&fresh);
+	view_render(&fresh);
+
+	ok = true;
+	for (row = 0; row < SCREEN_ROWS; row++) {
+		if (memcmp(incremental[row], "-- ", 3) != 0 &&
+		    memcmp(incremental[row], repainted[row], SCREEN_WIDTH) != 0)
+			ok = false;
+	}
+	if (!ok) {
+		for (row = 0; row < SCREEN_ROWS; row++)
+			printf("  |%.*s| |%.*s|\n", SCREEN_WIDTH, incremental[row],
+			       SCREEN_WIDTH, repainted[row]);
+	}
+	return ok;
+}
+
+static void _start(uint8_t time_mode)
+{
+	memset(&store, 0, sizeof(store));
+	line_store_init(&store, lines, tags, STORE_LINES);
+	view_init(&view, &store, 0, 0, SCREEN_WIDTH, SCREEN_ROWS, 1, 0, 0);
+	line_store_set_width(&store, _advance, SCREEN_WIDTH,
+			     view_fit_width(&view));
+	view_set_time_mode(&view, time_mode);
+	memset(incremental, '#', sizeof(incremental));
+}
+
+/**
+ * Run a sequence: a line text, or "" to render.
+ *
+ * \return true if every render equals a repaint.
+ */
+static bool _sequence(const char *name, const char *const *steps,
+			  uint32_t count)
+{
+	uint32_t i, bad = 0;
+
+	_start(VIEW_TIME_OFF);
+	for (i = 0; i < count; i++) {
+		if (*steps[i])
+			_add(steps[i]);
+		else
+			bad += !_render();
+	}
+	printf("%s: %s\n", name, bad ? "MISMATCH" : "ok");
+	return bad == 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	static const char *const new_then_repeat[] =
+		{ "A", "", "B", "B", "" };
+	static const char *const repeat_then_new[] =
+		{ "A", "", "A", "B", "" };
+	static const char *const repeat_only[] =
+		{ "A", "", "A", "", "A", "A", "" };
+	static const char *const both[] =
+		{ "A", "A", "", "A", "B", "B", "", "C", "" };
+	static const char *const words[] = {
+		"A", "B", "C",
+		"a line long enough to reach the repeat count cells of its row",
+	};
+	static const uint8_t time_modes[] = { VIEW_TIME_OFF, VIEW_TIME_ABSOLUTE };
+	uint32_t i, mode, bad = 0, checks = 4;
+
+	bad += !_sequence("new line then its repeat", new_then_repeat,
+			 ARRAY_SIZE(new_then_repeat));
+	bad += !_sequence("repeat then new line", repeat_then_new,
+			 ARRAY_SIZE(repeat_then_new));
+	bad += !_sequence("repeats only", repeat_only, ARRAY_SIZE(repeat_only));
+	bad += !_sequence("repeats on both", both, ARRAY_SIZE(both));
+
+	for (mode = 0; mode < ARRAY_SIZE(time_modes); mode++) {
+		uint32_t renders = 0;
+
+		_start(time_modes[mode]);
+		for (i = 0; i < RANDOM_STEPS; i++) {
+			if (_rand() % 4) {
+				_add(words[_rand() % ARRAY_SIZE(words)]);
+			} else {
+				bad += !_render();
+				renders++;
+			}
+		}
+		printf("random, time mode %u: %u renders\n",
+		       (unsigned)time_modes[mode], (unsigned)renders);
+		checks += renders;
+	}
+
+	printf("bad %u of %u\n", (unsigned)bad, (unsigned)checks);
+	return bad != 0;
+}
@@ -44,9 +44,11 @@
 #include "compiler.h"
 
 #include "display/lcdc.h"
+#include "mm/cache.h"
 
 #include "lcd_draw.h"
 #include "lcd_font.h"
+#include "lcd_shadow.h"
 #include "font.h"
 
 #include <string.h>
@@ -57,8 +59,55 @@
  *        Local variable
  *----------------------------------------------------------------------------*/
 
-/** Front color cache */
+/** Front color cache, in the format of the canvas */
 static uint32_t front_color;
+/** RGB color and canvas format front_color was converted for */
+static uint32_t front_rgb;
+static uint8_t front_bpp;
+
+/** Palette of 8 bpp canvases */
+static const uint32_t *palette;
+static uint32_t palette_size;
+
+/** Pixel masks of the 8 pixels of every glyph byte, MSB first, in the
+ * format glyph_mask_bpp: 8 to 32 bytes per entry */
+static uint32_t glyph_masks[256][8];
+static uint8_t glyph_mask_bpp;
+
+/** Glyph colors repeated over 8 pixels, converted to the format glyph_bpp */
+static uint32_t glyph_fg[8];
+static uint32_t glyph_bg[8];
+static uint32_t glyph_fg_rgb;
+static uint32_t glyph_bg_rgb;
+static uint8_t glyph_bpp;
+
+/** Blend ramps of the last color pairs drawn with: the pixel values of
+ * alpha 0 (bg) to 15 (fg), in the format bpp. Replaced round robin */
+#define ALPHA_RAMPS	4
+static struct {
+	uint32_t fg;
+	uint32_t bg;
+	uint8_t bpp;		/* 0 for an unused ramp */
+	uint32_t pixel[16];
+} alpha_ramps[ALPHA_RAMPS];
+static uint32_t alpha_next;
+
+/** Bits of every byte repeated scale_bits_of times, MSB first, in the low
+ * 8 x scale_bits_of bits */
+static uint32_t scale_bits[256];
+static uint8_t scale_bits_of;	/* 0 until computed */
+
+/** Staging band of canvas rows, see lcd_begin_band() */
+static uint8_t *band_buffer;
+static uint32_t band_size;
+static uint32_t band_y;
+static uint32_t band_height;	/* 0 while no band is open */
+
+/** Rotation of the screen on the canvas, degrees clockwise */
+static uint16_t rotation;
+
+/** Pixels between two word aligned pixels, per color width */
+static const uint8_t _align_pixels[5] = { 0, 4, 2, 4, 1 };
 
 /*----------------------------------------------------------------------------
  *        Local functions
@@ -80,13 +129,409 @@ static void _show_canvas(void)
 	//lcdc_enable_layer(lcdc_get_canvas()->layer_id, true);
 }
 
+/**
+ * Convert an RGB 888 color to the pixel format of a canvas.
+ */
+static uint32_t _pixel_value(uint32_t color, uint8_t bpp)
+{
+	switch (bpp) {
+	case 8:			/* palette index */
+		return lcd_closest_color(palette, palette_size, color);
+	case 16:		/* RGB 565 */
+		return ((color >> 8) & 0xF800) | ((color >> 5) & 0x07E0) |
+		       ((color >> 3) & 0x001F);
+	default:
+		return color;
+	}
+}
+
 /**
  * Set front color
- * \param color Pixel color.
+ * \param color Pixel color, RGB 888.
  */
 static void _set_front_color(uint32_t color)
 {
-	front_color = color;
+	uint8_t bpp = lcdc_get_canvas()->bpp;
+
+	/* drawing calls set the color for every pixel, convert on change */
+	if (color == front_rgb && bpp == front_bpp)
+		return;
+	front_rgb = color;
+	front_bpp = bpp;
+	front_color = _pixel_value(color, bpp);
+}
+
+/**
+ * Address of a canvas row, in the staging band if it covers the row.
+ */
+static uint8_t *_row_address(struct _lcdc_layer *canvas, uint32_t y,
+			     uint32_t rw)
+{
+	if (y - band_y < band_height)
+		return &band_buffer[(y - band_y) * rw];
+	return &((uint8_t *)canvas->buffer)[y * rw];
+}
+
+/**
+ * Size of the screen drawn on: the canvas, turned by the rotation.
+ */
+static void _screen_size(struct _lcdc_layer *canvas, uint32_t *width,
+			 uint32_t *height)
+{
+	if (rotation == 90 || rotation == 270) {
+		*width = canvas->height;
+		*height = canvas->width;
+	} else {
+		*width = canvas->width;
+		*height = canvas->height;
+	}
+}
+
+/**
+ * Map a point of the screen to the canvas.
+ */
+static void _to_canvas(struct _lcdc_layer *canvas, uint32_t *x, uint32_t *y)
+{
+	uint32_t sx = *x, sy = *y;
+
+	switch (rotation) {
+	case 90:
+		*x = canvas->width - 1 - sy;
+		*y = sx;
+		break;
+	case 180:
+		*x = canvas->width - 1 - sx;
+		*y = canvas->height - 1 - sy;
+		break;
+	case 270:
+		*x = sy;
+		*y = canvas->height - 1 - sx;
+		break;
+	}
+}
+
+/**
+ * Clip a rectangle of the screen, corners included, and map it to the
+ * canvas: the corners are then the upper-left and lower-right ones of the
+ * canvas.
+ *
+ * \return false if the rectangle is off the screen.
+ */
+static bool _rect_to_canvas(struct _lcdc_layer *canvas, uint32_t *x1,
+			    uint32_t *y1, uint32_t *x2, uint32_t *y2)
+{
+	uint32_t width, height;
+
+	_screen_size(canvas, &width, &height);
+	if (*x1 > *x2 || *y1 > *y2 || *x1 >= width || *y1 >= height)
+		return false;
+	if (*x2 >= width)
+		*x2 = width - 1;
+	if (*y2 >= height)
+		*y2 = height - 1;
+
+	_to_canvas(canvas, x1, y1);
+	_to_canvas(canvas, x2, y2);
+	if (*x1 > *x2)
+		SWAP(*x1, *x2);
+	if (*y1 > *y2)
+		SWAP(*y1, *y2);
+	return true;
+}
+
+/**
+ * Address of a pixel of the screen in the canvas, NULL if it is off the
+ * screen.
+ */
+static uint8_t *_pixel_address(struct _lcdc_layer *canvas, uint32_t x,
+			       uint32_t y, uint32_t rw)
+{
+	uint32_t width, height;
+
+	_screen_size(canvas, &width, &height);
+	if (x >= width || y >= height)
+		return NULL;
+	_to_canvas(canvas, &x, &y);
+	return _row_address(canvas, y, rw) + x * (canvas->bpp / 8);
+}
+
+/**
+ * Repeat a pixel value over 8 pixels.
+ */
+static void _fill_pattern(uint32_t *pattern, uint32_t pixel, uint32_t cw)
+{
+	uint8_t *bytes = (uint8_t *)pattern;
+	uint32_t p;
+
+	for (p = 0; p < 8; p++)
+		memcpy(&bytes[p * cw], &pixel, cw);
+}
+
+/**
+ * Prepare the tables of _draw_glyph_rows() for the canvas format and the
+ * given colors, only what changed is computed again.
+ */
+static void _set_glyph_colors(uint32_t fg, uint32_t bg)
+{
+	uint8_t bpp = lcdc_get_canvas()->bpp;
+	uint32_t cw = bpp / 8;
+	uint32_t b, p;
+
+	if (bpp != glyph_mask_bpp) {
+		memset(glyph_masks, 0, sizeof(glyph_masks));
+		for (b = 0; b < 256; b++) {
+			uint8_t *entry = (uint8_t *)glyph_masks[b];
+
+			for (p = 0; p < 8; p++) {
+				if (b & (0x80 >> p))
+					memset(&entry[p * cw], 0xFF, cw);
+			}
+		}
+		glyph_mask_bpp = bpp;
+	}
+
+	if (bpp != glyph_bpp || fg != glyph_fg_rgb) {
+		_fill_pattern(glyph_fg, _pixel_value(fg, bpp), cw);
+		glyph_fg_rgb = fg;
+	}
+	if (bpp != glyph_bpp || bg != glyph_bg_rgb) {
+		_fill_pattern(glyph_bg, _pixel_value(bg, bpp), cw);
+		glyph_bg_rgb = bg;
+	}
+	glyph_bpp = bpp;
+}
+
+/**
+ * Find or compute the blend ramp of a color pair for the canvas format.
+ */
+static const uint32_t *_alpha_ramp(uint32_t fg, uint32_t bg)
+{
+	uint8_t bpp = lcdc_get_canvas()->bpp;
+	uint32_t i, a;
+
+	for (i = 0; i < ALPHA_RAMPS; i++) {
+		if (alpha_ramps[i].bpp == bpp && alpha_ramps[i].fg == fg &&
+		    alpha_ramps[i].bg == bg)
+			return alpha_ramps[i].pixel;
+	}
+
+	i = alpha_next;
+	alpha_next = (alpha_next + 1) % ALPHA_RAMPS;
+	alpha_ramps[i].fg = fg;
+	alpha_ramps[i].bg = bg;
+	alpha_ramps[i].bpp = bpp;
+	for (a = 0; a < 16; a++)
+		alpha_ramps[i].pixel[a] = _pixel_value(lcd_blend_color(fg, bg, a),
+						       bpp);
+	return alpha_ramps[i].pixel;
+}
+
+/**
+ * Store a pixel value of \a cw bytes.
+ */
+static void _put_pixel(uint8_t *p, uint32_t value, uint32_t cw)
+{
+	switch (cw) {
+	case 1:
+		p[0] = value;
+		break;
+	case 2:			/* halfword aligned */
+		*(uint16_t *)p = value;
+		break;
+	case 3:
+		p[0] = value;
+		p[1] = value >> 8;
+		p[2] = value >> 16;
+		break;
+	default:		/* word aligned */
+		*(uint32_t *)p = value;
+		break;
+	}
+}
+
+/**
+ * Store 8 pixels of a scaled glyph row, as _draw_glyph_rows() does: \a ink
+ * selects the text color, pixels outside \a cell_bits are kept.
+ */
+static void _store_chunk(uint32_t *out, uint8_t ink, uint8_t cell_bits,
+			 uint32_t words, bool opaque)
+{
+	const uint32_t *m = glyph_masks[ink];
+	uint32_t i;
+
+	if (!opaque) {
+		for (i = 0; i < words; i++) {
+			if (m[i])
+				out[i] = (out[i] & ~m[i]) | (glyph_fg[i] & m[i]);
+		}
+	} else if (cell_bits == 0xFF) {
+		for (i = 0; i < words; i++)
+			out[i] = (glyph_fg[i] & m[i]) | (glyph_bg[i] & ~m[i]);
+	} else {
+		const uint32_t *w = glyph_masks[cell_bits];
+
+		for (i = 0; i < words; i++) {
+			if (w[i])
+				out[i] = (out[i] & ~w[i]) |
+					 (((glyph_fg[i] & m[i]) |
+					   (glyph_bg[i] & ~m[i])) & w[i]);
+		}
+	}
+}
+
+/**
+ * Draw glyph rows 8 pixels at a time, see lcd_draw_glyph().
+ *
+ * Rows are shifted so that they start on a word aligned pixel. Every byte
+ * of a row then covers 2 to 8 words of the canvas: the colors are selected
+ * with the pixel mask of the byte, whole words are stored. Pixels outside
+ * the glyph, and the clear pixels of transparent glyphs, are kept with the
+ * mask of the bits to draw.
+ */
+static void _draw_glyph_rows(uint32_t x, uint32_t y, const uint16_t *rows,
+			     uint32_t width, uint32_t height, bool opaque)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	uint32_t words = 2 * cw;	/* words of 8 pixels */
+	uint32_t shift, cell, chunks, row, k, i;
+	uint8_t *line;
+
+	if (canvas->buffer == NULL || x >= canvas->width || y >= canvas->height)
+		return;
+	if (width > canvas->width - x)
+		width = canvas->width - x;
+	if (height > canvas->height - y)
+		height = canvas->height - y;
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+	shift = x % _align_pixels[cw];
+	cell = (((0xFFFFu << (16 - width)) & 0xFFFF) << 16) >> shift;
+	chunks = (shift + width + 7) / 8;
+	for (row = 0; row < height; row++) {
+		uint32_t ink = (((uint32_t)rows[row] << 16) >> shift) & cell;
+		uint32_t *out;
+
+		line = _row_address(canvas, y + row, rw) + (x - shift) * cw;
+		out = (uint32_t *)line;
+
+		for (k = 0; k < chunks; k++, out += words) {
+			const uint32_t *m = glyph_masks[(ink >> (24 - 8 * k)) & 0xFF];
+			uint8_t cell_bits = cell >> (24 - 8 * k);
+
+			if (!opaque) {
+				for (i = 0; i < words; i++) {
+					if (m[i])
+						out[i] = (out[i] & ~m[i]) | (glyph_fg[i] & m[i]);
+				}
+			} else if (cell_bits == 0xFF) {
+				for (i = 0; i < words; i++)
+					out[i] = (glyph_fg[i] & m[i]) | (glyph_bg[i] & ~m[i]);
+			} else {
+				const uint32_t *w = glyph_masks[cell_bits];
+
+				for (i = 0; i < words; i++) {
+					if (w[i])
+						out[i] = (out[i] & ~w[i]) |
+							 (((glyph_fg[i] & m[i]) |
+							   (glyph_bg[i] & ~m[i])) & w[i]);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Compute scale_bits for a scale, if it is not the one computed.
+ */
+static void _set_scale_bits(uint32_t scale)
+{
+	uint32_t b, p, k;
+
+	if (scale == scale_bits_of)
+		return;
+	for (b = 0; b < 256; b++) {
+		scale_bits[b] = 0;
+		for (p = 0; p < 8; p++) {
+			if (!(b & (0x80 >> p)))
+				continue;
+			for (k = 0; k < scale; k++)
+				scale_bits[b] |= 1u << ((8 - p) * scale - 1 - k);
+		}
+	}
+	scale_bits_of = scale;
+}
+
+/**
+ * Widen a glyph row \a scale times, MSB aligned.
+ */
+static uint64_t _scale_row(uint16_t row, uint32_t scale)
+{
+	uint64_t wide = ((uint64_t)scale_bits[row >> 8] << (8 * scale)) |
+			scale_bits[row & 0xFF];
+
+	return wide << (64 - 16 * scale);
+}
+
+/**
+ * Draw glyph rows scaled up, see lcd_draw_scaled_glyph().
+ *
+ * A row is widened through scale_bits and stored 8 pixels at a time as in
+ * _draw_glyph_rows(). Its copies below are the same pixels: opaque glyphs
+ * copy the first one, transparent glyphs store it again over what is
+ * under them.
+ */
+static void _draw_scaled_rows(uint32_t x, uint32_t y, const uint16_t *rows,
+			      uint32_t width, uint32_t height, uint32_t scale,
+			      bool opaque)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	uint32_t words = 2 * cw;	/* words of 8 pixels */
+	uint32_t sw = width * scale;	/* scaled width */
+	uint32_t shift, chunks, row, copy, k;
+	uint64_t cell;
+
+	if (canvas->buffer == NULL || x >= canvas->width || y >= canvas->height)
+		return;
+	if (sw > canvas->width - x)
+		sw = canvas->width - x;
+	if (sw == 0)
+		return;
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+	shift = x % _align_pixels[cw];
+	cell = (~0ull << (64 - sw)) >> shift;
+	chunks = (shift + sw + 7) / 8;
+	for (row = 0; row < height; row++) {
+		uint64_t ink = (_scale_row(rows[row], scale) >> shift) & cell;
+		uint8_t *first = NULL;
+
+		for (copy = 0; copy < scale; copy++) {
+			uint32_t ty = y + row * scale + copy;
+			uint8_t *line;
+			uint32_t *out;
+
+			if (ty >= canvas->height)
+				return;
+			line = _row_address(canvas, ty, rw) + (x - shift) * cw;
+			if (first) {
+				memcpy(&line[shift * cw], &first[shift * cw], sw * cw);
+				continue;
+			}
+
+			out = (uint32_t *)line;
+			for (k = 0; k < chunks; k++, out += words)
+				_store_chunk(out, ink >> (56 - 8 * k),
+					     cell >> (56 - 8 * k), words, opaque);
+			if (opaque)
+				first = line;
+		}
+	}
 }
 
 /**
@@ -109,12 +554,29 @@ static void _draw_pixel(uint32_t dwX, uint32_t dwY)
 	if (buffer == NULL)
 		return;
 
+	if (rotation) {
+		uint32_t width, height;
+
+		_screen_size(pDisp, &width, &height);
+		if (dwX >= width || dwY >= height)
+			return;
+		_to_canvas(pDisp, &dwX, &dwY);
+	}
+
+	if (lcd_shadow_enabled()) {
+		lcd_shadow_pixel(dwX, dwY, lcd_shadow_index(front_rgb));
+		return;
+	}
+
 	if (rw & 0x3)
 		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[dwY * rw + cw * dwX];
+	pPix = _row_address(pDisp, dwY, rw) + cw * dwX;
 
 	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
+	case 8:			/* palette index */
+		pPix[0] = front_color;
+		break;
+	case 16:		/* RGB 565 */
 		pPix[0] = (front_color) & 0xFF;
 		pPix[1] = (front_color >> 8) & 0xFF;
 		break;
@@ -145,29 +607,43 @@ static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY
 	uint16_t w = pDisp->width;
 	uint16_t cw = pDisp->bpp / 8;	/* color width */
 	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *base;
 	uint8_t *buffer = pDisp->buffer;
 	uint32_t fillStart, fillEnd;
 	uint32_t i;
 	if (buffer == NULL)
 		return;
 
+	/* a rectangle of the screen is one of the canvas: rows of contiguous
+	 * pixels whatever the rotation */
+	if (rotation && !_rect_to_canvas(pDisp, &dwX1, &dwY1, &dwX2, &dwY2))
+		return;
+
+	if (lcd_shadow_enabled()) {
+		lcd_shadow_fill(dwX1, dwY1, dwX2, dwY2, lcd_shadow_index(front_rgb));
+		return;
+	}
+
 	/* 4-byte aligned rows */
 	if (rw & 0x3)
 		rw = (rw | 0x3) + 1;
-	/* Buffer address for the starting row */
-	base = &buffer[dwY1 * rw];
-
 	fillStart = dwX1 * cw;
 	fillEnd = dwX2 * cw;
 
+	if (cw == 1) {
+		/* palette index, whole row at once */
+		for (; dwY1 <= dwY2; dwY1++) {
+			buffer = _row_address(pDisp, dwY1, rw);
+			memset(&buffer[fillStart], front_color, fillEnd - fillStart + 1);
+		}
+		return;
+	}
+
 #if 1				/* Memcopy pixel */
-	buffer = base;
 	for (; dwY1 <= dwY2; dwY1++) {
+		buffer = _row_address(pDisp, dwY1, rw);
 		for (i = fillStart; i <= fillEnd; i += cw) {
 			memcpy(&buffer[i], &front_color, cw);
 		}
-		buffer = &buffer[rw];
 	}
 #endif
 
@@ -180,6 +656,10 @@ static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY
 #endif
 
 #if 0				/* Optimized */
+	uint8_t *base;
+
+	/* Buffer address for the starting row */
+	base = &buffer[dwY1 * rw];
 	/* First row */
 	for (i = fillStart; i <= fillEnd; i += cw) {
 		memcpy(&base[i], &front_color, cw);
@@ -193,6 +673,55 @@ static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY
 #endif
 }
 
+/**
+ * Draw glyph rows at canvas coordinates, scaled up by \a scale, to the
+ * shadow or the canvas.
+ */
+static void _draw_canvas_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+			       uint32_t width, uint32_t height, uint32_t scale,
+			       uint32_t color, uint32_t bg, bool opaque)
+{
+	if (scale > 1)
+		_set_scale_bits(scale);
+
+	if (lcd_shadow_enabled()) {
+		/* strips of 16 pixels, rows repeated */
+		uint16_t strip[LCD_GLYPH_MAX_ROWS * LCD_TEXT_MAX_SCALE];
+		uint32_t sw = width * scale;
+		uint32_t left, row, copy;
+
+		if (scale == 1) {
+			lcd_shadow_glyph(x, y, rows, width, height,
+					 lcd_shadow_index(color),
+					 opaque ? lcd_shadow_index(bg) : 0, opaque);
+			return;
+		}
+		for (left = 0; left < sw; left += 16) {
+			for (row = 0; row < height; row++) {
+				uint16_t bits = _scale_row(rows[row], scale) >>
+						(48 - left);
+
+				for (copy = 0; copy < scale; copy++)
+					strip[row * scale + copy] = bits;
+			}
+			lcd_shadow_glyph(x + left, y, strip,
+					 sw - left < 16 ? sw - left : 16,
+					 height * scale, lcd_shadow_index(color),
+					 opaque ? lcd_shadow_index(bg) : 0, opaque);
+		}
+		return;
+	}
+
+	/* transparent glyphs keep the background pattern */
+	_set_glyph_colors(color, opaque ? bg : glyph_bg_rgb);
+	_hide_canvas();
+	if (scale == 1)
+		_draw_glyph_rows(x, y, rows, width, height, opaque);
+	else
+		_draw_scaled_rows(x, y, rows, width, height, scale, opaque);
+	_show_canvas();
+}
+
 /**
  * \brief Draw a line on LCD, which is not horizontal or vertical.
  *
@@ -281,6 +810,222 @@ static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief Set the palette of 8 bpp canvases and load it in the color
+ * lookup table of the canvas layer.
+ *
+ * Colors are drawn with the closest palette entry.
+ *
+ * \param colors  RGB 888 colors, index 0 first.
+ * \param count   Number of colors, at most 255.
+ */
+void lcd_set_palette(const uint32_t *colors, uint32_t count)
+{
+	assert(count > 0 && count < 256);
+
+	palette = colors;
+	palette_size = count;
+	front_bpp = 0;		/* convert the front and glyph colors again */
+	glyph_bpp = 0;
+	memset(alpha_ramps, 0, sizeof(alpha_ramps));
+	lcdc_set_color_lut(lcdc_get_canvas()->layer_id, (uint32_t *)colors, 8,
+			   count);
+}
+
+/**
+ * \brief Return the index of the color of a table closest to an RGB color.
+ *
+ * \param colors  RGB 888 colors.
+ * \param count   Number of colors.
+ * \param color   RGB 888 color to match.
+ */
+uint32_t lcd_closest_color(const uint32_t *colors, uint32_t count,
+			   uint32_t color)
+{
+	uint32_t i, best = 0, best_dist = UINT32_MAX;
+
+	for (i = 0; i < count; i++) {
+		int32_t dr = (int32_t)((colors[i] >> 16) & 0xFF) - (int32_t)((color >> 16) & 0xFF);
+		int32_t dg = (int32_t)((colors[i] >> 8) & 0xFF) - (int32_t)((color >> 8) & 0xFF);
+		int32_t db = (int32_t)(colors[i] & 0xFF) - (int32_t)(color & 0xFF);
+		uint32_t dist = dr * dr + dg * dg + db * db;
+
+		if (dist < best_dist) {
+			best = i;
+			best_dist = dist;
+			if (dist == 0)
+				break;
+		}
+	}
+	return best;
+}
+
+/**
+ * \brief Blend two RGB 888 colors.
+ *
+ * \param fg     Color of alpha 15.
+ * \param bg     Color of alpha 0.
+ * \param alpha  0 to 15.
+ */
+uint32_t lcd_blend_color(uint32_t fg, uint32_t bg, uint8_t alpha)
+{
+	uint32_t color = 0;
+	int shift;
+
+	for (shift = 0; shift < 24; shift += 8) {
+		int32_t f = (fg >> shift) & 0xFF;
+		int32_t b = (bg >> shift) & 0xFF;
+		int32_t d = (f - b) * alpha;
+
+		/* rounded to the nearest */
+		color |= (uint32_t)(b + (d + (d < 0 ? -7 : 7)) / 15) << shift;
+	}
+	return color;
+}
+
+/**
+ * \brief Convert an RGB 888 color to the pixel format of the canvas.
+ */
+uint32_t lcd_pixel_value(uint32_t color)
+{
+	return _pixel_value(color, lcdc_get_canvas()->bpp);
+}
+
+/**
+ * \brief Set the memory of the staging band, see lcd_begin_band().
+ *
+ * \param buffer  Band buffer, word aligned, in internal SRAM. NULL draws
+ *                straight to the canvas.
+ * \param size    Buffer size in bytes.
+ */
+void lcd_set_band_buffer(uint8_t *buffer, uint32_t size)
+{
+	assert(band_height == 0);
+
+	band_buffer = buffer;
+	band_size = buffer ? size : 0;
+}
+
+/**
+ * \brief Draw the given canvas rows in the staging band until
+ * lcd_end_band().
+ *
+ * The rows are read into the band, then drawing to them stays in the band
+ * instead of writing all over the canvas in DDR. lcd_end_band() copies the
+ * band back in one sequential copy. Bands do not nest.
+ *
+ * \param y       First row.
+ * \param height  Number of rows.
+ *
+ * \return true if the band is open, false if the rows are drawn straight
+ * to the canvas: no band buffer, band already open, rows do not fit,
+ * drawing goes to the packed shadow or the screen is rotated by 90 or 270
+ * degrees.
+ */
+bool lcd_begin_band(uint32_t y, uint32_t height)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t rw = canvas->width * (canvas->bpp / 8);
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+
+	/* rows of a portrait screen are columns of the canvas */
+	if (band_height || band_buffer == NULL || canvas->buffer == NULL ||
+	    lcd_shadow_enabled() || rotation == 90 || rotation == 270 ||
+	    y >= canvas->height)
+		return false;
+	if (height > canvas->height - y)
+		height = canvas->height - y;
+	if (height * rw > band_size)
+		return false;
+	if (rotation == 180)
+		y = canvas->height - y - height;
+
+	memcpy(band_buffer, (uint8_t *)canvas->buffer + y * rw, height * rw);
+	band_y = y;
+	band_height = height;
+	return true;
+}
+
+/**
+ * \brief Copy the staging band back to the canvas and close it.
+ *
+ * The copy is cached like any canvas write, the caller still writes the
+ * rows back from the data cache for the LCDC.
+ */
+void lcd_end_band(void)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t rw = canvas->width * (canvas->bpp / 8);
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+
+	assert(band_height);
+	memcpy((uint8_t *)canvas->buffer + band_y * rw, band_buffer,
+	       band_height * rw);
+	band_height = 0;
+}
+
+/**
+ * \brief Turn the screen on the canvas, for panels mounted turned.
+ *
+ * Every drawing function then takes coordinates on the screen: at 90
+ * degrees the screen is the canvas turned clockwise, its top row is the
+ * rightmost canvas column. Filled rectangles stay rectangles of the canvas
+ * and glyphs are drawn from rows turned beforehand, see
+ * lcd_rotate_glyph().
+ *
+ * \param degrees  0, 90, 180 or 270.
+ */
+void lcd_set_rotation(uint16_t degrees)
+{
+	assert(degrees == 0 || degrees == 90 || degrees == 180 ||
+	       degrees == 270);
+	assert(band_height == 0);
+
+	rotation = degrees;
+}
+
+/**
+ * \brief Return the rotation of the screen, in degrees.
+ */
+uint16_t lcd_get_rotation(void)
+{
+	return rotation;
+}
+
+/**
+ * \brief Write back the canvas under rows of the screen from the data
+ * cache, so the LCDC sees them.
+ *
+ * \param y       First row.
+ * \param height  Number of rows.
+ */
+void lcd_clean_rows(uint32_t y, uint32_t height)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	uint8_t *buffer = canvas->buffer;
+	uint32_t x1 = 0, y1 = y, x2 = UINT32_MAX, y2 = y + height - 1;
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+	if (buffer == NULL || height == 0 ||
+	    !_rect_to_canvas(canvas, &x1, &y1, &x2, &y2))
+		return;
+
+	if (x1 == 0 && x2 == canvas->width - 1U) {
+		cache_clean_region(&buffer[y1 * rw], (y2 - y1 + 1) * rw);
+		return;
+	}
+	/* a span of every canvas row */
+	for (; y1 <= y2; y1++)
+		cache_clean_region(&buffer[y1 * rw + x1 * cw], (x2 - x1 + 1) * cw);
+}
+
 /**
  * \brief Fills the given LCD buffer with a particular color.
  *
@@ -289,22 +1034,28 @@ static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX
 void lcd_fill(uint32_t color)
 {
 	struct _lcdc_layer *pDisp = lcdc_get_canvas();
+	uint32_t width, height;
+
+	_screen_size(pDisp, &width, &height);
 	_set_front_color(color);
 	_hide_canvas();
-	_fill_rect(0, 0, pDisp->width, pDisp->height);
+	_fill_rect(0, 0, width - 1, height - 1);
 	_show_canvas();
 }
 
 void lcd_fill_white(void)
 {
 	struct _lcdc_layer *pDisp = lcdc_get_canvas();
+	uint32_t width, height;
+
+	_screen_size(pDisp, &width, &height);
 	_hide_canvas();
 	_set_front_color(0x0000FF);
-	_fill_rect(0, 0, pDisp->width / 3, pDisp->height);
+	_fill_rect(0, 0, width / 3, height);
 	_set_front_color(0xFFFFFF);
-	_fill_rect(pDisp->width/3, 0, pDisp->width/3+pDisp->width/3, pDisp->height);
+	_fill_rect(width/3, 0, width/3+width/3, height);
 	_set_front_color(0xFF0000);
-	_fill_rect(pDisp->width/3+pDisp->width/3, 0, pDisp->width-1, pDisp->height);
+	_fill_rect(width/3+width/3, 0, width-1, height);
 	_show_canvas();
 }
 
@@ -388,6 +1139,319 @@ void lcd_draw_pixel(uint32_t x, uint32_t y, uint32_t color)
 	_show_canvas();
 }
 
+/**
+ * \brief Draw a glyph, see lcd_font_glyph().
+ *
+ * \param x       X-coordinate of the upper-left corner.
+ * \param y       Y-coordinate of the upper-left corner.
+ * \param rows    Glyph rows, bit 15 is the leftmost pixel.
+ * \param width   Glyph width, at most 16.
+ * \param height  Glyph height.
+ * \param color   Color of the set bits.
+ * \param bg      Color of the clear bits, if \a opaque.
+ * \param opaque  Whether the clear bits are drawn.
+ */
+void lcd_draw_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+		    uint32_t width, uint32_t height, uint32_t color,
+		    uint32_t bg, bool opaque)
+{
+	if (rotation) {
+		uint16_t rotated[LCD_GLYPH_MAX_ROWS];
+
+		lcd_rotate_glyph(rows, width, height, rotated);
+		lcd_draw_rotated_glyph(x, y, rotated, width, height, 1, color, bg,
+				       opaque);
+		return;
+	}
+	_draw_canvas_glyph(x, y, rows, width, height, 1, color, bg, opaque);
+}
+
+/**
+ * \brief Draw a glyph scaled up by an integer factor, see lcd_draw_glyph().
+ *
+ * Every glyph pixel becomes \a scale x \a scale pixels. Glyph rows are
+ * widened through a table of replicated bits and drawn with word stores,
+ * the copies of an opaque row are row copies.
+ *
+ * \param x       X-coordinate of the upper-left corner.
+ * \param y       Y-coordinate of the upper-left corner.
+ * \param rows    Glyph rows, bit 15 is the leftmost pixel.
+ * \param width   Glyph width before scaling, at most 16.
+ * \param height  Glyph height before scaling, at most LCD_GLYPH_MAX_ROWS.
+ * \param scale   1 to LCD_TEXT_MAX_SCALE.
+ * \param color   Color of the set bits.
+ * \param bg      Color of the clear bits, if \a opaque.
+ * \param opaque  Whether the clear bits are drawn.
+ */
+void lcd_draw_scaled_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+			   uint32_t width, uint32_t height, uint32_t scale,
+			   uint32_t color, uint32_t bg, bool opaque)
+{
+	assert(scale >= 1 && scale <= LCD_TEXT_MAX_SCALE);
+
+	if (rotation) {
+		uint16_t rotated[LCD_GLYPH_MAX_ROWS];
+
+		lcd_rotate_glyph(rows, width, height, rotated);
+		lcd_draw_rotated_glyph(x, y, rotated, width, height, scale, color,
+				       bg, opaque);
+		return;
+	}
+	_draw_canvas_glyph(x, y, rows, width, height, scale, color, bg, opaque);
+}
+
+/**
+ * \brief Render an opaque glyph into a tile: a block of pixels in the
+ * format of the canvas, drawn with lcd_draw_tiles().
+ *
+ * Tiles are copied as they are, so they can only be made while the screen
+ * is not turned and drawing goes to the canvas itself. They hold pixel
+ * values: make them again when the colors, the palette or the canvas
+ * change.
+ *
+ * \param tile    Receives the pixels, word aligned, row after row.
+ * \param size    Size of \a tile in bytes.
+ * \param rows    Glyph rows, bit 15 is the leftmost pixel.
+ * \param width   Tile width, at most 16.
+ * \param height  Tile height, at most LCD_GLYPH_MAX_ROWS.
+ * \param color   Color of the set bits.
+ * \param bg      Color of the clear bits.
+ * \return Bytes used, 0 if tiles cannot be drawn or \a size is too small.
+ */
+uint32_t lcd_make_tile(uint8_t *tile, uint32_t size, const uint16_t *rows,
+		       uint32_t width, uint32_t height, uint32_t color,
+		       uint32_t bg)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t fg_value, bg_value, row, p;
+
+	assert(width <= 16 && height <= LCD_GLYPH_MAX_ROWS);
+
+	if (rotation || lcd_shadow_enabled() || canvas->buffer == NULL ||
+	    width * height * cw > size)
+		return 0;
+
+	fg_value = _pixel_value(color, canvas->bpp);
+	bg_value = _pixel_value(bg, canvas->bpp);
+	for (row = 0; row < height; row++) {
+		for (p = 0; p < width; p++, tile += cw)
+			_put_pixel(tile, rows[row] & (0x8000 >> p) ? fg_value
+								   : bg_value, cw);
+	}
+	return width * height * cw;
+}
+
+/**
+ * \brief Draw a row of tiles, see lcd_make_tile().
+ *
+ * Tile \a i is drawn \a i x \a pitch pixels right of \a x; NULL tiles are
+ * skipped. Every canvas row is filled with one copy per tile, without any
+ * per pixel work.
+ *
+ * \param x       X-coordinate of the upper-left corner of the first tile.
+ * \param y       Y-coordinate of the upper-left corner.
+ * \param tiles   Tiles, all of \a width x \a height pixels.
+ * \param count   Number of tiles.
+ * \param pitch   Distance between two tiles, at least \a width.
+ * \param width   Tile width.
+ * \param height  Tile height.
+ */
+void lcd_draw_tiles(uint32_t x, uint32_t y, const uint8_t *const *tiles,
+		    uint32_t count, uint32_t pitch, uint32_t width,
+		    uint32_t height)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	uint32_t row, i, n;
+
+	assert(rotation == 0 && !lcd_shadow_enabled());
+
+	if (canvas->buffer == NULL || x >= canvas->width || y >= canvas->height)
+		return;
+	if (height > canvas->height - y)
+		height = canvas->height - y;
+	if (count > (canvas->width - x + pitch - 1) / pitch)
+		count = (canvas->width - x + pitch - 1) / pitch;
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+	_hide_canvas();
+	for (row = 0; row < height; row++) {
+		uint8_t *line = _row_address(canvas, y + row, rw) + x * cw;
+
+		for (i = 0; i < count; i++) {
+			if (tiles[i] == NULL)
+				continue;
+			n = canvas->width - x - i * pitch;
+			if (n > width)
+				n = width;
+			memcpy(&line[i * pitch * cw], &tiles[i][row * width * cw],
+			       n * cw);
+		}
+	}
+	_show_canvas();
+}
+
+/**
+ * \brief Turn glyph rows to the canvas, for lcd_draw_rotated_glyph().
+ *
+ * \param rows    Glyph rows, bit 15 is the leftmost pixel.
+ * \param width   Glyph width, at most 16.
+ * \param height  Glyph height, at most LCD_GLYPH_MAX_ROWS.
+ * \param out     Receives the rows as they lie on the canvas: \a width rows
+ *                at 90 and 270 degrees, \a height rows otherwise.
+ */
+void lcd_rotate_glyph(const uint16_t *rows, uint32_t width, uint32_t height,
+		      uint16_t *out)
+{
+	uint32_t gx, gy;
+
+	memset(out, 0, (rotation == 90 || rotation == 270 ? width : height) *
+	       sizeof(*out));
+	for (gy = 0; gy < height; gy++) {
+		for (gx = 0; gx < width; gx++) {
+			if (!(rows[gy] & (0x8000 >> gx)))
+				continue;
+			switch (rotation) {
+			case 90:
+				out[gx] |= 0x8000 >> (height - 1 - gy);
+				break;
+			case 180:
+				out[height - 1 - gy] |= 0x8000 >> (width - 1 - gx);
+				break;
+			case 270:
+				out[width - 1 - gx] |= 0x8000 >> gy;
+				break;
+			default:
+				out[gy] |= 0x8000 >> gx;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Draw a rotated glyph a pixel at a time, clipped to the screen.
+ */
+static void _draw_cut_glyph(uint32_t x, uint32_t y, const uint16_t *rotated,
+			    uint32_t width, uint32_t height, uint32_t scale,
+			    uint32_t color, uint32_t bg, bool opaque)
+{
+	uint32_t sx, sy;
+
+	_hide_canvas();
+	for (sy = 0; sy < height * scale; sy++) {
+		for (sx = 0; sx < width * scale; sx++) {
+			uint32_t gx = sx / scale, gy = sy / scale;
+			uint16_t bit;
+
+			switch (rotation) {
+			case 90:
+				bit = rotated[gx] << (height - 1 - gy);
+				break;
+			case 180:
+				bit = rotated[height - 1 - gy] << (width - 1 - gx);
+				break;
+			case 270:
+				bit = rotated[width - 1 - gx] << gy;
+				break;
+			default:
+				bit = rotated[gy] << gx;
+				break;
+			}
+			if (bit & 0x8000)
+				_set_front_color(color);
+			else if (opaque)
+				_set_front_color(bg);
+			else
+				continue;
+			_draw_pixel(x + sx, y + sy);
+		}
+	}
+	_show_canvas();
+}
+
+/**
+ * \brief Draw a glyph turned to the canvas with lcd_rotate_glyph().
+ *
+ * The glyph is clipped to the screen, then drawn as it lies on the canvas:
+ * at any rotation its rows are rows of the canvas, stored as for an
+ * unrotated glyph.
+ *
+ * \param x        X-coordinate of the upper-left corner, on the screen.
+ * \param y        Y-coordinate of the upper-left corner, on the screen.
+ * \param rotated  Rows from lcd_rotate_glyph().
+ * \param width    Glyph width on the screen, before scaling.
+ * \param height   Glyph height on the screen, before scaling.
+ * \param scale    1 to LCD_TEXT_MAX_SCALE.
+ * \param color    Color of the set bits.
+ * \param bg       Color of the clear bits, if \a opaque.
+ * \param opaque   Whether the clear bits are drawn.
+ */
+void lcd_draw_rotated_glyph(uint32_t x, uint32_t y, const uint16_t *rotated,
+			    uint32_t width, uint32_t height, uint32_t scale,
+			    uint32_t color, uint32_t bg, bool opaque)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint16_t clipped[LCD_GLYPH_MAX_ROWS];
+	const uint16_t *rows = rotated;
+	uint32_t screen_width, screen_height;
+	uint32_t cols = width, lines = height;	/* glyph pixels kept */
+	uint32_t skip_x = 0, skip_y = 0;	/* of the rotated rows */
+	uint32_t x2, y2, i;
+
+	_screen_size(canvas, &screen_width, &screen_height);
+	if (x >= screen_width || y >= screen_height)
+		return;
+	if (x + cols * scale > screen_width)
+		cols = (screen_width - x) / scale;
+	if (y + lines * scale > screen_height)
+		lines = (screen_height - y) / scale;
+	if ((cols < width && (screen_width - x) % scale) ||
+	    (lines < height && (screen_height - y) % scale)) {
+		/* the edge cuts a scaled pixel, which may lie before the
+		 * origin of the glyph on the canvas */
+		_draw_cut_glyph(x, y, rotated, width, height, scale, color, bg,
+				opaque);
+		return;
+	}
+	if (cols == 0 || lines == 0)
+		return;
+
+	/* the pixels cut at the right and bottom of the screen */
+	switch (rotation) {
+	case 90:
+		skip_x = height - lines;
+		break;
+	case 180:
+		skip_x = width - cols;
+		skip_y = height - lines;
+		break;
+	case 270:
+		skip_y = width - cols;
+		break;
+	}
+	if (skip_x) {
+		for (i = 0; i < (rotation == 180 ? lines : cols); i++)
+			clipped[i] = rotated[skip_y + i] << skip_x;
+		rows = clipped;
+	} else {
+		rows += skip_y;
+	}
+
+	x2 = x + cols * scale - 1;
+	y2 = y + lines * scale - 1;
+	_rect_to_canvas(canvas, &x, &y, &x2, &y2);
+	if (rotation == 90 || rotation == 270)
+		_draw_canvas_glyph(x, y, rows, lines, cols, scale, color, bg,
+				   opaque);
+	else
+		_draw_canvas_glyph(x, y, rows, cols, lines, scale, color, bg,
+				   opaque);
+}
+
 /**
  * \brief Read a pixel from LCD.
  *
@@ -412,10 +1476,15 @@ extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y)
 
 	if (rw & 0x3)
 		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[x * rw + cw * y];
+	pPix = _pixel_address(pDisp, x, y, rw);
+	if (pPix == NULL)
+		return 0;
 
 	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
+	case 8:			/* palette index */
+		color = pPix[0] < palette_size ? palette[pPix[0]] : 0;
+		break;
+	case 16:		/* RGB 565 */
 		color = pPix[0] | (pPix[1] << 8);
 		break;
 	case 24:		/*  RGB  888 */
@@ -430,6 +1499,85 @@ extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y)
 	return color;
 }
 
+/**
+ * \brief Draw an anti-aliased glyph, see lcd_set_antialiased().
+ *
+ * Every pixel takes its value from the blend ramp of the colors, indexed
+ * by its alpha. Transparent glyphs are blended toward the background of
+ * the last opaque glyph, black at first, and leave alpha 0 pixels alone.
+ * On the packed shadow, pixels of alpha 8 and more are drawn as ink. On a
+ * rotated screen every pixel is mapped to the canvas on its own.
+ *
+ * \param x       X-coordinate of the upper-left corner.
+ * \param y       Y-coordinate of the upper-left corner.
+ * \param alpha   Glyph rows of LCD_ALPHA_ROW_BYTES bytes, 4-bit alpha, the
+ *                left pixel of a byte in its high nibble.
+ * \param width   Glyph width, at most 16.
+ * \param height  Glyph height, at most LCD_GLYPH_MAX_ROWS.
+ * \param color   Text color.
+ * \param bg      Background color, if \a opaque.
+ * \param opaque  Whether alpha 0 pixels are drawn.
+ */
+void lcd_draw_alpha_glyph(uint32_t x, uint32_t y, const uint8_t *alpha,
+			  uint32_t width, uint32_t height, uint32_t color,
+			  uint32_t bg, bool opaque)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	const uint32_t *ramp;
+	uint32_t screen_width, screen_height;
+	uint32_t row, col;
+
+	if (lcd_shadow_enabled()) {
+		uint16_t rows[LCD_GLYPH_MAX_ROWS];
+
+		for (row = 0; row < height; row++) {
+			rows[row] = 0;
+			for (col = 0; col < width; col++) {
+				uint8_t a = alpha[row * LCD_ALPHA_ROW_BYTES + col / 2];
+
+				if (((col & 1) ? a & 0xF : a >> 4) >= 8)
+					rows[row] |= 0x8000 >> col;
+			}
+		}
+		lcd_draw_glyph(x, y, rows, width, height, color, bg, opaque);
+		return;
+	}
+
+	_screen_size(canvas, &screen_width, &screen_height);
+	if (canvas->buffer == NULL || x >= screen_width || y >= screen_height)
+		return;
+	if (width > screen_width - x)
+		width = screen_width - x;
+	if (height > screen_height - y)
+		height = screen_height - y;
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+
+	/* keeps the background pattern of the 1-bit glyphs in step */
+	_set_glyph_colors(color, opaque ? bg : glyph_bg_rgb);
+	ramp = _alpha_ramp(color, glyph_bg_rgb);
+
+	_hide_canvas();
+	for (row = 0; row < height; row++) {
+		const uint8_t *src = &alpha[row * LCD_ALPHA_ROW_BYTES];
+		uint8_t *out = rotation ? NULL :
+			       _row_address(canvas, y + row, rw) + x * cw;
+
+		for (col = 0; col < width; col++, out += cw) {
+			uint8_t a = (col & 1) ? src[col / 2] & 0xF : src[col / 2] >> 4;
+
+			if (!a && !opaque)
+				continue;
+			if (rotation)
+				out = _pixel_address(canvas, x + col, y + row, rw);
+			_put_pixel(out, ramp[a], cw);
+		}
+	}
+	_show_canvas();
+}
+
 /**
  * \brief Draw a line on LCD, horizontal and vertical line are supported.
  *
@@ -604,27 +1752,27 @@ void lcd_draw_filled_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR,
  */
 void lcd_draw_string(uint32_t x, uint32_t y, const char *p_string, uint32_t color)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
+	uint32_t char_space = font_param[lcd_get_selected_font()].char_space *
+			      lcd_get_text_scale();
+	uint8_t width, height;	/* of the glyphs as drawn */
+	uint32_t prefix = 0;	/* advance of the line so far */
+	uint8_t prev = 0;
 
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
+	lcd_get_glyph_size(&width, &height);
 
 	while (*p_string) {
-		if (*p_string == '\n') {
+		uint8_t c = *p_string++;
+
+		if (c == '\n') {
 			y += height + char_space;
-			x = xorg;
+			prefix = 0;
+			prev = 0;
 		} else {
-			lcd_draw_char(x, y, *p_string, color);
-			x += width + char_space;
+			prefix += lcd_char_kerning(prev, c);
+			lcd_draw_char(x + prefix, y, c, color);
+			prefix += lcd_char_advance(c);
+			prev = c;
 		}
-		p_string++;
 	}
 }
 
@@ -643,27 +1791,28 @@ void lcd_draw_string_with_bgcolor(uint32_t x, uint32_t y,
 								   uint32_t fontColor,
 								   uint32_t bgColor)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
+	uint32_t char_space = font_param[lcd_get_selected_font()].char_space *
+			      lcd_get_text_scale();
+	uint8_t width, height;	/* of the glyphs as drawn */
+	uint32_t prefix = 0;	/* advance of the line so far */
+	uint8_t prev = 0;
 
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
+	lcd_get_glyph_size(&width, &height);
 
 	while (*p_string) {
-		if (*p_string == '\n') {
-			y += height + char_space;;
-			x = xorg;
+		uint8_t c = *p_string++;
+
+		if (c == '\n') {
+			y += height + char_space;
+			prefix = 0;
+			prev = 0;
 		} else {
-			lcd_draw_char_with_bgcolor(x, y, *p_string, fontColor, bgColor);
-			x += width + char_space;;
+			prefix += lcd_char_kerning(prev, c);
+			lcd_draw_char_with_bgcolor(x + prefix, y, c, fontColor,
+						   bgColor);
+			prefix += lcd_char_advance(c);
+			prev = c;
 		}
-		p_string++;
 	}
 }
 
@@ -679,32 +1828,39 @@ void lcd_draw_string_with_bgcolor(uint32_t x, uint32_t y,
  */
 void lcd_get_string_size(const char *p_string, uint32_t * p_width, uint32_t * p_height)
 {
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
+	uint32_t char_space = font_param[lcd_get_selected_font()].char_space *
+			      lcd_get_text_scale();
+	uint8_t width, height;	/* of the glyphs as drawn */
 	uint32_t str_width = 0;
-
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
-
-	while (*p_string) {
-		if (*p_string == '\n')
-			height += height + char_space;
-		else
-			str_width += width + char_space;
-		p_string++;
+	uint32_t str_height;
+	uint32_t prefix = 0;	/* advance of the line so far */
+	uint8_t prev = 0;
+
+	lcd_get_glyph_size(&width, &height);
+	str_height = height;
+
+	for (;; p_string++) {
+		uint8_t c = *p_string;
+
+		if (c == '\n' || c == '\0') {
+			/* no spacing after the last character */
+			if (prefix > char_space && prefix - char_space > str_width)
+				str_width = prefix - char_space;
+			if (c == '\0')
+				break;
+			str_height += height + char_space;
+			prefix = 0;
+			prev = 0;
+		} else {
+			prefix += lcd_char_kerning(prev, c) + lcd_char_advance(c);
+			prev = c;
+		}
 	}
-	if (width > 0)
-		str_width -= char_space;
 
 	if (p_width != NULL)
 		*p_width = str_width;
 	if (p_height != NULL)
-		*p_height = height;
+		*p_height = str_height;
 }
 
 /**
@@ -729,6 +1885,19 @@ void lcd_draw_image(uint32_t dwX, uint32_t dwY, const uint8_t * pImage,
 	uint32_t i;
 
 	pSrc = (uint8_t *) pImage;
+	if (rotation) {
+		/* a pixel at a time, the rows of the image cross the canvas */
+		uint32_t j;
+
+		for (i = 0; i < height; i++, pSrc = &pSrc[rls]) {
+			for (j = 0; j < width; j++) {
+				pDst = _pixel_address(pDisp, dwX + j, dwY + i, rl);
+				if (pDst)
+					memcpy(pDst, &pSrc[j * cw], cw);
+			}
+		}
+		return;
+	}
 	pDst = pDisp->buffer;
 	pDst = &pDst[dwX * cw + dwY * rl];
 
@@ -36,6 +36,28 @@
  * \note Before drawing, <b>canvas</b> should be selected via
  *       lcdc_select_canvas(), or created by lcdc_create_canvas().
  *
+ * Colors are given as RGB 888 (see lcd_color.h) whatever the canvas
+ * format, and converted once per color change: 16 bpp canvases are
+ * RGB 565, 8 bpp canvases hold palette indexes, see lcd_set_palette().
+ *
+ * Drawing may go to a packed 1 or 2 bpp shadow of the canvas instead, see
+ * lcd_shadow.h, and rows may be staged in internal SRAM, see
+ * lcd_begin_band().
+ *
+ * Anti-aliased glyphs (lcd_draw_alpha_glyph()) are blended through a ramp
+ * of 16 pixel values per pair of text and background colors, computed
+ * when the pair is first drawn with.
+ *
+ * The screen may be turned on the canvas, see lcd_set_rotation(): all
+ * coordinates are then screen coordinates.
+ *
+ * Text scaled up 2 or 3 times (lcd_draw_scaled_glyph()) is drawn from the
+ * same glyphs, their rows widened through a table of replicated bits.
+ *
+ * Text drawn over and over in few colors can be rendered once into tiles
+ * of canvas pixels (lcd_make_tile()) and then drawn a row of tiles at a
+ * time by copies, see lcd_draw_tiles().
+ *
  * Following functions can use:
  * - Simple drawing:
  *   - lcdc_fill()
@@ -62,6 +84,7 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -74,6 +97,27 @@
 
 	 /** \addtogroup lcdc_draw_func LCD Drawing Functions */
 /** @{*/
+extern void lcd_set_palette(const uint32_t *colors, uint32_t count);
+
+extern uint32_t lcd_closest_color(const uint32_t *colors, uint32_t count,
+				  uint32_t color);
+
+extern uint32_t lcd_pixel_value(uint32_t color);
+
+extern uint32_t lcd_blend_color(uint32_t fg, uint32_t bg, uint8_t alpha);
+
+extern void lcd_set_band_buffer(uint8_t *buffer, uint32_t size);
+
+extern bool lcd_begin_band(uint32_t y, uint32_t height);
+
+extern void lcd_end_band(void);
+
+extern void lcd_set_rotation(uint16_t degrees);
+
+extern uint16_t lcd_get_rotation(void);
+
+extern void lcd_clean_rows(uint32_t y, uint32_t height);
+
 extern void lcd_fill_white(void);
 
 extern void lcd_fill(uint32_t color);
@@ -84,6 +128,34 @@ extern void lcd_draw_pixel(uint32_t x, uint32_t y, uint32_t c);
 
 extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y);
 
+extern void lcd_draw_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+			   uint32_t width, uint32_t height, uint32_t color,
+			   uint32_t bg, bool opaque);
+
+extern void lcd_draw_scaled_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+				  uint32_t width, uint32_t height, uint32_t scale,
+				  uint32_t color, uint32_t bg, bool opaque);
+
+extern uint32_t lcd_make_tile(uint8_t *tile, uint32_t size, const uint16_t *rows,
+			      uint32_t width, uint32_t height, uint32_t color,
+			      uint32_t bg);
+
+extern void lcd_draw_tiles(uint32_t x, uint32_t y, const uint8_t *const *tiles,
+			   uint32_t count, uint32_t pitch, uint32_t width,
+			   uint32_t height);
+
+extern void lcd_rotate_glyph(const uint16_t *rows, uint32_t width,
+			     uint32_t height, uint16_t *out);
+
+extern void lcd_draw_rotated_glyph(uint32_t x, uint32_t y,
+				   const uint16_t *rotated, uint32_t width,
+				   uint32_t height, uint32_t scale,
+				   uint32_t color, uint32_t bg, bool opaque);
+
+extern void lcd_draw_alpha_glyph(uint32_t x, uint32_t y, const uint8_t *alpha,
+				 uint32_t width, uint32_t height, uint32_t color,
+				 uint32_t bg, bool opaque);
+
 extern void lcd_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
 			  uint32_t color);
 
@@ -43,6 +43,8 @@
 #include "font.h"
 
 #include <assert.h>
+#include <stdbool.h>
+#include <string.h>
 
 /*----------------------------------------------------------------------------
  *        Local variables
@@ -53,6 +55,328 @@
 
 static uint8_t font_sel = FONT10x14;
 
+/** Glyphs cached, ASCII then the glyph ids outside it */
+#define CACHED_GLYPHS (LCD_FONT_GLYPHS + LCD_FONT_EXT_GLYPHS)
+
+/** Glyphs of the selected font, row-major whatever the layout of the font
+ * table: bit 15 of a row is the leftmost pixel */
+static uint16_t glyph_rows[CACHED_GLYPHS][LCD_GLYPH_MAX_ROWS];
+/** Size of the cached glyphs, 0 until a font is cached */
+static uint8_t glyph_width;
+static uint8_t glyph_height;
+
+/** Advance of every glyph, spacing included */
+static uint8_t glyph_advance[CACHED_GLYPHS];
+/** Whether glyphs are trimmed to their ink, see lcd_set_proportional() */
+static bool proportional;
+
+/** Kerning pairs sorted by first character, and the first pair of every
+ * character, kern_count if it has none */
+static const struct _lcd_kern_pair *kern_pairs;
+static uint32_t kern_count;
+static uint8_t kern_first[LCD_FONT_GLYPHS];
+
+/** Anti-aliased glyphs, 4-bit alpha, two pixels per byte with the left one
+ * in the high nibble; alpha_height is 0 while they are not used */
+static uint8_t alpha_glyphs[CACHED_GLYPHS][LCD_GLYPH_MAX_ROWS][LCD_ALPHA_ROW_BYTES];
+static uint8_t alpha_width;
+static uint8_t alpha_height;
+static uint8_t alpha_advance[CACHED_GLYPHS];
+
+/** Scale of the 1-bit glyphs as drawn, see lcd_set_text_scale() */
+static uint8_t text_scale = 1;
+
+/** Glyphs turned to the canvas, see lcd_set_rotation(); rotated_for is the
+ * rotation they were turned for, 0 while they are not computed */
+static uint16_t rotated_rows[CACHED_GLYPHS][LCD_GLYPH_MAX_ROWS];
+static uint16_t rotated_for;
+
+/** Pages of 256 codepoints which have glyphs outside ASCII */
+#define EXT_PAGES	8
+
+/** Codepoint index of the glyphs outside ASCII, a two-level table over
+ * the BMP: the page of every high byte, 0 for none, then the glyph id of
+ * every low byte in the page, 0 for none */
+static uint8_t ext_page[256];
+static uint8_t ext_ids[EXT_PAGES][256];
+static uint8_t ext_pages;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _set_glyph_pixel(uint16_t *rows, uint32_t x, uint32_t y)
+{
+	rows[y] |= 0x8000 >> x;
+}
+
+/**
+ * Set the glyph advances. Proportional glyphs are moved to the left edge
+ * of their cell and advance by their ink width; digits keep a common width
+ * so that numbers line up, and blank glyphs take half a cell.
+ */
+static void _set_advances(void)
+{
+	uint8_t char_space = font_param[font_sel].char_space;
+	uint8_t mono = (font_sel == FONT10x8 ? font_param[font_sel].height :
+			font_param[font_sel].width) + char_space;
+	uint8_t digits = 0;
+	uint32_t c, row;
+
+	for (c = 0; c < CACHED_GLYPHS; c++) {
+		uint16_t *rows = glyph_rows[c];
+		uint16_t ink = 0;
+		uint32_t left = 0, right = 15;
+
+		glyph_advance[c] = mono;
+		if (!proportional)
+			continue;
+
+		for (row = 0; row < glyph_height; row++)
+			ink |= rows[row];
+		if (ink == 0) {
+			glyph_advance[c] = mono / 2;
+			continue;
+		}
+		while (!(ink & (0x8000 >> left)))
+			left++;
+		while (!(ink & (0x8000 >> right)))
+			right--;
+		for (row = 0; row < glyph_height; row++)
+			rows[row] <<= left;
+		glyph_advance[c] = right - left + 1 + char_space;
+	}
+
+	if (!proportional)
+		return;
+	for (c = '0'; c <= '9'; c++) {
+		if (glyph_advance[c - LCD_FONT_FIRST_CHAR] > digits)
+			digits = glyph_advance[c - LCD_FONT_FIRST_CHAR];
+	}
+	for (c = '0'; c <= '9'; c++)
+		glyph_advance[c - LCD_FONT_FIRST_CHAR] = digits;
+}
+
+/**
+ * Width drawn for a glyph: the cell, or the ink of proportional glyphs.
+ */
+static uint8_t _drawn_width(uint8_t c)
+{
+	if (!proportional)
+		return glyph_width;
+	return glyph_advance[c - LCD_FONT_FIRST_CHAR] -
+	       font_param[font_sel].char_space;
+}
+
+/**
+ * Glyph turned to the canvas. The glyphs are turned again when the
+ * rotation changes, each by the width it is drawn with.
+ */
+static const uint16_t *_rotated_glyph(uint8_t c)
+{
+	uint16_t rotation = lcd_get_rotation();
+	uint32_t i;
+
+	if (rotation != rotated_for) {
+		for (i = 0; i < CACHED_GLYPHS; i++)
+			lcd_rotate_glyph(glyph_rows[i],
+					 _drawn_width(i + LCD_FONT_FIRST_CHAR),
+					 glyph_height, rotated_rows[i]);
+		rotated_for = rotation;
+	}
+	return rotated_rows[c - LCD_FONT_FIRST_CHAR];
+}
+
+/**
+ * Width drawn for an anti-aliased glyph.
+ */
+static uint8_t _alpha_drawn_width(uint8_t c)
+{
+	return (_drawn_width(c) * alpha_width + glyph_width - 1) / glyph_width;
+}
+
+/**
+ * Length shared by the spans [a1, a2) and [b1, b2), 0 if they are apart.
+ */
+static uint32_t _overlap(uint32_t a1, uint32_t a2, uint32_t b1, uint32_t b2)
+{
+	uint32_t from = a1 > b1 ? a1 : b1;
+	uint32_t to = a2 < b2 ? a2 : b2;
+
+	return to > from ? to - from : 0;
+}
+
+/**
+ * Alpha of a pixel of a glyph scaled to alpha_width x alpha_height.
+ *
+ * The pixel covers a box of the source glyph, the share of that box which
+ * is ink is its alpha. Boxes are measured in units of 1 / alpha_width
+ * source pixel across and 1 / alpha_height down, so that the overlaps are
+ * integers.
+ */
+static uint8_t _box_alpha(const uint16_t *rows, uint32_t tx, uint32_t ty)
+{
+	uint32_t gw = glyph_width, gh = glyph_height;
+	uint32_t aw = alpha_width, ah = alpha_height;
+	uint32_t area = 0, sx, sy;
+
+	for (sy = ty * gh / ah; sy * ah < (ty + 1) * gh; sy++) {
+		uint32_t h = _overlap(sy * ah, (sy + 1) * ah, ty * gh, (ty + 1) * gh);
+
+		for (sx = tx * gw / aw; sx * aw < (tx + 1) * gw; sx++) {
+			if (rows[sy] & (0x8000 >> sx))
+				area += h * _overlap(sx * aw, (sx + 1) * aw,
+						     tx * gw, (tx + 1) * gw);
+		}
+	}
+	/* a target pixel is gw x gh units */
+	return (area * 15 + gw * gh / 2) / (gw * gh);
+}
+
+/**
+ * Scale the cached glyphs to the anti-aliased ones.
+ */
+static void _cache_alpha(void)
+{
+	uint32_t c, tx, ty;
+
+	memset(alpha_glyphs, 0, sizeof(alpha_glyphs));
+	for (c = 0; c < CACHED_GLYPHS; c++) {
+		for (ty = 0; ty < alpha_height; ty++) {
+			for (tx = 0; tx < alpha_width; tx++) {
+				uint8_t alpha = _box_alpha(glyph_rows[c], tx, ty);
+
+				alpha_glyphs[c][ty][tx / 2] |= alpha << (tx & 1 ? 0 : 4);
+			}
+		}
+		alpha_advance[c] = (glyph_advance[c] * alpha_width +
+				    glyph_width / 2) / glyph_width;
+	}
+}
+
+/**
+ * Index the glyphs outside ASCII by codepoint, once.
+ */
+static void _index_ext(void)
+{
+	uint32_t i;
+
+	if (ext_pages)
+		return;
+	for (i = 0; i < NB_FONT_EXT; i++) {
+		uint16_t cp = font_ext10x14[i].codepoint;
+
+		if (ext_page[cp >> 8] == 0) {
+			assert(ext_pages < EXT_PAGES);
+			ext_page[cp >> 8] = ++ext_pages;
+		}
+		ext_ids[ext_page[cp >> 8] - 1][cp & 0xFF] =
+			LCD_GLYPH_REPLACEMENT + 1 + i;
+	}
+}
+
+/**
+ * Cache the glyphs outside ASCII: the replacement glyph, a box, and the
+ * 10x14 drawings scaled to the cell of the selected font.
+ */
+static void _cache_ext(void)
+{
+	uint16_t *box = glyph_rows[LCD_GLYPH_REPLACEMENT - LCD_FONT_FIRST_CHAR];
+	uint16_t side = 0x8000 | (0x8000 >> (glyph_width - 2));
+	uint32_t i, x, y;
+
+	assert(NB_FONT_EXT < LCD_FONT_EXT_GLYPHS);
+
+	for (y = 0; y < glyph_height; y++)
+		box[y] = side;
+	box[0] = box[glyph_height - 1] = (0xFFFF << (17 - glyph_width)) & 0xFFFF;
+
+	for (i = 0; i < NB_FONT_EXT; i++) {
+		const uint16_t *src = font_ext10x14[i].rows;
+		uint16_t *rows = glyph_rows[LCD_GLYPH_REPLACEMENT + 1 + i -
+					    LCD_FONT_FIRST_CHAR];
+
+		for (y = 0; y < glyph_height; y++) {
+			for (x = 0; x < glyph_width; x++) {
+				if (src[y * 14 / glyph_height] &
+				    (0x8000 >> (x * 10 / glyph_width)))
+					_set_glyph_pixel(rows, x, y);
+			}
+		}
+	}
+}
+
+/**
+ * Convert the table of the selected font to row-major glyphs, with the
+ * pixel mapping lcd_draw_char() used per font.
+ */
+static void _cache_glyphs(void)
+{
+	uint8_t width = font_param[font_sel].width;
+	uint8_t height = font_param[font_sel].height;
+	const uint8_t *pfont = font_param[font_sel].pfont;
+	uint32_t c, row, col;
+
+	memset(glyph_rows, 0, sizeof(glyph_rows));
+	for (c = 0; c < LCD_FONT_GLYPHS; c++) {
+		uint16_t *rows = glyph_rows[c];
+
+		for (col = 0; col < width; col++) {
+			switch (font_sel) {
+			case FONT10x14:
+				/* two bytes per column, 8 then 6 rows */
+				for (row = 0; row < height; row++) {
+					uint8_t ch = pfont[c * 20 + col * 2 + row / 8];
+
+					if ((ch >> (7 - row % 8)) & 0x1)
+						_set_glyph_pixel(rows, col, row);
+				}
+				break;
+			case FONT10x8:
+				/* rotated: columns are rows, bit 0 on the right */
+				for (row = 0; row < height; row++) {
+					if ((pfont[c * width + col] >> row) & 0x1)
+						_set_glyph_pixel(rows, height - row, col);
+				}
+				break;
+			case FONT8x8:
+				/* transposed */
+				for (row = 0; row < height; row++) {
+					if ((pfont[c * width + col] >> row) & 0x1)
+						_set_glyph_pixel(rows, row, col);
+				}
+				break;
+			default:
+				for (row = 0; row < height; row++) {
+					if ((pfont[c * width + col] >> row) & 0x1)
+						_set_glyph_pixel(rows, col, row);
+				}
+				break;
+			}
+		}
+	}
+
+	switch (font_sel) {
+	case FONT10x8:
+		glyph_width = height + 1;
+		glyph_height = width;
+		break;
+	case FONT8x8:
+		glyph_width = height;
+		glyph_height = width;
+		break;
+	default:
+		glyph_width = width;
+		glyph_height = height;
+		break;
+	}
+	_cache_ext();
+	_set_advances();
+	if (alpha_height)
+		_cache_alpha();
+	rotated_for = 0;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -60,6 +384,7 @@ static uint8_t font_sel = FONT10x14;
 struct _font_parameters* lcd_select_font (_FONT_enum font)
 {
 	font_sel = font;
+	_cache_glyphs();
 	return &font_param[font];
 }
 
@@ -68,61 +393,200 @@ uint8_t lcd_get_selected_font (void)
 	return font_sel;
 }
 
+/**
+ * \brief Return the glyph id of a character: the character itself in
+ * ASCII, else its glyph outside ASCII or the replacement glyph.
+ *
+ * Glyph ids are what strings hold for lcd_draw_string(). Outside ASCII
+ * the id is found through a two-level table, in constant time.
+ *
+ * \param codepoint  Unicode codepoint, 0x20 and up.
+ */
+uint8_t lcd_font_glyph_id(uint32_t codepoint)
+{
+	uint8_t page, id;
+
+	if (codepoint >= LCD_FONT_FIRST_CHAR && codepoint < 0x80)
+		return codepoint;
+	if (codepoint > 0xFFFF)
+		return LCD_GLYPH_REPLACEMENT;
+
+	_index_ext();
+	page = ext_page[codepoint >> 8];
+	if (page == 0)
+		return LCD_GLYPH_REPLACEMENT;
+	id = ext_ids[page - 1][codepoint & 0xFF];
+	return id ? id : LCD_GLYPH_REPLACEMENT;
+}
+
+/**
+ * \brief Return the cached glyph of a character, see lcd_get_glyph_size().
+ *
+ * \param c  Glyph id, see lcd_font_glyph_id().
+ *
+ * \return Glyph rows, top first, bit 15 is the leftmost pixel.
+ */
+const uint16_t* lcd_font_glyph(uint8_t c)
+{
+	assert(c >= LCD_FONT_FIRST_CHAR);
+
+	if (glyph_height == 0)
+		_cache_glyphs();
+	return glyph_rows[c - LCD_FONT_FIRST_CHAR];
+}
+
+/**
+ * \brief Return the size of the glyphs of the selected font, as drawn.
+ */
+void lcd_get_glyph_size(uint8_t *width, uint8_t *height)
+{
+	if (glyph_height == 0)
+		_cache_glyphs();
+	*width = alpha_height ? alpha_width : glyph_width * text_scale;
+	*height = alpha_height ? alpha_height : glyph_height * text_scale;
+}
+
+/**
+ * \brief Draw the selected font anti-aliased, scaled to the given size.
+ *
+ * The glyphs are computed from the selected font as 4-bit alpha, again on
+ * every font change. Scaling a larger font down keeps strokes legible at
+ * sizes the 1-bit fonts do not have. Advances scale with the glyphs;
+ * kerning does not.
+ *
+ * \param width   Glyph width, at most 16. 0 draws the font as it is.
+ * \param height  Glyph height, at most LCD_GLYPH_MAX_ROWS.
+ */
+void lcd_set_antialiased(uint8_t width, uint8_t height)
+{
+	assert(width <= 16 && height <= LCD_GLYPH_MAX_ROWS);
+
+	if (glyph_height == 0)
+		_cache_glyphs();
+	alpha_width = width;
+	alpha_height = width ? height : 0;
+	if (alpha_height)
+		_cache_alpha();
+}
+
+/**
+ * \brief Draw glyphs trimmed to their ink and advance by their width, or
+ * in fixed cells as the font tables define them.
+ */
+void lcd_set_proportional(bool enable)
+{
+	proportional = enable;
+	_cache_glyphs();
+}
+
+/**
+ * \brief Draw the 1-bit glyphs scaled up by an integer factor.
+ *
+ * Every glyph pixel is drawn as \a scale x \a scale pixels; sizes,
+ * advances and kerning scale alike, so layouts by cell or by advance keep
+ * their shape. The scale is kept across lcd_select_font(). Anti-aliased
+ * glyphs keep the size set with lcd_set_antialiased().
+ *
+ * \param scale  1 to LCD_TEXT_MAX_SCALE.
+ */
+void lcd_set_text_scale(uint8_t scale)
+{
+	assert(scale >= 1 && scale <= LCD_TEXT_MAX_SCALE);
+
+	text_scale = scale;
+}
+
+/**
+ * \brief Return the scale glyphs are drawn with, 1 for anti-aliased ones.
+ */
+uint8_t lcd_get_text_scale(void)
+{
+	return alpha_height ? 1 : text_scale;
+}
+
+/**
+ * \brief Set the kerning pairs, applied by lcd_char_kerning().
+ *
+ * \param pairs  Pairs sorted by first character, kept by reference. Pairs
+ *               whose first character is not printable ASCII (0x20 to
+ *               0x7F) are ignored.
+ * \param count  Number of pairs, less than 256. 0 disables kerning.
+ */
+void lcd_set_kerning(const struct _lcd_kern_pair *pairs, uint32_t count)
+{
+	uint32_t i;
+
+	assert(count < 256);
+
+	kern_pairs = pairs;
+	kern_count = count;
+	memset(kern_first, count, sizeof(kern_first));
+	for (i = count; i-- > 0;) {
+		assert(i == 0 || pairs[i - 1].first <= pairs[i].first);
+		/* lcd_char_kerning() never looks other characters up */
+		if (pairs[i].first < LCD_FONT_FIRST_CHAR ||
+		    pairs[i].first >= LCD_FONT_FIRST_CHAR + LCD_FONT_GLYPHS)
+			continue;
+		kern_first[pairs[i].first - LCD_FONT_FIRST_CHAR] = i;
+	}
+}
+
+/**
+ * \brief Return the advance of a character, spacing included.
+ */
+uint32_t lcd_char_advance(uint8_t c)
+{
+	if (c < LCD_FONT_FIRST_CHAR)
+		return 0;
+	if (glyph_height == 0)
+		_cache_glyphs();
+	if (alpha_height)
+		return alpha_advance[c - LCD_FONT_FIRST_CHAR];
+	return glyph_advance[c - LCD_FONT_FIRST_CHAR] * text_scale;
+}
+
+/**
+ * \brief Return the kerning of a character after another one, to add to
+ * its position.
+ */
+int32_t lcd_char_kerning(uint8_t prev, uint8_t c)
+{
+	uint32_t i;
+
+	if (kern_count == 0 || prev < LCD_FONT_FIRST_CHAR ||
+	    prev >= LCD_FONT_FIRST_CHAR + LCD_FONT_GLYPHS)
+		return 0;
+
+	for (i = kern_first[prev - LCD_FONT_FIRST_CHAR];
+	     i < kern_count && kern_pairs[i].first == prev; i++) {
+		if (kern_pairs[i].second == c)
+			return kern_pairs[i].adjust * (int32_t)lcd_get_text_scale();
+	}
+	return 0;
+}
+
 void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
-	assert((c >= 0x20) && (c <= 0x7F));
-
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, color) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, color) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, color) ;
-              }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, color) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, color) ;
-              }
-            }
-          }
-        }
-        break;
-    }
+	const uint16_t *rows = lcd_font_glyph(c);
+
+	if (alpha_height) {
+		lcd_draw_alpha_glyph(x, y, alpha_glyphs[c - LCD_FONT_FIRST_CHAR][0],
+				     _alpha_drawn_width(c), alpha_height, color, 0,
+				     false);
+		return;
+	}
+	if (lcd_get_rotation()) {
+		lcd_draw_rotated_glyph(x, y, _rotated_glyph(c), _drawn_width(c),
+				       glyph_height, text_scale, color, 0, false);
+		return;
+	}
+	if (text_scale > 1) {
+		lcd_draw_scaled_glyph(x, y, rows, _drawn_width(c), glyph_height,
+				      text_scale, color, 0, false);
+		return;
+	}
+	lcd_draw_glyph(x, y, rows, _drawn_width(c), glyph_height, color, 0,
+		       false);
 }
 
 /**
@@ -137,68 +601,54 @@ void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 void lcd_draw_char_with_bgcolor(uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor,
 			 uint32_t bgColor)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
-
-	assert((c >= 0x20) && (c <= 0x7F));
-
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row, bgColor) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row+8, bgColor) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, fontColor) ;
-			  }
-			  else {
-				  lcd_draw_pixel( x+(height-row), y+col, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, fontColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, fontColor) ;
-              }
-			  else {
-				  if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, bgColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-    }
+	const uint16_t *rows = lcd_font_glyph(c);
+
+	if (alpha_height) {
+		lcd_draw_alpha_glyph(x, y, alpha_glyphs[c - LCD_FONT_FIRST_CHAR][0],
+				     _alpha_drawn_width(c), alpha_height, fontColor,
+				     bgColor, true);
+		return;
+	}
+	if (lcd_get_rotation()) {
+		lcd_draw_rotated_glyph(x, y, _rotated_glyph(c), _drawn_width(c),
+				       glyph_height, text_scale, fontColor, bgColor,
+				       true);
+		return;
+	}
+	if (text_scale > 1) {
+		lcd_draw_scaled_glyph(x, y, rows, _drawn_width(c), glyph_height,
+				      text_scale, fontColor, bgColor, true);
+		return;
+	}
+	lcd_draw_glyph(x, y, rows, _drawn_width(c), glyph_height, fontColor,
+		       bgColor, true);
+}
+
+/**
+ * \brief Render a character on a background into a tile, see
+ * lcd_make_tile(). The glyph is drawn as lcd_draw_char() would, the rest
+ * of the tile is background.
+ *
+ * \param c      Character.
+ * \param tile   Receives the pixels, word aligned.
+ * \param size   Size of \a tile in bytes.
+ * \param width  Tile width, at most 16; the tile is as high as the glyphs.
+ * \param color  Character color.
+ * \param bg     Background color.
+ * \return Bytes used, 0 if the character cannot be drawn as a tile:
+ *         anti-aliased or scaled text, or see lcd_make_tile().
+ */
+uint32_t lcd_make_char_tile(uint8_t c, uint8_t *tile, uint32_t size,
+			    uint32_t width, uint32_t color, uint32_t bg)
+{
+	const uint16_t *rows = lcd_font_glyph(c);
+	uint16_t drawn[LCD_GLYPH_MAX_ROWS];
+	uint16_t mask = 0xFFFF << (16 - _drawn_width(c));
+	uint32_t row;
+
+	if (alpha_height || text_scale > 1)
+		return 0;
+	for (row = 0; row < glyph_height; row++)
+		drawn[row] = rows[row] & mask;
+	return lcd_make_tile(tile, size, drawn, width, glyph_height, color, bg);
 }
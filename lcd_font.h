@@ -73,8 +73,32 @@
 
 #include "font.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Characters of the fonts: 0x20 to 0x7F */
+#define LCD_FONT_FIRST_CHAR  0x20
+#define LCD_FONT_GLYPHS      96
+
+/** Glyph ids 0x80 to 0xFF stand for characters outside ASCII, see
+ * lcd_font_glyph_id(); 0x80 is the replacement glyph of characters
+ * without one */
+#define LCD_FONT_EXT_GLYPHS  128
+#define LCD_GLYPH_REPLACEMENT 0x80
+
+/** Most rows of a cached glyph, glyph rows are at most 16 pixels wide */
+#define LCD_GLYPH_MAX_ROWS   16
+
+/** Bytes of an anti-aliased glyph row: 16 pixels of 4-bit alpha */
+#define LCD_ALPHA_ROW_BYTES  8
+
+/** Largest text scale, see lcd_set_text_scale() */
+#define LCD_TEXT_MAX_SCALE   3
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -87,6 +111,13 @@ struct _font {
 	uint8_t height;	/* Font height in pixels. */
 };
 
+/** \brief Adjustment of the position of a character after another one. */
+struct _lcd_kern_pair {
+	uint8_t first;
+	uint8_t second;
+	int8_t adjust;	/* pixels, negative moves closer */
+};
+
 /*----------------------------------------------------------------------------
  *        Variables
  *----------------------------------------------------------------------------*/
@@ -103,8 +134,31 @@ extern struct _font_parameters* lcd_select_font (_FONT_enum font);
 
 extern uint8_t lcd_get_selected_font (void);
 
+extern uint8_t lcd_font_glyph_id(uint32_t codepoint);
+
+extern const uint16_t* lcd_font_glyph(uint8_t c);
+
+extern void lcd_get_glyph_size(uint8_t *width, uint8_t *height);
+
+extern void lcd_set_antialiased(uint8_t width, uint8_t height);
+
+extern void lcd_set_proportional(bool enable);
+
+extern void lcd_set_text_scale(uint8_t scale);
+
+extern uint8_t lcd_get_text_scale(void);
+
+extern void lcd_set_kerning(const struct _lcd_kern_pair *pairs, uint32_t count);
+
+extern uint32_t lcd_char_advance(uint8_t c);
+
+extern int32_t lcd_char_kerning(uint8_t prev, uint8_t c);
+
 extern void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color);
 
+extern uint32_t lcd_make_char_tile(uint8_t c, uint8_t *tile, uint32_t size,
+				   uint32_t width, uint32_t color, uint32_t bg);
+
 extern void lcd_draw_char_with_bgcolor(uint32_t x, uint32_t y, uint8_t c,
 				     uint32_t fontColor, uint32_t bgColor);
 /** @}*/
@@ -0,0 +1,326 @@
+/**
+ * \file
+ *
+ * Packed text surface, see lcd_shadow.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lcd_shadow.h"
+
+#include "display/lcdc.h"
+#include "mm/cache.h"
+
+#include "lcd_draw.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Shadow bitmap, bpp is 0 while the shadow is disabled */
+static uint8_t *bits;
+static uint8_t bpp;
+static uint32_t surface_width;
+static uint32_t surface_height;
+static uint32_t stride;		/* bytes per row */
+
+/** Shadow colors, 2 or 4 */
+static const uint32_t *colors;
+/** Last color looked up by lcd_shadow_index() */
+static uint32_t last_color;
+static uint8_t last_index;
+static bool last_valid;
+
+/** Rows changed since the last flush, one bit per row */
+static uint32_t dirty[(LCD_SHADOW_MAX_HEIGHT + 31) / 32];
+
+/** Canvas pixels of every shadow byte: 8 or 4 pixels, up to 32 bytes */
+static uint32_t lut[256][8];
+/** Words of a table entry */
+static uint32_t lut_words;
+
+/** 2 bpp: the bits of a byte spread to one pixel (bits 01) each */
+static uint16_t spread[256];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _mark_rows(uint32_t y1, uint32_t y2)
+{
+	for (; y1 <= y2; y1++)
+		dirty[y1 / 32] |= 1u << (y1 % 32);
+}
+
+/**
+ * Spread a glyph row, MSB first, to one 2-bit pixel per bit.
+ */
+static uint32_t _spread_row(uint32_t row)
+{
+	return ((uint32_t)spread[(row >> 8) & 0xFF] << 16) | spread[row & 0xFF];
+}
+
+/**
+ * Replace the bits of a row under \a mask from bit \a bit on.
+ *
+ * \param line   Shadow row.
+ * \param bit    First bit, from the MSB of the first byte.
+ * \param value  New bits, MSB aligned, zero outside \a mask.
+ * \param mask   Bits to replace, MSB aligned.
+ */
+static void _put_bits(uint8_t *line, uint32_t bit, uint32_t value,
+		      uint32_t mask)
+{
+	uint8_t *p = &line[bit / 8];
+	uint8_t *end = &line[stride];
+	uint64_t v = ((uint64_t)value << 32) >> (bit & 7);
+	uint64_t m = ((uint64_t)mask << 32) >> (bit & 7);
+
+	for (; m && p < end; p++, v <<= 8, m <<= 8) {
+		uint8_t byte_mask = m >> 56;
+
+		if (byte_mask)
+			*p = (*p & ~byte_mask) | (uint8_t)(v >> 56);
+	}
+}
+
+/**
+ * Set the pixels \a x1 to \a x2 of a row to a byte pattern.
+ */
+static void _fill_span(uint8_t *line, uint32_t x1, uint32_t x2, uint8_t pattern)
+{
+	uint32_t b1 = x1 * bpp;
+	uint32_t b2 = (x2 + 1) * bpp;
+	uint8_t *p = &line[b1 / 8];
+	uint8_t *q = &line[b2 / 8];
+	uint8_t head = 0xFF >> (b1 & 7);
+	uint8_t tail = ~(0xFF >> (b2 & 7));
+
+	if (p == q) {
+		head &= tail;
+		*p = (*p & ~head) | (pattern & head);
+		return;
+	}
+	if (b1 & 7) {
+		*p = (*p & ~head) | (pattern & head);
+		p++;
+	}
+	memset(p, pattern, q - p);
+	if (b2 & 7)
+		*q = (*q & ~tail) | (pattern & tail);
+}
+
+/**
+ * Expand a shadow row into a canvas row.
+ */
+static void _expand_row(const uint8_t *src, uint8_t *dst, uint32_t full,
+			uint32_t tail)
+{
+	uint32_t *out = (uint32_t *)dst;
+	uint32_t i, k;
+
+	for (i = 0; i < full; i++) {
+		const uint32_t *entry = lut[src[i]];
+
+		for (k = 0; k < lut_words; k++)
+			*out++ = entry[k];
+	}
+	if (tail)
+		memcpy(out, lut[src[full]], tail);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Draw to a packed shadow of the canvas from now on.
+ *
+ * The canvas must be created, and its palette set for 8 bpp canvases. The
+ * shadow is cleared to \a colors[0], the next flush redraws the canvas.
+ *
+ * \param buffer  Shadow bitmap, LCD_SHADOW_SIZE() bytes.
+ * \param depth   1 or 2 bits per pixel.
+ * \param table   RGB 888 colors of the shadow pixel values, 2 or 4.
+ */
+void lcd_shadow_init(uint8_t *buffer, uint8_t depth, const uint32_t *table)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t ppb = 8 / depth;
+	uint32_t pixels[4];
+	uint32_t b, p, i;
+
+	assert(depth == 1 || depth == 2);
+	assert(canvas->height <= LCD_SHADOW_MAX_HEIGHT);
+
+	bits = buffer;
+	bpp = depth;
+	surface_width = canvas->width;
+	surface_height = canvas->height;
+	stride = (surface_width * bpp + 7) / 8;
+	colors = table;
+	last_valid = false;
+
+	for (i = 0; i < (1u << bpp); i++)
+		pixels[i] = lcd_pixel_value(colors[i]);
+
+	lut_words = ppb * cw / 4;
+	for (b = 0; b < 256; b++) {
+		uint8_t *entry = (uint8_t *)lut[b];
+
+		for (p = 0; p < ppb; p++) {
+			uint32_t index = (b >> (8 - bpp * (p + 1))) & ((1u << bpp) - 1);
+
+			memcpy(&entry[p * cw], &pixels[index], cw);
+		}
+	}
+
+	for (b = 0; b < 256; b++) {
+		spread[b] = 0;
+		for (i = 0; i < 8; i++) {
+			if (b & (1u << i))
+				spread[b] |= 1u << (2 * i);
+		}
+	}
+
+	memset(bits, 0, stride * surface_height);
+	_mark_rows(0, surface_height - 1);
+}
+
+/**
+ * \brief Check whether drawing goes to the shadow.
+ */
+bool lcd_shadow_enabled(void)
+{
+	return bpp != 0;
+}
+
+/**
+ * \brief Return the shadow pixel value closest to an RGB 888 color.
+ */
+uint8_t lcd_shadow_index(uint32_t color)
+{
+	if (!last_valid || color != last_color) {
+		last_color = color;
+		last_index = lcd_closest_color(colors, 1u << bpp, color);
+		last_valid = true;
+	}
+	return last_index;
+}
+
+void lcd_shadow_pixel(uint32_t x, uint32_t y, uint8_t index)
+{
+	uint32_t shift = 32 - bpp;
+
+	if (x >= surface_width || y >= surface_height)
+		return;
+	_put_bits(&bits[y * stride], x * bpp, (uint32_t)index << shift,
+		  ((1u << bpp) - 1) << shift);
+	_mark_rows(y, y);
+}
+
+/**
+ * \brief Fill a rectangle, corners included.
+ */
+void lcd_shadow_fill(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+		     uint8_t index)
+{
+	uint8_t pattern = bpp == 1 ? (index ? 0xFF : 0x00) : index * 0x55;
+	uint32_t y;
+
+	if (x2 >= surface_width)
+		x2 = surface_width - 1;
+	if (y2 >= surface_height)
+		y2 = surface_height - 1;
+	if (x1 > x2 || y1 > y2)
+		return;
+
+	for (y = y1; y <= y2; y++)
+		_fill_span(&bits[y * stride], x1, x2, pattern);
+	_mark_rows(y1, y2);
+}
+
+/**
+ * \brief Draw a glyph, see lcd_font_glyph().
+ *
+ * \param x       X-coordinate of the upper-left corner.
+ * \param y       Y-coordinate of the upper-left corner.
+ * \param rows    Glyph rows, bit 15 is the leftmost pixel.
+ * \param width   Glyph width, at most 16.
+ * \param height  Glyph height.
+ * \param fg      Pixel value of the set bits.
+ * \param bg      Pixel value of the clear bits, if \a opaque.
+ * \param opaque  Whether the clear bits are drawn.
+ */
+void lcd_shadow_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+		      uint32_t width, uint32_t height, uint8_t fg, uint8_t bg,
+		      bool opaque)
+{
+	uint32_t cell = (0xFFFF << (16 - width)) & 0xFFFF;
+	uint32_t r;
+
+	if (x >= surface_width || y >= surface_height)
+		return;
+	if (y + height > surface_height)
+		height = surface_height - y;
+
+	for (r = 0; r < height; r++) {
+		uint32_t ink = rows[r] & cell;
+		uint32_t value, mask;
+
+		if (bpp == 1) {
+			value = ((fg ? ink : 0) | (bg ? cell & ~ink : 0)) << 16;
+			mask = (opaque ? cell : ink) << 16;
+		} else {
+			uint32_t set = _spread_row(ink);
+			uint32_t all = _spread_row(cell);
+
+			value = set * fg | (all & ~set) * bg;
+			mask = (opaque ? all : set) * 3;
+		}
+		if (mask)
+			_put_bits(&bits[(y + r) * stride], x * bpp, value & mask,
+				  mask);
+	}
+	_mark_rows(y, y + height - 1);
+}
+
+/**
+ * \brief Expand the rows changed since the last flush into the canvas and
+ * write them back from the data cache.
+ */
+void lcd_shadow_flush(void)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t cw = canvas->bpp / 8;
+	uint32_t rw = canvas->width * cw;
+	uint32_t ppb = 8 / bpp;
+	uint32_t full = surface_width / ppb;
+	uint32_t tail = (surface_width % ppb) * cw;
+	uint8_t *buffer = canvas->buffer;
+	uint32_t y, first = 0;
+	bool run = false;
+
+	if (rw & 0x3)
+		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
+
+	/* one pass past the last row to write back the last run */
+	for (y = 0; y <= surface_height; y++) {
+		if (y < surface_height && (dirty[y / 32] & (1u << (y % 32)))) {
+			_expand_row(&bits[y * stride], &buffer[y * rw], full, tail);
+			if (!run)
+				first = y;
+			run = true;
+		} else if (run) {
+			cache_clean_region(&buffer[first * rw], (y - first) * rw);
+			run = false;
+		}
+	}
+	memset(dirty, 0, sizeof(dirty));
+}
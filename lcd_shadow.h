@@ -0,0 +1,63 @@
+/**
+ * \file
+ *
+ * Packed text surface: a 1 or 2 bits per pixel shadow of the canvas.
+ *
+ * Text needs few colors, yet every glyph pixel drawn on a 16 or 24 bpp
+ * canvas is a multi-byte store. Once lcd_shadow_init() is called, the
+ * drawing functions of lcd_draw.h write the shadow instead: a glyph row is
+ * a few byte read-modify-writes, a filled rectangle a memset. Colors are
+ * drawn with the closest of the 2 or 4 shadow colors.
+ *
+ * The shadow records which rows changed. lcd_shadow_flush() expands those
+ * rows into the canvas through a 256-entry table giving the canvas pixels
+ * of every shadow byte, then writes them back from the data cache for the
+ * LCDC. Images (lcd_draw_image()) still go to the canvas directly.
+ *
+ * Pixels are packed MSB first: pixel 0 of a row is bit 7 (1 bpp) or bits
+ * 7..6 (2 bpp) of its first byte.
+ */
+
+#ifndef _LCD_SHADOW_H_
+#define _LCD_SHADOW_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Tallest canvas a shadow can cover, sizes the dirty row map */
+#define LCD_SHADOW_MAX_HEIGHT   1024
+
+/** Size of the shadow of a canvas */
+#define LCD_SHADOW_SIZE(width, height, bpp) \
+	((((width) * (bpp) + 7) / 8) * (height))
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void lcd_shadow_init(uint8_t *bits, uint8_t bpp, const uint32_t *colors);
+
+extern bool lcd_shadow_enabled(void);
+
+extern uint8_t lcd_shadow_index(uint32_t color);
+
+extern void lcd_shadow_pixel(uint32_t x, uint32_t y, uint8_t index);
+
+extern void lcd_shadow_fill(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+			    uint8_t index);
+
+extern void lcd_shadow_glyph(uint32_t x, uint32_t y, const uint16_t *rows,
+			     uint32_t width, uint32_t height, uint8_t fg,
+			     uint8_t bg, bool opaque);
+
+extern void lcd_shadow_flush(void);
+
+#endif /* _LCD_SHADOW_H_ */
@@ -0,0 +1,62 @@
+/**
+ * \file
+ *
+ * Base layer of the LCDC shown in its default color, see lcdc_base.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "display/lcdc.h"
+
+#include "lcdc_base.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** The base layer shows its default color */
+static bool _color_shown;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Show the base layer in a single color, without a frame buffer.
+ *
+ * \param color  Color as 0xRRGGBB.
+ */
+void lcdc_base_show_color(uint32_t color)
+{
+	/* the driver disables the channel and drops its buffer */
+	lcdc_show_base(NULL, 0, 0);
+
+	LCDC->LCDC_BASECFG3 = LCDC_BASECFG3_RDEF((color >> 16) & 0xFF) |
+			      LCDC_BASECFG3_GDEF((color >> 8) & 0xFF) |
+			      LCDC_BASECFG3_BDEF(color & 0xFF);
+	LCDC->LCDC_BASECFG4 &= ~LCDC_BASECFG4_DMA;
+	LCDC->LCDC_BASECHER = LCDC_BASECHER_CHEN | LCDC_BASECHER_UPDATEEN;
+	_color_shown = true;
+}
+
+/**
+ * \brief Show a frame buffer on the base layer again.
+ *
+ * \param buffer  Frame buffer, see lcdc_show_base().
+ * \param bpp     Bits per pixel of \a buffer.
+ */
+void lcdc_base_show_buffer(void *buffer, uint8_t bpp)
+{
+	if (_color_shown) {
+		LCDC->LCDC_BASECHDR = LCDC_BASECHDR_CHDIS;
+		LCDC->LCDC_BASECFG4 |= LCDC_BASECFG4_DMA;
+		_color_shown = false;
+	}
+	lcdc_show_base(buffer, bpp, 0);
+}
@@ -0,0 +1,32 @@
+/**
+ * \file
+ *
+ * Base layer of the LCDC shown in its default color.
+ *
+ * With its DMA channel off the base layer takes every pixel from the
+ * default color of BASECFG3 and the LCDC fetches no frame buffer for it.
+ * The lcdc driver has no call for this, so these helpers wrap
+ * lcdc_show_base(): the driver hides the layer and forgets its buffer
+ * before the default color is set, and gets the DMA path back before it
+ * is handed a buffer again. Use them instead of lcdc_show_base() for the
+ * base layer.
+ */
+
+#ifndef _LCDC_BASE_H_
+#define _LCDC_BASE_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void lcdc_base_show_color(uint32_t color);
+
+extern void lcdc_base_show_buffer(void *buffer, uint8_t bpp);
+
+#endif /* _LCDC_BASE_H_ */
@@ -0,0 +1,419 @@
+/**
+ * \file
+ *
+ * Line history of the console, see line_store.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "line_store.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** FNV-1a, updated one character at a time */
+#define HASH_SEED		2166136261u
+#define HASH_PRIME		16777619u
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Slot index of a line held or of the line being assembled, counted back
+ * from the slot of the latter: any capacity goes without a division.
+ */
+static uint32_t _index(const struct _line_store *store, uint32_t seq)
+{
+	uint32_t back = store->head - seq;
+
+	if (back <= store->head_slot)
+		return store->head_slot - back;
+	return store->head_slot + store->capacity - back;
+}
+
+static struct _line* _slot(const struct _line_store *store, uint32_t seq)
+{
+	return &store->lines[_index(store, seq)];
+}
+
+static uint32_t _hash_step(uint32_t hash, char ch)
+{
+	return (hash ^ (uint8_t)ch) * HASH_PRIME;
+}
+
+/**
+ * Move the lines of the pinned snapshot to its own slots, the store is
+ * about to reuse the slot of the oldest one.
+ */
+static void _move_pinned(struct _line_store *store)
+{
+	struct _line_store *snapshot = store->pinned;
+	uint32_t seq = line_store_first(snapshot);
+	uint32_t i, idx;
+
+	for (i = 0; seq != snapshot->head; i++, seq++) {
+		idx = _index(snapshot, seq);
+		store->pin_lines[i] = snapshot->lines[idx];
+		store->pin_tags[i] = snapshot->tags[idx];
+	}
+	snapshot->lines = store->pin_lines;
+	snapshot->tags = store->pin_tags;
+	snapshot->capacity = store->pin_capacity;
+	snapshot->head_slot = i;
+	store->pinned = NULL;
+}
+
+/**
+ * Start assembling a new line in the slot after the newest line.
+ */
+static void _open_line(struct _line_store *store)
+{
+	struct _line *line;
+
+	if (store->pinned &&
+	    store->head - line_store_first(store->pinned) >= store->capacity)
+		_move_pinned(store);
+
+	line = _slot(store, store->head);
+
+	line->repeat = 0;
+	line->len = 0;
+	line->fit = 0;
+	line->width = 0;
+	line->text[0] = 0;
+	store->tags[store->head_slot] = 0;
+	store->hash = HASH_SEED;
+	store->widths[0] = 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty store.
+ *
+ * \param store     Store instance.
+ * \param lines     Line slots.
+ * \param tags      Tag words, one per slot.
+ * \param capacity  Number of slots, at least 2.
+ */
+void line_store_init(struct _line_store *store, struct _line *lines,
+		     uint16_t *tags, uint32_t capacity)
+{
+	assert(capacity >= 2);
+
+	store->lines = lines;
+	store->tags = tags;
+	store->capacity = capacity;
+	store->head_slot = 0;
+	store->repeats = 0;
+	store->advance = NULL;
+	store->pinned = NULL;
+	line_store_clear(store);
+}
+
+/**
+ * \brief Drop all lines. Sequence numbers keep growing.
+ */
+void line_store_clear(struct _line_store *store)
+{
+	store->count = 0;
+	_open_line(store);
+}
+
+/**
+ * \brief Truncate lines by their drawn width.
+ *
+ * Applies from the next line on. The width grows by \a advance for every
+ * character, which must not depend on anything but its arguments. Every
+ * line keeps its width and the number of its leading characters within
+ * \a fit_width.
+ *
+ * \param store      Store instance.
+ * \param advance    Pixel advance of a character, NULL for no limit.
+ * \param max_width  Widest line kept, in pixels.
+ * \param fit_width  Width the fit count of the lines is taken for, e.g.
+ *                   the text right of a time column.
+ */
+void line_store_set_width(struct _line_store *store, line_advance_t advance,
+			  uint32_t max_width, uint32_t fit_width)
+{
+	store->advance = advance;
+	store->max_width = max_width;
+	store->fit_width = fit_width;
+}
+
+/**
+ * \brief Freeze the newest lines into a snapshot, without copying any.
+ *
+ * The snapshot reads the slots of the store, which goes on with all its
+ * lines. Before the store reuses the slot of the oldest snapshot line, the
+ * snapshot lines are moved to \a lines; until then a line equal to the
+ * newest snapshot line is not collapsed into it.
+ *
+ * \param store     Store instance.
+ * \param snapshot  Receives the newest lines of the store.
+ * \param keep      Most lines the snapshot holds.
+ * \param lines     Slots the snapshot moves to.
+ * \param tags      Tag words the snapshot moves to.
+ * \param capacity  Number of slots in \a lines, more than \a keep.
+ */
+void line_store_pin(struct _line_store *store, struct _line_store *snapshot,
+		    uint32_t keep, struct _line *lines, uint16_t *tags,
+		    uint32_t capacity)
+{
+	assert(capacity > keep && keep < store->capacity);
+
+	*snapshot = *store;
+	if (snapshot->count > keep)
+		snapshot->count = keep;
+	snapshot->pinned = NULL;
+
+	store->pinned = snapshot;
+	store->pin_lines = lines;
+	store->pin_tags = tags;
+	store->pin_capacity = capacity;
+}
+
+/**
+ * \brief Drop the snapshot taken by line_store_pin(), if it still reads
+ * the slots of the store.
+ */
+void line_store_unpin(struct _line_store *store)
+{
+	store->pinned = NULL;
+}
+
+/**
+ * \brief Append a character to the line being assembled.
+ */
+void line_store_putc(struct _line_store *store, char ch)
+{
+	struct _line *line = _slot(store, store->head);
+	bool fits = true;
+
+	if (line->len >= LINE_MAX_CHARS)
+		return;
+
+	if (store->advance) {
+		char prev = line->len ? line->text[line->len - 1] : 0;
+		uint32_t width = store->widths[line->len] +
+				 store->advance(prev, ch);
+
+		if (width > store->max_width)
+			return;
+		store->widths[line->len + 1] = width;
+		line->width = width;
+		fits = width <= store->fit_width;
+	}
+	/* the fit count stops at the first character past the fit width */
+	if (fits && line->fit == line->len)
+		line->fit++;
+	line->text[line->len++] = ch;
+	store->hash = _hash_step(store->hash, ch);
+}
+
+/**
+ * \brief Remove the last character of the line being assembled.
+ */
+void line_store_backspace(struct _line_store *store)
+{
+	struct _line *line = _slot(store, store->head);
+	uint32_t i;
+
+	if (line->len == 0)
+		return;
+
+	line->len--;
+	if (line->fit > line->len)
+		line->fit = line->len;
+	if (store->advance)
+		line->width = store->widths[line->len];
+	store->hash = HASH_SEED;
+	for (i = 0; i < line->len; i++)
+		store->hash = _hash_step(store->hash, line->text[i]);
+}
+
+/**
+ * \brief Set the arrival time of the line being assembled.
+ */
+void line_store_stamp(struct _line_store *store, uint64_t us)
+{
+	struct _line *line = _slot(store, store->head);
+	int i;
+
+	for (i = 0; i < 6; i++)
+		line->stamp[i] = us >> (8 * i);
+}
+
+/**
+ * \brief Set the tags of the line being assembled.
+ */
+void line_store_set_tags(struct _line_store *store, uint16_t tags)
+{
+	store->tags[store->head_slot] = tags;
+}
+
+/**
+ * \brief Complete the line being assembled, evicting the oldest line if
+ * the store is full.
+ *
+ * \return Sequence number of the committed line.
+ */
+uint32_t line_store_commit(struct _line_store *store)
+{
+	struct _line *line = _slot(store, store->head);
+	uint32_t seq = store->head;
+
+	line->text[line->len] = 0;
+
+	if (store->count < store->capacity - 1)
+		store->count++;
+	store->head++;
+	if (++store->head_slot == store->capacity)
+		store->head_slot = 0;
+	store->last_hash = store->hash;
+
+	_open_line(store);
+	return seq;
+}
+
+/**
+ * \brief Complete the line being assembled by counting it as a repeat of
+ * the newest line, if the text of both is the same.
+ *
+ * The tags of the line being assembled are added to the newest line, its
+ * arrival time stays the one of the first copy.
+ *
+ * \return true if the line was collapsed, false if it differs and is
+ * still being assembled.
+ */
+bool line_store_collapse(struct _line_store *store)
+{
+	struct _line *line = _slot(store, store->head);
+	struct _line *last;
+	uint32_t last_idx;
+
+	if (store->count == 0 || store->hash != store->last_hash)
+		return false;
+	/* the newest line belongs to the snapshot too */
+	if (store->pinned && store->pinned->head == store->head)
+		return false;
+
+	last_idx = _index(store, store->head - 1);
+	last = &store->lines[last_idx];
+	if (last->len != line->len || memcmp(last->text, line->text, line->len))
+		return false;
+
+	if (last->repeat < UINT16_MAX)
+		last->repeat++;
+	store->tags[last_idx] |= store->tags[store->head_slot];
+	store->repeats++;
+
+	_open_line(store);
+	return true;
+}
+
+/**
+ * \brief Sequence number of the oldest line held.
+ */
+uint32_t line_store_first(const struct _line_store *store)
+{
+	return store->head - store->count;
+}
+
+/**
+ * \brief Sequence number following the newest committed line.
+ */
+uint32_t line_store_end(const struct _line_store *store)
+{
+	return store->head;
+}
+
+/**
+ * \brief Get a committed line.
+ *
+ * \return The line, or NULL if it was evicted or is not committed yet.
+ */
+const struct _line* line_store_get(const struct _line_store *store, uint32_t seq)
+{
+	if (seq - line_store_first(store) >= store->count)
+		return NULL;
+	return _slot(store, seq);
+}
+
+/**
+ * \brief Arrival time of a line in microseconds.
+ */
+uint64_t line_stamp(const struct _line *line)
+{
+	uint64_t us = 0;
+	int i;
+
+	for (i = 5; i >= 0; i--)
+		us = (us << 8) | line->stamp[i];
+	return us;
+}
+
+/**
+ * \brief Tags of a committed line.
+ *
+ * \return The tags, or 0 if the line was evicted or is not committed yet.
+ */
+uint16_t line_store_tags(const struct _line_store *store, uint32_t seq)
+{
+	if (seq - line_store_first(store) >= store->count)
+		return 0;
+	return store->tags[_index(store, seq)];
+}
+
+/**
+ * \brief Find the newest committed lines having any of the given tags.
+ *
+ * Only the tag array is read, newest line first.
+ *
+ * \param store  Store instance.
+ * \param from   First sequence number to consider, clamped to the lines held.
+ * \param end    Sequence number after the last one to consider.
+ * \param mask   Tags looked for.
+ * \param seqs   Receives the sequence numbers found, oldest first.
+ * \param max    Most lines to find.
+ *
+ * \return Number of lines found.
+ */
+uint32_t line_store_find(const struct _line_store *store, uint32_t from,
+			 uint32_t end, uint16_t mask, uint32_t *seqs,
+			 uint32_t max)
+{
+	uint32_t first = line_store_first(store);
+	uint32_t seq, idx, found = 0;
+
+	if ((int32_t)(from - first) < 0)
+		from = first;
+	if ((int32_t)(end - store->head) > 0)
+		end = store->head;
+	if ((int32_t)(end - from) <= 0 || max == 0)
+		return 0;
+
+	seq = end;
+	idx = _index(store, end);
+	while (seq != from && found < max) {
+		seq--;
+		idx = idx ? idx - 1 : store->capacity - 1;
+		if (store->tags[idx] & mask)
+			seqs[max - 1 - found++] = seq;
+	}
+
+	if (found < max)
+		memmove(seqs, &seqs[max - found], found * sizeof(seqs[0]));
+	return found;
+}
@@ -0,0 +1,147 @@
+/**
+ * \file
+ *
+ * Line history of the console.
+ *
+ * Lines live in a ring of fixed size slots provided by the caller. Every
+ * committed line gets a sequence number which only grows; the lines held
+ * are [line_store_first(), line_store_end()). The slot after the newest
+ * line holds the line being assembled, so a store of N slots keeps N - 1
+ * committed lines. A slot is found by counting back from the slot of the
+ * line being assembled, so the number of slots need not be a power of
+ * two and no division is done.
+ *
+ * Every slot has a tag word in a parallel array, set by the caller when the
+ * line is complete. Keeping the tags apart from the text lets a scan over
+ * the whole history read 2 bytes per line instead of a line slot.
+ *
+ * line_store_collapse() folds a line equal to the newest one into it and
+ * counts the repeat there instead of taking a slot. A hash of the line
+ * being assembled is kept up to date character by character, so a line
+ * which differs from the newest one is told apart in constant time; the
+ * text is only compared when the hashes match.
+ *
+ * line_store_pin() freezes a snapshot of the newest lines in constant
+ * time: the snapshot is a second store over the same slots, and the store
+ * goes on committing lines without losing any. Only once the store comes
+ * round to the oldest snapshot line are the few snapshot lines moved to
+ * slots of their own.
+ *
+ * With proportional fonts the characters that fit a view depend on the
+ * text. line_store_set_width() gives the store the advance of every
+ * character and the width available; the store then keeps the prefix
+ * widths of the line being assembled, one addition per character, and
+ * truncates the line where the next character would not fit. Backspace
+ * takes the previous prefix width back without measuring again. The width
+ * of the line, and the number of its leading characters within a second,
+ * narrower width, stay with the line when it is committed: a view lays
+ * committed lines out from them and does not measure the text again.
+ */
+
+#ifndef _LINE_STORE_H_
+#define _LINE_STORE_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Longest line kept, longer lines are truncated. Narrow proportional
+ * text fits more characters than the fixed view columns */
+#define LINE_MAX_CHARS		120
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _line {
+	uint16_t repeat;       /* further copies collapsed into the line */
+	uint8_t len;
+	uint8_t fit;           /* leading characters within the fit width */
+	uint16_t width;        /* drawn width in pixels, 0 if not measured */
+	uint8_t stamp[6];      /* arrival time in microseconds, 48-bit LE */
+	char text[LINE_MAX_CHARS + 1];
+};
+
+/** Pixel advance of \a ch after \a prev, kerning included */
+typedef uint32_t (*line_advance_t)(char prev, char ch);
+
+struct _line_store {
+	struct _line *lines;
+	uint16_t *tags;        /* tag word of every slot */
+	uint32_t capacity;     /* number of slots */
+	uint32_t head;         /* sequence number of the line being assembled */
+	uint32_t head_slot;    /* its slot */
+	uint32_t count;        /* committed lines held */
+	uint32_t hash;         /* hash of the line being assembled */
+	uint32_t last_hash;    /* hash of the newest committed line */
+	uint32_t repeats;      /* lines collapsed, only grows */
+
+	/* width limit, see line_store_set_width() */
+	line_advance_t advance; /* NULL to limit by characters only */
+	uint32_t max_width;
+	uint32_t fit_width;
+	uint16_t widths[LINE_MAX_CHARS + 1]; /* prefix widths of the line
+						being assembled */
+
+	/* snapshot sharing the slots, see line_store_pin() */
+	struct _line_store *pinned;
+	struct _line *pin_lines; /* slots the snapshot moves to */
+	uint16_t *pin_tags;
+	uint32_t pin_capacity;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void line_store_init(struct _line_store *store, struct _line *lines,
+			    uint16_t *tags, uint32_t capacity);
+
+extern void line_store_clear(struct _line_store *store);
+
+extern void line_store_set_width(struct _line_store *store,
+				 line_advance_t advance, uint32_t max_width,
+				 uint32_t fit_width);
+
+extern void line_store_pin(struct _line_store *store,
+			   struct _line_store *snapshot, uint32_t keep,
+			   struct _line *lines, uint16_t *tags,
+			   uint32_t capacity);
+
+extern void line_store_unpin(struct _line_store *store);
+
+extern void line_store_putc(struct _line_store *store, char ch);
+
+extern void line_store_backspace(struct _line_store *store);
+
+extern void line_store_stamp(struct _line_store *store, uint64_t us);
+
+extern void line_store_set_tags(struct _line_store *store, uint16_t tags);
+
+extern uint32_t line_store_commit(struct _line_store *store);
+
+extern bool line_store_collapse(struct _line_store *store);
+
+extern uint32_t line_store_first(const struct _line_store *store);
+
+extern uint32_t line_store_end(const struct _line_store *store);
+
+extern const struct _line* line_store_get(const struct _line_store *store,
+					  uint32_t seq);
+
+extern uint64_t line_stamp(const struct _line *line);
+
+extern uint16_t line_store_tags(const struct _line_store *store, uint32_t seq);
+
+extern uint32_t line_store_find(const struct _line_store *store, uint32_t from,
+				uint32_t end, uint16_t mask, uint32_t *seqs,
+				uint32_t max);
+
+#endif /* _LINE_STORE_H_ */
@@ -0,0 +1,228 @@
+/**
+ * \file
+ *
+ * Streaming decompression of framed LZSS blocks, see lzss.h.
+ *
+ * Compressed data is a bit stream, most significant bit first:
+ *
+ *   1 <8 bits literal>
+ *   0 <window_bits: offset - 1> <count_bits: count - 1>
+ *
+ * which is the format produced by the heatshrink encoder.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lzss.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/* framing states */
+enum {
+	LZSS_STATE_TEXT = 0,
+	LZSS_STATE_MAGIC,
+	LZSS_STATE_PARAMS,
+	LZSS_STATE_LEN0,
+	LZSS_STATE_LEN1,
+	LZSS_STATE_DATA,
+};
+
+/* bit decoder steps */
+enum {
+	LZSS_STEP_TAG = 0,
+	LZSS_STEP_LITERAL,
+	LZSS_STEP_INDEX,
+	LZSS_STEP_COUNT,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _flush(struct _lzss *z)
+{
+	if (z->olen) {
+		z->bytes_out += z->olen;
+		z->out(z->arg, z->obuf, z->olen);
+		z->olen = 0;
+	}
+}
+
+static void _emit(struct _lzss *z, uint8_t c)
+{
+	z->window[z->head] = c;
+	z->head = (z->head + 1) & ((1 << z->window_bits) - 1);
+	z->obuf[z->olen++] = c;
+	if (z->olen == LZSS_OUT_SIZE)
+		_flush(z);
+}
+
+static uint32_t _take(struct _lzss *z, uint8_t count)
+{
+	z->nbits -= count;
+	return (z->acc >> z->nbits) & ((1 << count) - 1);
+}
+
+/**
+ * Decode the bits of one compressed byte.
+ */
+static void _decode(struct _lzss *z, uint8_t c)
+{
+	uint32_t mask = (1 << z->window_bits) - 1;
+	uint32_t count, pos;
+
+	z->acc = (z->acc << 8) | c;
+	z->nbits += 8;
+
+	for (;;) {
+		switch (z->step) {
+		case LZSS_STEP_TAG:
+			if (z->nbits < 1)
+				return;
+			z->step = _take(z, 1) ? LZSS_STEP_LITERAL : LZSS_STEP_INDEX;
+			break;
+
+		case LZSS_STEP_LITERAL:
+			if (z->nbits < 8)
+				return;
+			_emit(z, _take(z, 8));
+			z->step = LZSS_STEP_TAG;
+			break;
+
+		case LZSS_STEP_INDEX:
+			if (z->nbits < z->window_bits)
+				return;
+			z->index = _take(z, z->window_bits);
+			z->step = LZSS_STEP_COUNT;
+			break;
+
+		case LZSS_STEP_COUNT:
+			if (z->nbits < z->count_bits)
+				return;
+			count = _take(z, z->count_bits) + 1;
+			pos = (z->head - z->index - 1) & mask;
+			while (count--) {
+				_emit(z, z->window[pos]);
+				pos = (pos + 1) & mask;
+			}
+			z->step = LZSS_STEP_TAG;
+			break;
+		}
+	}
+}
+
+/**
+ * Prepare the bit decoder for a new frame.
+ */
+static void _start_frame(struct _lzss *z)
+{
+	z->step = LZSS_STEP_TAG;
+	z->nbits = 0;
+	z->acc = 0;
+	z->head = 0;
+	memset(z->window, 0, 1 << z->window_bits);
+	z->frames++;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the stage.
+ *
+ * \param z    Decoder instance.
+ * \param out  Receives passed through and decompressed bytes, in order.
+ * \param arg  Argument passed to \a out.
+ */
+void lzss_init(struct _lzss *z, lzss_out_t out, void *arg)
+{
+	memset(z, 0, sizeof(*z));
+	z->out = out;
+	z->arg = arg;
+}
+
+/**
+ * \brief Feed a segment of the receive stream.
+ *
+ * Text outside frames is handed on in place, without copying.
+ */
+void lzss_feed(struct _lzss *z, const uint8_t *data, uint32_t len)
+{
+	const uint8_t *text = data;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		uint8_t c = data[i];
+
+		switch (z->state) {
+		case LZSS_STATE_TEXT:
+			if (c == LZSS_SO) {
+				if (&data[i] > text)
+					z->out(z->arg, text, &data[i] - text);
+				z->state = LZSS_STATE_MAGIC;
+			}
+			continue;
+
+		case LZSS_STATE_MAGIC:
+			if (c == LZSS_MAGIC) {
+				z->state = LZSS_STATE_PARAMS;
+			} else {
+				/* a lone SO, give it back */
+				static const uint8_t so = LZSS_SO;
+				z->out(z->arg, &so, 1);
+				z->state = LZSS_STATE_TEXT;
+				text = &data[i];
+				i--;
+			}
+			continue;
+
+		case LZSS_STATE_PARAMS:
+			z->window_bits = c >> 4;
+			z->count_bits = c & 0xF;
+			if (z->window_bits < 4 || z->window_bits > LZSS_MAX_WINDOW_BITS ||
+			    z->count_bits < 3 || z->count_bits >= z->window_bits) {
+				z->errors++;
+				z->state = LZSS_STATE_TEXT;
+				text = &data[i + 1];
+			} else {
+				z->state = LZSS_STATE_LEN0;
+			}
+			continue;
+
+		case LZSS_STATE_LEN0:
+			z->remaining = c;
+			z->state = LZSS_STATE_LEN1;
+			continue;
+
+		case LZSS_STATE_LEN1:
+			z->remaining |= c << 8;
+			_start_frame(z);
+			z->state = z->remaining ? LZSS_STATE_DATA : LZSS_STATE_TEXT;
+			text = &data[i + 1];
+			continue;
+
+		case LZSS_STATE_DATA:
+			_decode(z, c);
+			z->bytes_in++;
+			if (--z->remaining == 0) {
+				/* trailing bits are padding */
+				_flush(z);
+				z->state = LZSS_STATE_TEXT;
+				text = &data[i + 1];
+			}
+			continue;
+		}
+	}
+
+	if (z->state == LZSS_STATE_TEXT && &data[len] > text)
+		z->out(z->arg, text, &data[len] - text);
+	else if (z->state == LZSS_STATE_DATA)
+		_flush(z);
+}
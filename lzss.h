@@ -0,0 +1,90 @@
+/**
+ * \file
+ *
+ * Streaming decompression of framed LZSS blocks in the receive stream.
+ *
+ * Targets that cannot raise their baud rate compress their log output with
+ * heatshrink (https://github.com/atomicobject/heatshrink) and wrap each
+ * compressed block in a frame:
+ *
+ *   SO 'Z' params(u8) len(u16) data[len]
+ *
+ * params holds the window size exponent in bits 7..4 and the lookahead
+ * exponent in bits 3..0, as given to heatshrink_encoder_alloc(); len is
+ * little-endian. Every frame is an independent heatshrink stream. Bytes
+ * outside frames pass through unchanged.
+ *
+ * The decoder consumes input incrementally and never buffers a whole
+ * frame: memory use is the window (at most 2^LZSS_MAX_WINDOW_BITS bytes)
+ * plus a small output buffer, whatever the frame size.
+ *
+ * Uncompressed binary data passing through must not contain the SO 'Z'
+ * sequence; targets which send binary records and compress should put the
+ * records inside compressed frames.
+ */
+
+#ifndef _LZSS_H_
+#define _LZSS_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define LZSS_SO                 0x0E
+#define LZSS_MAGIC              'Z'
+
+/** Largest window accepted: 2^10 = 1024 bytes */
+#define LZSS_MAX_WINDOW_BITS    10
+/** Decoded bytes handed to the next stage at once */
+#define LZSS_OUT_SIZE           64
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Output of the stage: passed through or decompressed bytes */
+typedef void (*lzss_out_t)(void *arg, const uint8_t *data, uint32_t len);
+
+struct _lzss {
+	lzss_out_t out;
+	void *arg;
+
+	/* framing */
+	uint8_t state;
+	uint8_t window_bits;
+	uint8_t count_bits;
+	uint16_t remaining;     /* compressed bytes left in the frame */
+
+	/* bit decoder */
+	uint8_t step;
+	uint8_t nbits;          /* valid bits in acc */
+	uint32_t acc;
+	uint16_t index;
+	uint16_t head;          /* window write position */
+	uint8_t window[1 << LZSS_MAX_WINDOW_BITS];
+
+	uint8_t obuf[LZSS_OUT_SIZE];
+	uint32_t olen;
+
+	/* statistics */
+	uint32_t frames;
+	uint32_t bytes_in;      /* compressed bytes */
+	uint32_t bytes_out;     /* decompressed bytes */
+	uint32_t errors;        /* frames with bad parameters */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void lzss_init(struct _lzss *z, lzss_out_t out, void *arg);
+
+extern void lzss_feed(struct _lzss *z, const uint8_t *data, uint32_t len);
+
+#endif /* _LZSS_H_ */
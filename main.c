@@ -1,3 +1,4 @@
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -12,6 +13,7 @@
 #include "mm/cache.h"
 #include "mutex.h"
 #include "peripherals/pmc.h"
+#include "peripherals/tc.h"
 #include "serial/console.h"
 #include "serial/usart.h"
 #include "serial/usartd.h"
@@ -20,8 +22,24 @@
 
 #include "lcd_draw.h"
 #include "lcd_font.h"
+#include "lcd_shadow.h"
 #include "lcd_color.h"
+#include "lcdc_base.h"
 #include "font.h"
+#include "binlog.h"
+#include "capture.h"
+#include "flowctl.h"
+#include "framing.h"
+#include "hexview.h"
+#include "ring.h"
+#include "search.h"
+#include "line_store.h"
+#include "lzss.h"
+#include "match.h"
+#include "pipeline.h"
+#include "tstamp.h"
+#include "utf8.h"
+#include "view.h"
 #include "timer.h"
 #include "trace.h"
 
@@ -31,18 +49,83 @@
  
 #define ENABLE_MBUS_UART
 #define ENABLE_DISPLAY
+#define ENABLE_BASE_COLOR
+//#define ENABLE_PACKED_TEXT
+#define ENABLE_BAND_STAGING
+#define ENABLE_PROPORTIONAL
+//#define ENABLE_ANTIALIAS
+//#define ENABLE_TEXT_SCALE
+//#define ENABLE_ROTATION
 #define ENABLE_KEYINPUT
+#define ENABLE_FLOW_CONTROL
+#define ENABLE_MIRROR
+#define ENABLE_BINLOG
+#define ENABLE_LZSS
+#define ENABLE_TIMESTAMP
+#define ENABLE_HIGHLIGHT
+#define ENABLE_COMMANDS
+#define ENABLE_SEARCH
+#define ENABLE_TRIGGER
+#define ENABLE_COLLAPSE
+#define ENABLE_HEXVIEW
+#define ENABLE_FRAMING
+//#define ENABLE_CAPTURE
+//#define ENABLE_REPLAY
+
+/** System timer resolution in microseconds */
+#define TIMER_TICK_US		1000
+
+/** Number of receive channels, see _channel_config */
+#define CHANNEL_COUNT		3
 
 #ifdef ENABLE_MBUS_UART
-#define USART_ADDR FLEXUSART5
-#define USART_PINS PINS_FLEXCOM5_USART_HS_IOS1
+#define USART_MODE (US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT)
 #endif // end of ENABLE_MBUS_UART
 
+#if defined(ENABLE_TIMESTAMP) || defined(ENABLE_CAPTURE) || defined(ENABLE_REPLAY)
+/** Line timestamps, capture delays and the replay clock read one counter,
+ * the system timer ticks in milliseconds only */
+#define USE_TSTAMP_COUNTER
+#endif
+
+#ifdef USE_TSTAMP_COUNTER
+/** Free running counter which timestamps received bytes and lines */
+#define TSTAMP_TC		TC0
+#define TSTAMP_TC_CHANNEL	0
+/** Requested counter frequency, the closest available clock is used */
+#define TSTAMP_FREQ		1000000
+#endif // end of USE_TSTAMP_COUNTER
+
+#ifdef ENABLE_TIMESTAMP
+/** Line start marks queued between a USART interrupt and the main loop */
+#define TSTAMP_MARK_COUNT	64
+#endif // end of ENABLE_TIMESTAMP
+
+/** Receive ring between a USART interrupt and the main loop, per channel */
+#define RX_RING_SIZE		4096
+/** Ring levels where RTS stops and releases the sender */
+#define RX_HIGH_WATERMARK	(RX_RING_SIZE * 3 / 4)
+#define RX_LOW_WATERMARK	(RX_RING_SIZE / 4)
+
 #ifdef ENABLE_DISPLAY
-/** Size of base image buffer */
-#define SIZE_LCD_BUFFER_BASE (BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT * 4)
+/** Text canvas format: 24 (RGB 888), 16 (RGB 565) or 8 (palette, see
+ * _palette) bits per pixel */
+#define CANVAS_BPP		8
+
 /** Size of Overlay 1 buffer */
-#define SIZE_LCD_BUFFER_OVR1 (BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT * 3)
+#define SIZE_LCD_BUFFER_OVR1 (BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT * CANVAS_BPP / 8)
+
+#ifdef ENABLE_PACKED_TEXT
+/** Bits per pixel of the packed text surface drawn to, 1 or 2, the canvas
+ * is updated from it once per frame; see _shadow_colors */
+#define PACKED_TEXT_BPP		2
+#endif // end of ENABLE_PACKED_TEXT
+
+#ifdef ENABLE_BAND_STAGING
+/** Canvas rows staged in internal SRAM while a row is drawn: a text row
+ * of the 10x14 font */
+#define BAND_ROWS		(14 * TEXT_SCALE + LINE_SPACE)
+#endif // end of ENABLE_BAND_STAGING
 
 /** Background color for OVR1 */
 #define OVR1_BG      0xFFFFFF
@@ -51,52 +134,533 @@
 #define START_POS_Y		5
 #define LINE_SPACE		5
 
-#define MAX_LINE_CHAR_COUNT			66
+#ifdef ENABLE_TEXT_SCALE
+/** Text drawn 2 or 3 times larger, for panels read from afar */
+#define TEXT_SCALE			2
+#else
+#define TEXT_SCALE			1
+#endif // end of ENABLE_TEXT_SCALE
+
+#ifdef ENABLE_ROTATION
+/** Mounting of the panel, degrees clockwise: 90 and 270 are portrait */
+#define SCREEN_ROTATION			90
+#else
+#define SCREEN_ROTATION			0
+#endif // end of ENABLE_ROTATION
+
+/** Size of the screen drawn on, see lcd_set_rotation() */
+#if SCREEN_ROTATION == 90 || SCREEN_ROTATION == 270
+#define SCREEN_WIDTH			BOARD_LCD_HEIGHT
+#define SCREEN_HEIGHT			BOARD_LCD_WIDTH
+/** Cells of the 10x14 font across a portrait screen */
+#define MAX_LINE_CHAR_COUNT			((SCREEN_WIDTH - 2 * START_POS_X) / \
+					 (12 * TEXT_SCALE))
+#else
+#define SCREEN_WIDTH			BOARD_LCD_WIDTH
+#define SCREEN_HEIGHT			BOARD_LCD_HEIGHT
+#define MAX_LINE_CHAR_COUNT			(VIEW_COLUMNS / TEXT_SCALE)
+#endif
+#ifdef ENABLE_ANTIALIAS
+/** Size of the anti-aliased glyphs, scaled down from the 10x14 font */
+#define AA_GLYPH_WIDTH			7
+#define AA_GLYPH_HEIGHT			10
+/** Text rows of the screen, a multiple of CHANNEL_COUNT */
+#define MAX_FRAME_LINE_COUNT		30
+#elif defined(ENABLE_TEXT_SCALE) || defined(ENABLE_ROTATION)
+/** As many rows as the screen holds, a multiple of CHANNEL_COUNT */
+#define MAX_FRAME_LINE_COUNT		((SCREEN_HEIGHT - START_POS_Y) / \
+					 (14 * TEXT_SCALE + LINE_SPACE) / \
+					 CHANNEL_COUNT * CHANNEL_COUNT)
+#else
 #define MAX_FRAME_LINE_COUNT		25
+#endif // end of ENABLE_ANTIALIAS
+
+/** Text rows of a channel pane, the screen is split horizontally */
+#define PANE_LINE_COUNT			(MAX_FRAME_LINE_COUNT / CHANNEL_COUNT)
+/** Width of the color tag left of a pane */
+#define PANE_TAG_WIDTH			3
+
+/** Time column of the panes: VIEW_TIME_OFF, _ABSOLUTE or _RELATIVE */
+#define SCREEN_TIME_MODE		VIEW_TIME_RELATIVE
+
+/** Size of the 24 bpp base layer frame buffer */
+#define BASE_BUFFER_SIZE		(BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT * 3)
+
+/** Lines kept in the history of a channel, its pane shows the newest ones */
+#define HISTORY_BASE_LINES		1024
+#ifdef ENABLE_BASE_COLOR
+/** DDR taken by one more history line in every channel: its slot and tag */
+#define HISTORY_LINE_SIZE		(CHANNEL_COUNT * \
+					 (sizeof(struct _line) + sizeof(uint16_t)))
+/** Without a base layer buffer the history takes the memory it used */
+#define HISTORY_LINE_COUNT		(HISTORY_BASE_LINES + \
+					 BASE_BUFFER_SIZE / HISTORY_LINE_SIZE)
+#else
+#define HISTORY_LINE_COUNT		HISTORY_BASE_LINES
+#endif // end of ENABLE_BASE_COLOR
+
+/** Minimum time between two renders while input keeps arriving */
+#define FRAME_PERIOD_US			20000
+
+/** Glyphs drawn per font and method by the glyph benchmark */
+#define GLYPH_BENCH_COUNT		9600
+/** Full repaints per mode by the band staging benchmark */
+#define BAND_BENCH_PASSES		20
+/** Reads of the whole history by the base layer bandwidth benchmark */
+#define BASE_BENCH_PASSES		32
 #endif // end of ENABLE_DISPLAY
+
+#ifdef ENABLE_SEARCH
+/** Search postings per history line, a power of two. A line takes one per
+ * distinct trigram: about 41 for typical log lines (host/search_bench.c)
+ * and 62 for a line as wide as a pane in the fixed font, so 32 would leave
+ * a fifth of a typical history to text scans. Longer proportional lines
+ * wrap the pool sooner; their older lines are then scanned, see search.h */
+#define SEARCH_POSTINGS_PER_LINE	64
+/** Search postings of a channel. The pool does not grow with the history
+ * taking the base layer memory, the extra lines are scanned */
+#define SEARCH_POSTING_COUNT	(HISTORY_BASE_LINES * SEARCH_POSTINGS_PER_LINE)
+#endif // end of ENABLE_SEARCH
+
+#ifdef ENABLE_HIGHLIGHT
+/** Keyword automaton size in 16-bit entries */
+#define MATCH_TABLE_SIZE		16384
+#endif // end of ENABLE_HIGHLIGHT
+
+#ifdef ENABLE_TRIGGER
+/** Keyword which freezes a snapshot of the history */
+#define TRIGGER_PATTERN			"hardfault"
+/** Lines kept before and captured after the trigger line */
+#define TRIGGER_PRE_LINES		20
+#define TRIGGER_POST_LINES		40
+/** Lines of a snapshot */
+#define TRIGGER_SNAPSHOT_LINES		(TRIGGER_PRE_LINES + 1 + TRIGGER_POST_LINES)
+
+#if !defined(ENABLE_DISPLAY) || !defined(ENABLE_HIGHLIGHT)
+#error ENABLE_TRIGGER needs ENABLE_DISPLAY and ENABLE_HIGHLIGHT
+#endif
+_Static_assert(TRIGGER_SNAPSHOT_LINES < HISTORY_LINE_COUNT,
+	       "the trigger window does not fit the history");
+#endif // end of ENABLE_TRIGGER
+
+#if defined(ENABLE_COLLAPSE) && !defined(ENABLE_DISPLAY)
+#error ENABLE_COLLAPSE needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_BAND_STAGING) && !defined(ENABLE_DISPLAY)
+#error ENABLE_BAND_STAGING needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_PROPORTIONAL) && !defined(ENABLE_DISPLAY)
+#error ENABLE_PROPORTIONAL needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_ANTIALIAS) && !defined(ENABLE_DISPLAY)
+#error ENABLE_ANTIALIAS needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_TEXT_SCALE) && !defined(ENABLE_DISPLAY)
+#error ENABLE_TEXT_SCALE needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_ROTATION) && !defined(ENABLE_DISPLAY)
+#error ENABLE_ROTATION needs ENABLE_DISPLAY
+#endif
+
+#if defined(ENABLE_TEXT_SCALE) && defined(ENABLE_ANTIALIAS)
+#error ENABLE_TEXT_SCALE and ENABLE_ANTIALIAS both set the glyph size
+#endif
+
+#ifdef ENABLE_HEXVIEW
+/** Received bytes kept for the hex view of a channel */
+#define HEXVIEW_RING_SIZE		4096
+
+#ifndef ENABLE_DISPLAY
+#error ENABLE_HEXVIEW needs ENABLE_DISPLAY
+#endif
+#endif // end of ENABLE_HEXVIEW
+
+#ifdef ENABLE_MIRROR
+/** Console mirror transmit queue, bytes are dropped while it is full */
+#define MIRROR_QUEUE_SIZE	4096
+#endif // end of ENABLE_MIRROR
+
+#ifdef ENABLE_COMMANDS
+/** Console keys waiting for the main loop */
+#define COMMAND_QUEUE_SIZE	16
+#endif // end of ENABLE_COMMANDS
+
+/** Bytes handled between two frame time checks */
+#define RX_DRAIN_CHUNK		256
+
+#ifdef ENABLE_CAPTURE
+/** Size of the capture record ring (two bytes per received byte) */
+#define CAPTURE_BUFFER_SIZE	(256 * 1024)
+#endif // end of ENABLE_CAPTURE
+
+#ifdef ENABLE_REPLAY
+/** Replay speed: 1 = real time, N = N times faster, REPLAY_SPEED_MAX */
+#define REPLAY_SPEED		1
+/** Bytes fed per main loop iteration */
+#define REPLAY_BURST		256
+#endif // end of ENABLE_REPLAY
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
 
 #ifdef ENABLE_MBUS_UART
 static struct _pin pio_output = { PIO_GROUP_A, PIO_PA29, PIO_OUTPUT_0, PIO_DEFAULT };
-static const struct _pin usart_pins[] = USART_PINS;
+static const struct _pin usart5_pins[] = PINS_FLEXCOM5_USART_HS_IOS1;
+static const struct _pin usart4_pins[] = PINS_FLEXCOM4_USART_IOS1;
+static const struct _pin usart6_pins[] = PINS_FLEXCOM6_USART_IOS1;
 
 static const uint8_t test_patten[] = "abcdefghijklmnopqrstuvwxyz0123456789\n\r";
 
-static struct _usart_desc usart_desc = {
-	.addr           = USART_ADDR,
-	.baudrate       = 115200,
-	.mode           = US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
-	.transfer_mode  = USARTD_MODE_POLLING,
-	.timeout        = 0, // unit: ms
+#endif // end of ENABLE_MBUS_UART
+
+#ifdef ENABLE_HIGHLIGHT
+/** Line tags, the lowest bit set gives the line color */
+enum {
+	TAG_FATAL = 0,
+	TAG_ERROR,
+	TAG_WARN,
+	TAG_USER,
+	TAG_TRIGGER,
+	TAG_COUNT,
+};
+
+static const uint32_t _tag_colors[TAG_COUNT] = {
+	[TAG_FATAL]     = COLOR_RED,
+	[TAG_ERROR]     = COLOR_OrangeRed,
+	[TAG_WARN]      = COLOR_YELLOW,
+	[TAG_USER]      = COLOR_CYAN,
+	[TAG_TRIGGER]   = COLOR_MAGENTA,
+};
+
+/** Keywords, matched regardless of case */
+static const struct _match_pattern _keywords[] = {
+	{ "panic",      TAG_FATAL },
+	{ "assert",     TAG_FATAL },
+	{ "fatal",      TAG_FATAL },
+	{ "abort",      TAG_FATAL },
+	{ "hardfault",  TAG_FATAL },
+	{ "error",      TAG_ERROR },
+	{ "fail",       TAG_ERROR },
+	{ "exception",  TAG_ERROR },
+	{ "warn",       TAG_WARN },
+	/* user keywords */
+	{ "timeout",    TAG_USER },
+	{ "watchdog",   TAG_USER },
+	{ "reset",      TAG_USER },
+#ifdef ENABLE_TRIGGER
+	{ TRIGGER_PATTERN, TAG_TRIGGER },
+#endif // end of ENABLE_TRIGGER
+};
+
+static struct _match matcher;
+static uint16_t _match_table[MATCH_TABLE_SIZE];
+#endif // end of ENABLE_HIGHLIGHT
+
+/** Static description of a receive channel */
+struct _channel_config {
+	const char *name;       /* tag on the console mirror and statistics */
+	uint32_t color;         /* pane tag color */
+#ifdef ENABLE_MBUS_UART
+	Usart *addr;
+	const struct _pin *pins;
+	uint32_t pin_count;
+	uint32_t baudrate;
+	bool flow_control;      /* RTS wired to the sender */
+#endif // end of ENABLE_MBUS_UART
+#ifdef ENABLE_FRAMING
+	uint8_t framing;        /* FRAMING_xxx of the device */
+#endif // end of ENABLE_FRAMING
 };
+
+static const struct _channel_config _channel_config[CHANNEL_COUNT] = {
+	{
+		.name           = "A",
+		.color          = COLOR_GREEN,
+#ifdef ENABLE_MBUS_UART
+		.addr           = FLEXUSART5,
+		.pins           = usart5_pins,
+		.pin_count      = ARRAY_SIZE(usart5_pins),
+		.baudrate       = 115200,
+		.flow_control   = true,
 #endif // end of ENABLE_MBUS_UART
+#ifdef ENABLE_FRAMING
+		.framing        = FRAMING_NONE,
+#endif // end of ENABLE_FRAMING
+	},
+	{
+		.name           = "B",
+		.color          = COLOR_CYAN,
+#ifdef ENABLE_MBUS_UART
+		.addr           = FLEXUSART4,
+		.pins           = usart4_pins,
+		.pin_count      = ARRAY_SIZE(usart4_pins),
+		.baudrate       = 115200,
+		.flow_control   = false,
+#endif // end of ENABLE_MBUS_UART
+#ifdef ENABLE_FRAMING
+		.framing        = FRAMING_NONE,
+#endif // end of ENABLE_FRAMING
+	},
+	{
+		.name           = "C",
+		.color          = COLOR_MAGENTA,
+#ifdef ENABLE_MBUS_UART
+		.addr           = FLEXUSART6,
+		.pins           = usart6_pins,
+		.pin_count      = ARRAY_SIZE(usart6_pins),
+		.baudrate       = 115200,
+		.flow_control   = false,
+#endif // end of ENABLE_MBUS_UART
+#ifdef ENABLE_FRAMING
+		.framing        = FRAMING_NONE,
+#endif // end of ENABLE_FRAMING
+	},
+};
+
+/** Run time state of a receive channel, the stages of the receive path
+ * each have their own instance */
+struct _channel {
+	const struct _channel_config *cfg;
+	uint8_t index;
 
+	uint8_t rx_buffer[RX_RING_SIZE];
+	struct _ring ring;
+#ifdef ENABLE_MBUS_UART
+	struct _usart_desc usart_desc;
+#ifdef ENABLE_FLOW_CONTROL
+	struct _flowctl flowctl;
+#endif // end of ENABLE_FLOW_CONTROL
+#endif // end of ENABLE_MBUS_UART
+	/* decoders between the ring and the line store */
+	struct _pipeline pipe;
+#ifdef ENABLE_FRAMING
+	/* decoder of SLIP, COBS or length-prefixed frames */
+	struct _framing framing;
+	struct _pipe_stage framing_stage;
+#endif // end of ENABLE_FRAMING
+#ifdef ENABLE_LZSS
+	/* decompressor of framed LZSS blocks, plain text passes through */
+	struct _lzss lzss;
+	struct _pipe_stage lzss_stage;
+#endif // end of ENABLE_LZSS
+#ifdef ENABLE_BINLOG
+	/* decoder of binary log records, plain text passes through */
+	struct _binlog binlog;
+	struct _pipe_stage binlog_stage;
+#endif // end of ENABLE_BINLOG
+#ifdef ENABLE_TIMESTAMP
+	struct _tstamp_mark mark_buffer[TSTAMP_MARK_COUNT];
+	struct _tstamp_marks marks;
+	bool rx_bol;            /* next received byte starts a line, interrupt */
+	uint64_t stamp;         /* arrival time of the bytes being handled */
+	bool line_open;         /* the line being assembled has its stamp */
+#endif // end of ENABLE_TIMESTAMP
+#ifdef ENABLE_MIRROR
+	bool mirror_bol;        /* next mirrored byte starts a line */
+#endif // end of ENABLE_MIRROR
+#ifdef ENABLE_HIGHLIGHT
+	uint16_t match_state;   /* keyword automaton over the current line */
+	uint16_t line_tags;     /* keywords found in the current line */
+#endif // end of ENABLE_HIGHLIGHT
 #ifdef ENABLE_DISPLAY
+	struct _line_store store;
+	struct _view view;
+	struct _utf8 utf8;      /* characters of the line being assembled */
+#endif // end of ENABLE_DISPLAY
+#ifdef ENABLE_HEXVIEW
+	struct _hexview hexview;
+#endif // end of ENABLE_HEXVIEW
+#ifdef ENABLE_SEARCH
+	struct _search search;
+#endif // end of ENABLE_SEARCH
+#ifdef ENABLE_TRIGGER
+	uint8_t trigger;        /* TRIGGER_xxx */
+	uint32_t trigger_seq;   /* trigger line */
+	uint32_t post_lines;    /* lines still to capture after it */
+	struct _line_store snapshot;
+	bool show_frozen;
+#endif // end of ENABLE_TRIGGER
+
+	/* statistics */
+	uint32_t bytes;         /* bytes taken from the ring */
+	uint32_t lines;         /* lines completed */
+	uint32_t last_bytes;    /* bytes at the previous statistics print */
+};
+
+static struct _channel channels[CHANNEL_COUNT];
+
+#ifdef USE_TSTAMP_COUNTER
+static struct _tstamp tstamp;
+#endif // end of USE_TSTAMP_COUNTER
+
+/** Time of the previous statistics print, for the throughput figures */
+static uint32_t _last_stats_us;
+
+#ifdef ENABLE_MIRROR
+static uint8_t _mirror_buffer[MIRROR_QUEUE_SIZE];
+static struct _ring mirror_ring;
+/** Runtime switch of the console mirror */
+static volatile bool mirror_enabled = true;
+#endif // end of ENABLE_MIRROR
+
+#ifdef ENABLE_COMMANDS
+static uint8_t _command_buffer[COMMAND_QUEUE_SIZE];
+static struct _ring command_ring;
+#endif // end of ENABLE_COMMANDS
+
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_HIGHLIGHT)
+/** Tags of the lines shown, VIEW_FILTER_NONE for all */
+static uint16_t _filter = VIEW_FILTER_NONE;
+#endif
+
+#ifdef ENABLE_DISPLAY
+#ifndef ENABLE_BASE_COLOR
 /** LCD BASE buffer */
-CACHE_ALIGNED_DDR static uint8_t _base_buffer[BOARD_LCD_WIDTH * BOARD_LCD_HEIGHT * 3];
+CACHE_ALIGNED_DDR static uint8_t _base_buffer[BASE_BUFFER_SIZE];
+#endif // end of ENABLE_BASE_COLOR
 
 /** Overlay 1 buffer */
 CACHE_ALIGNED_DDR static uint8_t _ovr1_buffer[SIZE_LCD_BUFFER_OVR1];
 
+#if CANVAS_BPP == 8
+/** Colors of the 8 bpp canvas, every color drawn should be in it */
+static const uint32_t _palette[] = {
+	COLOR_BLACK,
+	COLOR_WHITE,
+	COLOR_DARKGRAY,
+	COLOR_YELLOW,
+	COLOR_RED,
+	COLOR_OrangeRed,
+	COLOR_GREEN,
+	COLOR_CYAN,
+	COLOR_MAGENTA,
+};
+
+#ifdef ENABLE_ANTIALIAS
+/** The palette with the 16 blend steps of every color over black, for the
+ * edges of anti-aliased glyphs */
+static uint32_t _aa_palette[ARRAY_SIZE(_palette) * 16];
+#endif // end of ENABLE_ANTIALIAS
+#endif
+
+#ifdef ENABLE_BAND_STAGING
+/** Staging band, see lcd_begin_band() */
+CACHE_ALIGNED_SRAM static uint8_t _band_buffer[BOARD_LCD_WIDTH * BAND_ROWS * CANVAS_BPP / 8];
+#endif // end of ENABLE_BAND_STAGING
+
+#ifdef ENABLE_PACKED_TEXT
+/** Packed text surface */
+CACHE_ALIGNED_DDR static uint8_t _text_shadow[LCD_SHADOW_SIZE(BOARD_LCD_WIDTH,
+		BOARD_LCD_HEIGHT, PACKED_TEXT_BPP)];
+
+/** Colors of the packed text surface, the first one is the background.
+ * Other colors are drawn with the closest one. */
+static const uint32_t _shadow_colors[1 << PACKED_TEXT_BPP] = {
+	COLOR_BLACK,
+	COLOR_WHITE,
+#if PACKED_TEXT_BPP == 2
+	COLOR_DARKGRAY,
+	COLOR_RED,
+#endif
+};
+#endif // end of ENABLE_PACKED_TEXT
+
+#ifdef ENABLE_PROPORTIONAL
+/** Kerning of the proportional font, sorted by first character */
+static const struct _lcd_kern_pair _kern_pairs[] = {
+	{ 'A', 'T', -1 },
+	{ 'A', 'V', -1 },
+	{ 'A', 'Y', -1 },
+	{ 'L', 'T', -1 },
+	{ 'L', 'Y', -1 },
+	{ 'T', 'A', -1 },
+	{ 'T', 'a', -1 },
+	{ 'T', 'e', -1 },
+	{ 'T', 'o', -1 },
+	{ 'V', 'A', -1 },
+	{ 'Y', 'A', -1 },
+	{ 'Y', 'o', -1 },
+};
+#endif // end of ENABLE_PROPORTIONAL
+
 /** Backlight value */
 static uint8_t bBackLight = 0xF0;
 
 static uint8_t fontWidth;
 static uint8_t fontHeight;
 
-static char gFrameBuffer[MAX_FRAME_LINE_COUNT][MAX_LINE_CHAR_COUNT+1];
+CACHE_ALIGNED_DDR static struct _line _history[CHANNEL_COUNT][HISTORY_LINE_COUNT];
+static uint16_t _history_tags[CHANNEL_COUNT][HISTORY_LINE_COUNT];
+#ifdef ENABLE_TRIGGER
+/** Slots a snapshot moves to once the live history comes round to it */
+CACHE_ALIGNED_DDR static struct _line _snapshot_lines[CHANNEL_COUNT][TRIGGER_SNAPSHOT_LINES + 1];
+static uint16_t _snapshot_tags[CHANNEL_COUNT][TRIGGER_SNAPSHOT_LINES + 1];
+
+/** Trigger states */
+enum {
+	TRIGGER_ARMED = 0,
+	TRIGGER_CAPTURING,      /* trigger seen, capturing the following lines */
+	TRIGGER_FROZEN,         /* snapshot taken, re-arm to take another */
+};
+#endif // end of ENABLE_TRIGGER
+#ifdef ENABLE_SEARCH
+CACHE_ALIGNED_DDR static struct _search_posting _postings[CHANNEL_COUNT][SEARCH_POSTING_COUNT];
+#endif // end of ENABLE_SEARCH
+#ifdef ENABLE_HEXVIEW
+static uint8_t _hex_buffer[CHANNEL_COUNT][HEXVIEW_RING_SIZE];
+/** The panes show the hex views instead of the lines */
+static bool _hex_mode;
+#endif // end of ENABLE_HEXVIEW
+static uint32_t _last_frame_us;
 #endif // end of ENABLE_DISPLAY
 
 #ifdef ENABLE_KEYINPUT
 static struct _pin pio_input = { PIO_GROUP_D, PIO_PD18, PIO_INPUT, PIO_DEFAULT };
 static uint8_t gKeyPressed;
 #endif // end of ENABLE_KEYINPUT
+
+#ifdef ENABLE_CAPTURE
+/** Capture record ring and the blob exported from it */
+CACHE_ALIGNED_DDR static uint8_t _capture_buffer[CAPTURE_BUFFER_SIZE];
+CACHE_ALIGNED_DDR static uint8_t _capture_export[CAPTURE_HEADER_SIZE + CAPTURE_BUFFER_SIZE];
+static struct _capture capture;
+#endif // end of ENABLE_CAPTURE
+
+#ifdef ENABLE_REPLAY
+static struct _replay replay;
+#endif // end of ENABLE_REPLAY
 /*----------------------------------------------------------------------------
  *        Functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * printf() to the console. printf() polls TXRDY and then writes DBGU_THR,
+ * which the mirror also does from the transmit interrupt: a byte loaded by
+ * the interrupt in between would be overwritten. The interrupt is held off
+ * until the text is out.
+ */
+static void _print(const char *fmt, ...)
+{
+	va_list ap;
+
+#ifdef ENABLE_MIRROR
+	DBGU->DBGU_IDR = DBGU_IDR_TXRDY;
+#endif // end of ENABLE_MIRROR
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+	fflush(stdout);
+#ifdef ENABLE_MIRROR
+	if (ring_count(&mirror_ring))
+		DBGU->DBGU_IER = DBGU_IER_TXRDY;
+#endif // end of ENABLE_MIRROR
+}
+
 #ifdef ENABLE_KEYINPUT
 static void pio_handler(uint32_t group, uint32_t status, void* user_arg)
 {
@@ -111,6 +675,7 @@ static void pio_handler(uint32_t group, uint32_t status, void* user_arg)
 #endif // end of ENABLE_KEYINPUT
 
 #ifdef ENABLE_DISPLAY
+#ifndef ENABLE_BASE_COLOR
 static void fill_color(uint8_t *lcd_base)
 {
 	uint16_t v_max  = BOARD_LCD_HEIGHT;
@@ -126,15 +691,49 @@ static void fill_color(uint8_t *lcd_base)
 		}
 	}
 }
+#endif // end of ENABLE_BASE_COLOR
+
+/**
+ * Advance of a character in the panes, see line_store_set_width().
+ */
+static uint32_t _line_advance(char prev, char ch)
+{
+	return lcd_char_kerning(prev, ch) + lcd_char_advance(ch);
+}
+
+/**
+ * Draw the color tag left of every pane.
+ */
+static void _draw_pane_tags(void)
+{
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		const struct _view *view = &channels[i].view;
+
+		lcd_draw_filled_rectangle(0, view->y, PANE_TAG_WIDTH - 1,
+					  view->y + view->rows * view->row_height - 1,
+					  channels[i].cfg->color);
+	}
+#ifdef ENABLE_PACKED_TEXT
+	lcd_shadow_flush();
+#else
+	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
+#endif // end of ENABLE_PACKED_TEXT
+}
 
 /**
  * Turn ON LCD, show base .
  */
 static void _LcdOn(void)
 {
+	int i;
+
+#ifndef ENABLE_BASE_COLOR
 	//test_pattern_24RGB(_base_buffer);
 	fill_color(_base_buffer);
 	cache_clean_region(_base_buffer, sizeof(_base_buffer));
+#endif // end of ENABLE_BASE_COLOR
 
 	lcdc_on();
 
@@ -142,112 +741,698 @@ static void _LcdOn(void)
 	
 	/* Display base layer */
 	// background
-	lcdc_show_base(_base_buffer, 24, 0);
+#ifdef ENABLE_BASE_COLOR
+	lcdc_base_show_color(COLOR_BLACK);
+#else
+	lcdc_base_show_buffer(_base_buffer, 24);
+#endif // end of ENABLE_BASE_COLOR
 
-	lcdc_create_canvas(LCDC_OVR1, _ovr1_buffer, 24, 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT);
+	lcdc_create_canvas(LCDC_OVR1, _ovr1_buffer, CANVAS_BPP, 0, 0, BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT);
+#ifdef ENABLE_ROTATION
+	lcd_set_rotation(SCREEN_ROTATION);
+#endif // end of ENABLE_ROTATION
+#if CANVAS_BPP == 8
+#ifdef ENABLE_ANTIALIAS
+	for (i = 0; i < (int)ARRAY_SIZE(_aa_palette); i++)
+		_aa_palette[i] = lcd_blend_color(_palette[i / 16], COLOR_BLACK,
+						 i % 16);
+	lcd_set_palette(_aa_palette, ARRAY_SIZE(_aa_palette));
+#else
+	lcd_set_palette(_palette, ARRAY_SIZE(_palette));
+#endif // end of ENABLE_ANTIALIAS
+#endif
+#ifdef ENABLE_PACKED_TEXT
+	lcd_shadow_init(_text_shadow, PACKED_TEXT_BPP, _shadow_colors);
+#endif // end of ENABLE_PACKED_TEXT
+#ifdef ENABLE_BAND_STAGING
+	lcd_set_band_buffer(_band_buffer, sizeof(_band_buffer));
+#endif // end of ENABLE_BAND_STAGING
 	lcd_fill(COLOR_BLACK);
 	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
 	
 	lcd_select_font(FONT10x14);
-	fontWidth = 10;
-	fontHeight = 14;
+#ifdef ENABLE_PROPORTIONAL
+	lcd_set_proportional(true);
+	lcd_set_kerning(_kern_pairs, ARRAY_SIZE(_kern_pairs));
+#endif // end of ENABLE_PROPORTIONAL
+#ifdef ENABLE_TEXT_SCALE
+	lcd_set_text_scale(TEXT_SCALE);
+#endif // end of ENABLE_TEXT_SCALE
+	fontWidth = 10 * TEXT_SCALE;
+	fontHeight = 14 * TEXT_SCALE;
+#ifdef ENABLE_ANTIALIAS
+	lcd_set_antialiased(AA_GLYPH_WIDTH, AA_GLYPH_HEIGHT);
+	fontHeight = AA_GLYPH_HEIGHT;
+#endif // end of ENABLE_ANTIALIAS
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct _channel *ch = &channels[i];
+		uint32_t row_height = fontHeight + LINE_SPACE;
+		uint32_t cell_width = fontWidth +
+			font_param[FONT10x14].char_space * TEXT_SCALE;
+		uint32_t pane_width = MAX_LINE_CHAR_COUNT * cell_width;
+
+		line_store_init(&ch->store, _history[i], _history_tags[i],
+				HISTORY_LINE_COUNT);
+		utf8_init(&ch->utf8);
+#ifdef ENABLE_SEARCH
+		search_init(&ch->search, &ch->store, _postings[i],
+			    SEARCH_POSTING_COUNT);
+#endif // end of ENABLE_SEARCH
+#ifdef ENABLE_TRIGGER
+		ch->trigger = TRIGGER_ARMED;
+		ch->show_frozen = false;
+#endif // end of ENABLE_TRIGGER
+		view_init(&ch->view, &ch->store, START_POS_X,
+			  START_POS_Y + i * PANE_LINE_COUNT * row_height,
+			  pane_width, PANE_LINE_COUNT, row_height, COLOR_WHITE,
+			  COLOR_BLACK);
+		/* keep what a pane can show, measured once for the view */
+		line_store_set_width(&ch->store, _line_advance, pane_width,
+				     view_fit_width(&ch->view));
+#ifdef ENABLE_TIMESTAMP
+		view_set_time_mode(&ch->view, SCREEN_TIME_MODE);
+#endif // end of ENABLE_TIMESTAMP
+#ifdef ENABLE_HIGHLIGHT
+		view_set_tag_colors(&ch->view, _tag_colors, TAG_COUNT);
+#endif // end of ENABLE_HIGHLIGHT
+#ifdef ENABLE_HEXVIEW
+		hexview_init(&ch->hexview, _hex_buffer[i], HEXVIEW_RING_SIZE,
+			     START_POS_X,
+			     START_POS_Y + i * PANE_LINE_COUNT * row_height,
+			     pane_width, cell_width,
+			     PANE_LINE_COUNT, row_height, COLOR_WHITE, COLOR_BLACK);
+#endif // end of ENABLE_HEXVIEW
+	}
+	_draw_pane_tags();
 	
-	printf("- LCD ON\r\n");
+	_print("- LCD ON\r\n");
 }
 
-static int frameLineRead = 0;
-static int frameLineWrite = 0;
-static int lineBufferPos = 0;
-static int bufferEmpty = 1;
-static int bufferFirstFull = 0;
+/**
+ * Check whether the pane of a channel has anything to render.
+ */
+static bool _pane_dirty(const struct _channel *ch)
+{
+#ifdef ENABLE_HEXVIEW
+	if (_hex_mode)
+		return hexview_dirty(&ch->hexview);
+#endif // end of ENABLE_HEXVIEW
+	return view_dirty(&ch->view);
+}
 
+/**
+ * Render the panes with new lines, the others are left untouched.
+ */
 static void screen_update(void)
 {
 	int i;
-	int y = START_POS_Y;
-	int end_line;
-
-	printf("[%d,%d]\n\r", frameLineRead, frameLineWrite);
-	if( frameLineWrite == frameLineRead && (bufferEmpty == 0) ) {
-		// buffer full
-		if( bufferFirstFull == 0 ) {
-			bufferFirstFull = 1;
-		} else {
-			lcd_fill(COLOR_BLACK);
-		}
-		
-		end_line = MAX_FRAME_LINE_COUNT;
 
-	} else {
-		end_line = frameLineWrite;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct _view *view = &channels[i].view;
+
+		if (!_pane_dirty(&channels[i]))
+			continue;
+
+#ifdef ENABLE_HEXVIEW
+		if (_hex_mode) {
+			hexview_render(&channels[i].hexview);
+			continue;
+		}
+#endif // end of ENABLE_HEXVIEW
+		trace_debug("%d[%u,%u]\n\r", i, (unsigned)view->top, (unsigned)view->end);
+		view_render(view);
 	}
-	
-	for(i=frameLineRead; i<end_line; i++) {
-		lcd_draw_string(START_POS_X, y, gFrameBuffer[i], COLOR_WHITE);
-		y += (fontHeight + LINE_SPACE);
+#ifdef ENABLE_PACKED_TEXT
+	lcd_shadow_flush();
+#endif // end of ENABLE_PACKED_TEXT
+}
+
+static bool screen_dirty(void)
+{
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (_pane_dirty(&channels[i]))
+			return true;
 	}
-	
-	if( (frameLineWrite == frameLineRead) ) {
-		for(i=0; i<frameLineRead; i++) {
-			lcd_draw_string(START_POS_X, y, gFrameBuffer[i], COLOR_WHITE);
-			y += (fontHeight + LINE_SPACE);
-		}
+	return false;
+}
+
+#ifdef ENABLE_HEXVIEW
+/**
+ * Switch the panes between lines and hex dump.
+ */
+static void _toggle_hex(void)
+{
+	int i;
+
+	_hex_mode = !_hex_mode;
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (_hex_mode)
+			hexview_reset(&channels[i].hexview);
+		else
+			view_reset(&channels[i].view);
 	}
+	_print("- panes: %s\r\n", _hex_mode ? "hex" : "lines");
+}
+#endif // end of ENABLE_HEXVIEW
+
+#ifdef ENABLE_TRIGGER
+/**
+ * Take the snapshot: it pins the newest lines of the live history, which
+ * keeps all its lines and goes on.
+ */
+static void _trigger_freeze(struct _channel *ch)
+{
+	line_store_pin(&ch->store, &ch->snapshot, TRIGGER_SNAPSHOT_LINES,
+		       _snapshot_lines[ch->index], _snapshot_tags[ch->index],
+		       TRIGGER_SNAPSHOT_LINES + 1);
+	ch->trigger = TRIGGER_FROZEN;
+	_print("- %s: frozen %u lines around line %u\r\n", ch->cfg->name,
+	       (unsigned)ch->snapshot.count, (unsigned)ch->trigger_seq);
 }
 
-static void line_add(char ch)
+/**
+ * Trigger state machine, run for every committed line.
+ */
+static void _trigger_line(struct _channel *ch, uint32_t seq, uint16_t tags)
 {
-	if( lineBufferPos < MAX_LINE_CHAR_COUNT ) {
-		gFrameBuffer[frameLineWrite][lineBufferPos++] = ch;
-	} else {
-		// line buffer is full
-		gFrameBuffer[frameLineWrite][MAX_LINE_CHAR_COUNT] = 0;
-		lineBufferPos = MAX_LINE_CHAR_COUNT;
+	if (ch->trigger == TRIGGER_ARMED && (tags & (1 << TAG_TRIGGER))) {
+		ch->trigger_seq = seq;
+		ch->post_lines = TRIGGER_POST_LINES;
+		ch->trigger = TRIGGER_CAPTURING;
+	} else if (ch->trigger == TRIGGER_CAPTURING) {
+		ch->post_lines--;
 	}
-	
-	if( ch == 0 ) {
-		// end of line
-		lineBufferPos = 0;
-		
-		if( (frameLineWrite == frameLineRead) && (bufferEmpty == 0) ) {
-			frameLineRead++;
-			if( frameLineRead >= MAX_FRAME_LINE_COUNT ) {
-				frameLineRead = 0;
-			}
+
+	if (ch->trigger == TRIGGER_CAPTURING && ch->post_lines == 0)
+		_trigger_freeze(ch);
+}
+
+/**
+ * Drop the snapshot and wait for the next trigger.
+ */
+static void _trigger_arm(struct _channel *ch)
+{
+	if (ch->trigger == TRIGGER_FROZEN) {
+		if (ch->show_frozen) {
+			ch->show_frozen = false;
+			view_set_store(&ch->view, &ch->store);
+			view_follow(&ch->view);
 		}
-		
-		frameLineWrite++;
-		bufferEmpty = 0;
-		
-		if( frameLineWrite >= MAX_FRAME_LINE_COUNT ) {
-			frameLineWrite = 0;			
+		line_store_unpin(&ch->store);
+	}
+	ch->trigger = TRIGGER_ARMED;
+}
+
+static void _trigger_arm_all(void)
+{
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++)
+		_trigger_arm(&channels[i]);
+	_print("- trigger armed: \"%s\"\r\n", TRIGGER_PATTERN);
+}
+
+/**
+ * Switch the panes with a snapshot between it and the live lines.
+ */
+static void _toggle_frozen(void)
+{
+	bool any = false;
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct _channel *ch = &channels[i];
+
+		if (ch->trigger != TRIGGER_FROZEN)
+			continue;
+		any = true;
+		ch->show_frozen = !ch->show_frozen;
+		if (ch->show_frozen) {
+			view_set_store(&ch->view, &ch->snapshot);
+			view_show_line(&ch->view, ch->trigger_seq);
+		} else {
+			view_set_store(&ch->view, &ch->store);
+			view_follow(&ch->view);
 		}
 	}
+	if (!any)
+		_print("- no snapshot\r\n");
+}
+#endif // end of ENABLE_TRIGGER
+
+/**
+ * Add the completed line to the history.
+ */
+static void _line_commit(struct _channel *ch, uint16_t tags)
+{
+	uint32_t seq = line_store_commit(&ch->store);
+
+#ifdef ENABLE_SEARCH
+	search_add(&ch->search, seq);
+#endif // end of ENABLE_SEARCH
+#ifdef ENABLE_TRIGGER
+	_trigger_line(ch, seq, tags);
+#endif // end of ENABLE_TRIGGER
+	(void)seq;
+	(void)tags;
 }
 
-static void line_del(void)
+static void line_add(struct _channel *ch, char c)
 {
-	if( lineBufferPos > 0 ) {
-		lineBufferPos--;
+	uint16_t tags = 0;
+
+#ifdef ENABLE_TIMESTAMP
+	if (!ch->line_open) {
+		line_store_stamp(&ch->store, ch->stamp);
+		ch->line_open = true;
+	}
+#endif // end of ENABLE_TIMESTAMP
+
+	if (c == 0) {
+		// end of line
+#ifdef ENABLE_HIGHLIGHT
+		tags = ch->line_tags;
+		line_store_set_tags(&ch->store, tags);
+		ch->match_state = MATCH_ROOT;
+		ch->line_tags = 0;
+#endif // end of ENABLE_HIGHLIGHT
+#ifdef ENABLE_COLLAPSE
+		/* a repeat only bumps the count of the newest line */
+		if (!line_store_collapse(&ch->store))
+			_line_commit(ch, tags);
+#else
+		_line_commit(ch, tags);
+#endif // end of ENABLE_COLLAPSE
+#ifdef ENABLE_TIMESTAMP
+		ch->line_open = false;
+#endif // end of ENABLE_TIMESTAMP
+	} else {
+#ifdef ENABLE_HIGHLIGHT
+		/* keywords past the stored length still count */
+		ch->match_state = match_step(&matcher, ch->match_state, c);
+		ch->line_tags |= match_tags(&matcher, ch->match_state);
+#endif // end of ENABLE_HIGHLIGHT
+		line_store_putc(&ch->store, c);
 	}
 }
 
+static void line_del(struct _channel *ch)
+{
+	line_store_backspace(&ch->store);
+}
+
 static void screen_clean(void)
 {
+	int i;
+
 	lcd_fill(COLOR_BLACK);
-	frameLineWrite = 0;
-	lineBufferPos = 0;
-	frameLineRead = 0;
-	bufferEmpty = 1;
-	bufferFirstFull = 0;
+	_draw_pane_tags();
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		line_store_clear(&channels[i].store);
+		view_reset(&channels[i].view);
+		utf8_init(&channels[i].utf8);
+#ifdef ENABLE_HEXVIEW
+		hexview_reset(&channels[i].hexview);
+#endif // end of ENABLE_HEXVIEW
+#ifdef ENABLE_TIMESTAMP
+		channels[i].line_open = false;
+#endif // end of ENABLE_TIMESTAMP
+#ifdef ENABLE_HIGHLIGHT
+		channels[i].match_state = MATCH_ROOT;
+		channels[i].line_tags = 0;
+#endif // end of ENABLE_HIGHLIGHT
+#ifdef ENABLE_TRIGGER
+		/* the lines before the trigger are gone */
+		if (channels[i].trigger == TRIGGER_CAPTURING)
+			channels[i].trigger = TRIGGER_ARMED;
+#endif // end of ENABLE_TRIGGER
+	}
+}
+#endif // end of ENABLE_DISPLAY
 
-	
-	for(int i=0; i<MAX_FRAME_LINE_COUNT; i++) {
-		gFrameBuffer[i][0] = 0;
+static uint32_t _now_us(void)
+{
+	return (uint32_t)timer_get_tick() * TIMER_TICK_US;
+}
+
+#ifdef USE_TSTAMP_COUNTER
+static uint32_t _stamp_raw(void)
+{
+	return tc_get_cv(TSTAMP_TC, TSTAMP_TC_CHANNEL);
+}
+
+/**
+ * Start the timestamp counter, free running over the full 32 bits.
+ */
+static void _tstamp_start(void)
+{
+	uint32_t clks;
+
+	pmc_configure_peripheral(get_tc_id_from_addr(TSTAMP_TC), NULL, true);
+	clks = tc_find_best_clock_source(TSTAMP_TC, TSTAMP_TC_CHANNEL, TSTAMP_FREQ);
+	tc_configure(TSTAMP_TC, TSTAMP_TC_CHANNEL,
+		     TC_CMR_TCCLKS(clks) | TC_CMR_WAVE | TC_CMR_WAVSEL_UP);
+	tc_start(TSTAMP_TC, TSTAMP_TC_CHANNEL);
+
+	tstamp_init(&tstamp, tc_get_available_freq(TSTAMP_TC, TSTAMP_TC_CHANNEL, clks),
+		    _stamp_raw());
+	_print("- timestamps: %u Hz\r\n", (unsigned)tstamp.freq);
+}
+#endif // end of USE_TSTAMP_COUNTER
+
+#ifdef ENABLE_REPLAY
+/**
+ * Microseconds from the timestamp counter, main loop only.
+ */
+static uint32_t _clock_us(void)
+{
+	return (uint32_t)tstamp_to_us(&tstamp, tstamp_update(&tstamp, _stamp_raw()));
+}
+#endif // end of ENABLE_REPLAY
+
+/**
+ * Producer side of a channel: store a received byte, marking line starts.
+ */
+static void _rx_put(struct _channel *ch, uint8_t key)
+{
+#ifdef ENABLE_TIMESTAMP
+	if (ch->rx_bol || ring_count(&ch->ring) == 0)
+		tstamp_mark_put(&ch->marks, ch->ring.head, _stamp_raw());
+	ch->rx_bol = (key == '\n');
+#endif // end of ENABLE_TIMESTAMP
+	ring_put(&ch->ring, key);
+}
+
+#if defined(ENABLE_MIRROR) || defined(ENABLE_COMMANDS)
+/**
+ * DBGU interrupt, shared by the console keys and the mirror: queue a
+ * received key; send one queued byte per TXRDY and stop the transmit
+ * interrupt once the queue is empty.
+ */
+static void _dbgu_irq_handler(uint32_t source, void* user_arg)
+{
+	uint32_t sr = DBGU->DBGU_SR;
+
+#ifdef ENABLE_COMMANDS
+	if (sr & DBGU_SR_RXRDY)
+		ring_put(&command_ring, DBGU->DBGU_RHR);
+#endif // end of ENABLE_COMMANDS
+
+#ifdef ENABLE_MIRROR
+	/* TXRDY is also set while the transmit interrupt is off */
+	if (sr & DBGU->DBGU_IMR & DBGU_SR_TXRDY) {
+		uint8_t c;
+
+		if (ring_get(&mirror_ring, &c))
+			DBGU->DBGU_THR = c;
+		else
+			DBGU->DBGU_IDR = DBGU_IDR_TXRDY;
 	}
+#endif // end of ENABLE_MIRROR
 }
+#endif
+
+#ifdef ENABLE_MIRROR
+
+/**
+ * Queue a received byte for the console, never blocks. Lines start with
+ * the channel name.
+ */
+static void _mirror_input(struct _channel *ch, uint8_t key)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	const char *tag;
+
+	if (!mirror_enabled)
+		return;
+
+	if (ch->mirror_bol) {
+		for (tag = ch->cfg->name; *tag; tag++)
+			ring_put(&mirror_ring, *tag);
+		ring_put(&mirror_ring, '>');
+		ring_put(&mirror_ring, ' ');
+		ch->mirror_bol = false;
+	}
+	if (key == '\n')
+		ch->mirror_bol = true;
+
+	if (key < 0x20 && key != '\n' && key != '\r' && key != 0x08) {
+		ring_put(&mirror_ring, '[');
+		ring_put(&mirror_ring, hex[key >> 4]);
+		ring_put(&mirror_ring, hex[key & 0xF]);
+		ring_put(&mirror_ring, ']');
+	}
+	ring_put(&mirror_ring, key);
+}
+
+/**
+ * Start the transmit interrupt if bytes are queued.
+ */
+static void _mirror_kick(void)
+{
+	if (ring_count(&mirror_ring))
+		DBGU->DBGU_IER = DBGU_IER_TXRDY;
+}
+#endif // end of ENABLE_MIRROR
+
+/**
+ * Text path: handle one character of log text.
+ */
+static void _text_input(struct _channel *ch, uint8_t key)
+{
+#ifdef ENABLE_DISPLAY
+	uint32_t cp[2];
+	uint32_t i, n;
+#endif // end of ENABLE_DISPLAY
+
+	if (key == '\n')
+		ch->lines++;
+
+#ifdef ENABLE_DISPLAY
+	if (key >= 0x80 || ch->utf8.left) {
+		/* UTF-8: the line holds the glyph id of every character */
+		n = utf8_feed(&ch->utf8, key, cp);
+		for (i = 0; i < n; i++) {
+			if (cp[i] >= 0x80)
+				line_add(ch, lcd_font_glyph_id(cp[i]));
+			else if (cp[i] >= 0x20)
+				line_add(ch, cp[i]);
+			else if (cp[i] == '\n')
+				line_add(ch, 0);
+			else if (cp[i] == 0x08)
+				line_del(ch);
+		}
+	} else if( key >= 0x20 ) {
+		line_add(ch, key);
+	} else if( key == '\n' ) {
+		line_add(ch, 0);
+	} else if( key == 0x08 ) {
+		line_del(ch);
+	}
 #endif // end of ENABLE_DISPLAY
 
+#ifdef ENABLE_MIRROR
+	_mirror_input(ch, key);
+#endif // end of ENABLE_MIRROR
+}
+
+#ifdef ENABLE_FRAMING
+static void _framing_stage(struct _pipe_stage *stage, const uint8_t *data,
+			   uint32_t len)
+{
+	framing_feed((struct _framing *)stage->ctx, data, len);
+}
+
+static void _framing_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _framing_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_frame((struct _pipe_stage *)arg, data, len);
+}
+#endif // end of ENABLE_FRAMING
+
+#ifdef ENABLE_LZSS
+static void _lzss_stage(struct _pipe_stage *stage, const uint8_t *data,
+			uint32_t len)
+{
+	lzss_feed((struct _lzss *)stage->ctx, data, len);
+}
+
+static void _lzss_out(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+#endif // end of ENABLE_LZSS
+
+#ifdef ENABLE_BINLOG
+static void _binlog_stage(struct _pipe_stage *stage, const uint8_t *data,
+			  uint32_t len)
+{
+	binlog_feed((struct _binlog *)stage->ctx, data, len);
+}
+
+static void _binlog_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	pipe_emit((struct _pipe_stage *)arg, data, len);
+}
+
+static void _binlog_line(void *arg, const char *line, uint32_t len)
+{
+	static const uint8_t eol = '\n';
+
+	pipe_emit((struct _pipe_stage *)arg, (const uint8_t *)line, len);
+	pipe_emit((struct _pipe_stage *)arg, &eol, 1);
+}
+#endif // end of ENABLE_BINLOG
+
+/**
+ * Text sink of the receive pipeline.
+ */
+static void _rx_text(void *arg, const uint8_t *data, uint32_t len)
+{
+	struct _channel *ch = (struct _channel *)arg;
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		_text_input(ch, data[i]);
+}
+
+/**
+ * Frame sink of the receive pipeline: binary frames go to the hex view.
+ */
+static void _rx_frame(void *arg, const uint8_t *data, uint32_t len)
+{
+#ifdef ENABLE_HEXVIEW
+	struct _channel *ch = (struct _channel *)arg;
+
+	hexview_put(&ch->hexview, data, len);
+#endif // end of ENABLE_HEXVIEW
+	(void)arg;
+	(void)data;
+	(void)len;
+}
+
+#ifdef ENABLE_HEXVIEW
+/**
+ * Check whether the hex view of a channel shows the raw bytes, or only
+ * the binary frames when the device frames its output.
+ */
+static bool _rx_raw_hex(const struct _channel *ch)
+{
+#ifdef ENABLE_FRAMING
+	return ch->cfg->framing == FRAMING_NONE;
+#else
+	(void)ch;
+	return true;
+#endif // end of ENABLE_FRAMING
+}
+#endif // end of ENABLE_HEXVIEW
+
+/**
+ * Move one chunk of a channel ring into its input path.
+ *
+ * \return Number of bytes handled.
+ */
+static uint32_t _rx_drain_channel(struct _channel *ch)
+{
+	const uint8_t *data;
+	uint32_t len;
+#ifdef ENABLE_TIMESTAMP
+	const struct _tstamp_mark *mark;
+#endif // end of ENABLE_TIMESTAMP
+
+	len = ring_peek(&ch->ring, &data);
+	if (len == 0)
+		return 0;
+	if (len > RX_DRAIN_CHUNK)
+		len = RX_DRAIN_CHUNK;
+#ifdef ENABLE_TIMESTAMP
+	/* bytes from the first one on arrived at the time of the last mark
+	 * reached, end the segment before the next mark */
+	while ((mark = tstamp_mark_peek(&ch->marks)) != NULL) {
+		int32_t ahead = mark->pos - ch->ring.tail;
+
+		if (ahead > 0) {
+			if (len > (uint32_t)ahead)
+				len = ahead;
+			break;
+		}
+		ch->stamp = tstamp_to_us(&tstamp, tstamp_extend(&tstamp, mark->raw));
+		tstamp_mark_drop(&ch->marks);
+	}
+#endif // end of ENABLE_TIMESTAMP
+#ifdef ENABLE_HEXVIEW
+	if (_rx_raw_hex(ch))
+		hexview_put(&ch->hexview, data, len);
+#endif // end of ENABLE_HEXVIEW
+	pipeline_feed(&ch->pipe, data, len);
+	ring_consume(&ch->ring, len);
+	ch->bytes += len;
+#if defined(ENABLE_MBUS_UART) && defined(ENABLE_FLOW_CONTROL)
+	if (ch->cfg->flow_control)
+		flowctl_on_drain(&ch->flowctl, ring_count(&ch->ring));
+#endif
+	return len;
+}
+
+/**
+ * Drain the receive rings into the input path, one chunk per channel in
+ * turn so a busy channel does not hold the others back.
+ */
+static void _rx_drain(void)
+{
+	uint32_t n;
+	int i;
+
+	do {
+		n = 0;
+#ifdef ENABLE_TIMESTAMP
+		tstamp_update(&tstamp, _stamp_raw());
+#endif // end of ENABLE_TIMESTAMP
+		for (i = 0; i < CHANNEL_COUNT; i++)
+			n += _rx_drain_channel(&channels[i]);
+#ifdef ENABLE_MIRROR
+		_mirror_kick();
+#endif // end of ENABLE_MIRROR
+#ifdef ENABLE_DISPLAY
+		/* input keeps arriving: render at frame rate, lines which
+		 * scroll off in between are never rasterized */
+		if (n && _now_us() - _last_frame_us >= FRAME_PERIOD_US) {
+			screen_update();
+			_last_frame_us = _now_us();
+		}
+#endif // end of ENABLE_DISPLAY
+	} while (n);
+
+#ifdef ENABLE_DISPLAY
+	/* input is idle, show everything */
+	if (screen_dirty()) {
+		screen_update();
+		_last_frame_us = _now_us();
+	}
+#endif // end of ENABLE_DISPLAY
+}
+
+/**
+ * Check whether every receive ring is empty.
+ */
+static bool _rx_idle(void)
+{
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		if (ring_count(&channels[i].ring))
+			return false;
+	}
+	return true;
+}
+
 #ifdef ENABLE_MBUS_UART
 static int _usart_finish_tx_transfer_callback(void* arg, void* arg2)
 {
@@ -271,30 +1456,713 @@ static void _usart_write_buffer(uint8_t *buffer, int size)
 	usartd_wait_tx_transfer(0);
 }
 
+/**
+ * Receive interrupt of a channel, \a user_arg is the channel.
+ */
 static void _usart_irq_handler(uint32_t source, void* user_arg)
 {
-	if (usart_is_rx_ready(USART_ADDR)) {
-		uint8_t key = usart_get_char(USART_ADDR);
-		
+	struct _channel *ch = (struct _channel *)user_arg;
+	Usart *usart = ch->cfg->addr;
+
+	while (usart_is_rx_ready(usart)) {
+		uint8_t key = usart_get_char(usart);
+
+#ifdef ENABLE_CAPTURE
+		if (ch->index == 0)
+			capture_record(&capture, key, _stamp_raw());
+#endif // end of ENABLE_CAPTURE
+
+		_rx_put(ch, key);
+#ifdef ENABLE_FLOW_CONTROL
+		if (ch->cfg->flow_control)
+			flowctl_on_fill(&ch->flowctl, ring_count(&ch->ring));
+#endif // end of ENABLE_FLOW_CONTROL
+	}
+}
+
+#ifdef ENABLE_FLOW_CONTROL
+/**
+ * Drive RTS: high stops the sender, low lets it send. The USART runs in
+ * normal mode, where RTS is only changed by these writes; hardware
+ * handshaking would drive it from the receiver instead.
+ */
+static void _usart_set_rts(void *arg, bool stop)
+{
+	Usart *usart = (Usart *)arg;
+
+	usart->US_CR = stop ? US_CR_RTSDIS : US_CR_RTSEN;
+}
+#endif // end of ENABLE_FLOW_CONTROL
+
+/**
+ * Configure the USART of a channel and start its receive interrupt.
+ */
+static void _channel_start_usart(struct _channel *ch)
+{
+	const struct _channel_config *cfg = ch->cfg;
+	uint32_t id = get_usart_id_from_addr(cfg->addr);
+
+	pio_configure(cfg->pins, cfg->pin_count);
+
+	ch->usart_desc.addr = cfg->addr;
+	ch->usart_desc.baudrate = cfg->baudrate;
+	ch->usart_desc.mode = USART_MODE;
+	ch->usart_desc.transfer_mode = USARTD_MODE_POLLING;
+	ch->usart_desc.timeout = 0; // unit: ms
+	usartd_configure(ch->index, &ch->usart_desc);
+#ifdef ENABLE_FLOW_CONTROL
+	/* normal mode: RTS follows the ring watermarks, not the receiver */
+	if (cfg->flow_control)
+		flowctl_init(&ch->flowctl, RX_HIGH_WATERMARK, RX_LOW_WATERMARK,
+			     _usart_set_rts, _now_us, cfg->addr);
+#endif // end of ENABLE_FLOW_CONTROL
+
+	irq_add_handler(id, _usart_irq_handler, ch);
+	usart_enable_it(cfg->addr, US_IER_RXRDY);
+	irq_enable(id);
+}
+#endif // end of ENABLE_MBUS_UART
+
+/**
+ * Set up the receive path of a channel.
+ */
+static void _channel_init(struct _channel *ch, int index)
+{
+	ch->cfg = &_channel_config[index];
+	ch->index = index;
+	ring_init(&ch->ring, ch->rx_buffer, sizeof(ch->rx_buffer));
+#ifdef ENABLE_TIMESTAMP
+	tstamp_marks_init(&ch->marks, ch->mark_buffer, TSTAMP_MARK_COUNT);
+	ch->rx_bol = true;
+	ch->line_open = false;
+#endif // end of ENABLE_TIMESTAMP
+	pipeline_init(&ch->pipe, _rx_text, _rx_frame, ch);
+#ifdef ENABLE_FRAMING
+	if (ch->cfg->framing != FRAMING_NONE) {
+		framing_init(&ch->framing, ch->cfg->framing, _framing_text,
+			     _framing_frame, &ch->framing_stage);
+		pipeline_add(&ch->pipe, &ch->framing_stage, "framing",
+			     _framing_stage, &ch->framing);
+	}
+#endif // end of ENABLE_FRAMING
+#ifdef ENABLE_LZSS
+	lzss_init(&ch->lzss, _lzss_out, &ch->lzss_stage);
+	pipeline_add(&ch->pipe, &ch->lzss_stage, "lzss", _lzss_stage, &ch->lzss);
+#endif // end of ENABLE_LZSS
+#ifdef ENABLE_BINLOG
+	binlog_init(&ch->binlog, _binlog_text, _binlog_line, &ch->binlog_stage);
+	pipeline_add(&ch->pipe, &ch->binlog_stage, "binlog", _binlog_stage,
+		     &ch->binlog);
+#endif // end of ENABLE_BINLOG
+#ifdef ENABLE_MIRROR
+	ch->mirror_bol = true;
+#endif // end of ENABLE_MIRROR
+}
+
+/**
+ * Print receive path statistics.
+ */
+static void _print_rx_stats(void)
+{
+	uint32_t now = _now_us();
+	uint32_t elapsed_ms = (now - _last_stats_us) / 1000;
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct _channel *ch = &channels[i];
+		struct _pipe_stage *stage;
+		uint32_t delta = ch->bytes - ch->last_bytes;
+
+		_print("- %s: %u bytes, %u lines, %u bytes/s, %u bytes dropped\r\n",
+		       ch->cfg->name, (unsigned)ch->bytes, (unsigned)ch->lines,
+		       elapsed_ms ? (unsigned)((uint64_t)delta * 1000 / elapsed_ms) : 0,
+		       (unsigned)ch->ring.overruns);
+		ch->last_bytes = ch->bytes;
+#ifdef ENABLE_TIMESTAMP
+		if (ch->marks.lost)
+			_print("  timestamps: %u line marks lost\r\n",
+			       (unsigned)ch->marks.lost);
+#endif // end of ENABLE_TIMESTAMP
+#ifdef ENABLE_LZSS
+		_print("  lzss: %u frames, %u -> %u bytes, %u errors\r\n",
+		       (unsigned)ch->lzss.frames, (unsigned)ch->lzss.bytes_in,
+		       (unsigned)ch->lzss.bytes_out, (unsigned)ch->lzss.errors);
+#endif // end of ENABLE_LZSS
+#ifdef ENABLE_BINLOG
+		_print("  binlog: %u records, %u formats received, %u unknown, %u errors\r\n",
+		       (unsigned)ch->binlog.records, (unsigned)ch->binlog.defined,
+		       (unsigned)ch->binlog.unknown, (unsigned)ch->binlog.errors);
+#endif // end of ENABLE_BINLOG
+		for (stage = ch->pipe.first; stage; stage = stage->next)
+			_print("  stage %s: %u -> %u bytes, %u frames\r\n",
+			       stage->name, (unsigned)stage->bytes_in,
+			       (unsigned)stage->bytes_out, (unsigned)stage->frames);
+#ifdef ENABLE_FRAMING
+		if (ch->cfg->framing != FRAMING_NONE)
+			_print("  framing: %u frames, %u lines, %u errors\r\n",
+			       (unsigned)ch->framing.frames,
+			       (unsigned)ch->framing.lines,
+			       (unsigned)ch->framing.errors);
+#endif // end of ENABLE_FRAMING
 #ifdef ENABLE_DISPLAY
-		if( key >= 0x20 ) {
-			line_add(key);
-		} else if( key == '\n' ) {
-			line_add(0);
-			
-			screen_update();
-		} else if( key == 0x08 ) {
-			line_del();
+		_print("  pane: %u frames, %u lines skipped\r\n",
+		       (unsigned)ch->view.frames, (unsigned)ch->view.skipped);
+#endif // end of ENABLE_DISPLAY
+#ifdef ENABLE_COLLAPSE
+		_print("  repeats: %u lines collapsed\r\n",
+		       (unsigned)ch->store.repeats);
+#endif // end of ENABLE_COLLAPSE
+#if defined(ENABLE_MBUS_UART) && defined(ENABLE_FLOW_CONTROL)
+		if (ch->cfg->flow_control)
+			_print("  rts: %u stops, %u ms stopped, longest %u us\r\n",
+			       (unsigned)ch->flowctl.events,
+			       (unsigned)(ch->flowctl.total_us / 1000),
+			       (unsigned)ch->flowctl.max_us);
+#endif
+	}
+	_last_stats_us = now;
+#ifdef ENABLE_MIRROR
+	_print("- mirror: %s, %u bytes dropped\r\n",
+	       mirror_enabled ? "on" : "off", (unsigned)mirror_ring.overruns);
+#endif // end of ENABLE_MIRROR
+}
+
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_HIGHLIGHT)
+/**
+ * Apply a filter to every pane.
+ */
+static void _set_filter(uint16_t filter)
+{
+	int i;
+
+	_filter = filter;
+	for (i = 0; i < CHANNEL_COUNT; i++)
+		view_set_filter(&channels[i].view, filter);
+	_print("- filter: 0x%04x\r\n", (unsigned)filter);
+}
+#endif
+
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_SEARCH)
+/** Query being typed or last run */
+static char _query[SEARCH_MAX_QUERY + 1];
+static uint32_t _query_len;
+static bool _query_edit;
+
+/**
+ * Search every pane for the query, and hold the panes where it is found
+ * on the line.
+ *
+ * \param older  Continue back from the lines shown instead of the newest.
+ */
+static void _search(bool older)
+{
+	uint32_t seq;
+	int i;
+
+	if (_query_len == 0)
+		return;
+
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		struct _channel *ch = &channels[i];
+		uint32_t before = line_store_end(&ch->store);
+
+#ifdef ENABLE_TRIGGER
+		if (ch->show_frozen)
+			continue;
+#endif // end of ENABLE_TRIGGER
+		if (older && ch->view.hold)
+			before = ch->view.anchor;
+		if (search_find(&ch->search, _query, before, &seq)) {
+			view_show_line(&ch->view, seq);
+			_print("- %s: line %u\r\n", ch->cfg->name, (unsigned)seq);
+		} else {
+			_print("- %s: not found\r\n", ch->cfg->name);
 		}
-		else {
-			printf("[%02X]", key);
+	}
+}
+
+/**
+ * Return every pane to its newest lines.
+ */
+static void _follow(void)
+{
+	int i;
+
+	for (i = 0; i < CHANNEL_COUNT; i++)
+		view_follow(&channels[i].view);
+}
+
+/**
+ * Edit the query.
+ *
+ * \return false once the query is complete or abandoned.
+ */
+static bool _query_input(uint8_t c)
+{
+	if (c == '\r' || c == '\n') {
+		_print("\r\n");
+		_search(false);
+		return false;
+	} else if (c == 0x1B) {
+		_print(" (cancelled)\r\n");
+		_query_len = 0;
+		_query[0] = 0;
+		return false;
+	} else if (c == 0x08 || c == 0x7F) {
+		if (_query_len > 0) {
+			_query[--_query_len] = 0;
+			_print("\b \b");
+		}
+	} else if (c >= 0x20 && _query_len < SEARCH_MAX_QUERY) {
+		_query[_query_len++] = c;
+		_query[_query_len] = 0;
+		_print("%c", c);
+	}
+	return true;
+}
+#endif
+
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_COMMANDS)
+/**
+ * Microseconds for the benchmarks. The system tick only counts
+ * milliseconds, too coarse for runs of a few milliseconds: the timestamp
+ * counter is read when it runs.
+ */
+static uint32_t _bench_us(void)
+{
+#ifdef USE_TSTAMP_COUNTER
+	return (uint32_t)tstamp_to_us(&tstamp, tstamp_update(&tstamp, _stamp_raw()));
+#else
+	return _now_us();
+#endif // end of USE_TSTAMP_COUNTER
+}
+
+/**
+ * Reference of the glyph benchmark: the loop lcd_font.c drew characters
+ * with, reading the font tables bit by bit, one lcd_draw_pixel() per set
+ * bit.
+ */
+static void _bench_bitwise_char(uint32_t x, uint32_t y, uint8_t c,
+				uint32_t color)
+{
+	uint8_t font = lcd_get_selected_font();
+	uint8_t width = font_param[font].width;
+	uint8_t height = font_param[font].height;
+	const uint8_t *pfont = font_param[font].pfont;
+	uint32_t row, col;
+	uint8_t Ch;
+
+	switch (font) {
+	case FONT10x14:
+		for (col = 0; col < width; col++) {
+			for (row = 0; row < 8; row++) {
+				Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
+				if (Ch)
+					lcd_draw_pixel(x + col, y + row, color);
+			}
+			for (row = 0; row < 6; row++) {
+				Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
+				if (Ch)
+					lcd_draw_pixel(x + col, y + row + 8, color);
+			}
+		}
+		break;
+
+	case FONT10x8:
+		for (col = 0; col < width; col++) {
+			Ch = pfont[((c - 0x20) * width) + col];
+			if (Ch) {
+				for (row = 0; row < height; row++) {
+					if ((Ch >> row) & 0x1)
+						lcd_draw_pixel(x + (height - row), y + col, color);
+				}
+			}
+		}
+		break;
+
+	case FONT8x8:
+	case FONT6x8:
+		for (col = 0; col < width; col++) {
+			Ch = pfont[((c - 0x20) * width) + col];
+			if (Ch) {
+				for (row = 0; row < height; row++) {
+					if ((Ch >> row) & 0x1) {
+						if (font == FONT8x8)
+							lcd_draw_pixel(x + row, y + col, color);
+						else
+							lcd_draw_pixel(x + col, y + row, color);
+					}
+				}
+			}
+		}
+		break;
+	}
+}
+
+/**
+ * Time the glyph drawing of every font, with the original bit by bit loop
+ * and through lcd_draw_char(), then repaint the panes.
+ *
+ * Both draw the full glyph cells of the font: proportional spacing,
+ * anti-aliasing and scaling are off while they are timed.
+ */
+static void _bench_glyphs(void)
+{
+	static const char *names[NB_FONT] = { "10x14", "10x8", "8x8", "6x8" };
+	uint32_t font, i, start, bitwise, table;
+
+#ifdef ENABLE_PROPORTIONAL
+	lcd_set_proportional(false);
+#endif // end of ENABLE_PROPORTIONAL
+#ifdef ENABLE_TEXT_SCALE
+	lcd_set_text_scale(1);
+#endif // end of ENABLE_TEXT_SCALE
+#ifdef ENABLE_ANTIALIAS
+	lcd_set_antialiased(0, 0);
+#endif // end of ENABLE_ANTIALIAS
+	for (font = 0; font < NB_FONT; font++) {
+		lcd_select_font(font);
+
+		start = _bench_us();
+		for (i = 0; i < GLYPH_BENCH_COUNT; i++)
+			_bench_bitwise_char(START_POS_X + (i % 60) * 12,
+					    START_POS_Y + (i / 60 % 20) * 20,
+					    ' ' + i % 96, COLOR_WHITE);
+		bitwise = _bench_us() - start;
+
+		start = _bench_us();
+		for (i = 0; i < GLYPH_BENCH_COUNT; i++)
+			lcd_draw_char(START_POS_X + (i % 60) * 12,
+				      START_POS_Y + (i / 60 % 20) * 20,
+				      ' ' + i % 96, COLOR_WHITE);
+		table = _bench_us() - start;
+
+		_print("- font %s: bitwise %u ns, table %u ns per glyph\r\n",
+		       names[font],
+		       (unsigned)(bitwise * 1000 / GLYPH_BENCH_COUNT),
+		       (unsigned)(table * 1000 / GLYPH_BENCH_COUNT));
+	}
+	lcd_select_font(FONT10x14);
+#ifdef ENABLE_TEXT_SCALE
+	lcd_set_text_scale(TEXT_SCALE);
+	start = _bench_us();
+	for (i = 0; i < GLYPH_BENCH_COUNT; i++)
+		lcd_draw_char(START_POS_X + (i % 30) * 24,
+			      START_POS_Y + (i / 30 % 10) * 40,
+			      ' ' + i % 96, COLOR_WHITE);
+	table = _bench_us() - start;
+	_print("- font 10x14 x%u: %u ns per glyph\r\n", TEXT_SCALE,
+	       (unsigned)(table * 1000 / GLYPH_BENCH_COUNT));
+#endif // end of ENABLE_TEXT_SCALE
+#ifdef ENABLE_PROPORTIONAL
+	lcd_set_proportional(true);
+#endif // end of ENABLE_PROPORTIONAL
+#ifdef ENABLE_ANTIALIAS
+	lcd_set_antialiased(AA_GLYPH_WIDTH, AA_GLYPH_HEIGHT);
+#endif // end of ENABLE_ANTIALIAS
+
+	lcd_fill(COLOR_BLACK);
+	_draw_pane_tags();
+	for (i = 0; i < CHANNEL_COUNT; i++) {
+		view_reset(&channels[i].view);
+#ifdef ENABLE_HEXVIEW
+		hexview_reset(&channels[i].hexview);
+#endif // end of ENABLE_HEXVIEW
+	}
+}
+
+/**
+ * Time BASE_BENCH_PASSES reads of the history arrays, which are much larger
+ * than the data cache and so are read from DDR.
+ *
+ * \return Elapsed ticks.
+ */
+static uint32_t _bench_ddr_read(void)
+{
+	const uint32_t *words = (const uint32_t *)_history;
+	uint32_t count = sizeof(_history) / sizeof(uint32_t);
+	volatile uint32_t sum = 0;
+	uint32_t start = timer_get_tick();
+	uint32_t pass, i;
+
+	for (pass = 0; pass < BASE_BENCH_PASSES; pass++)
+		for (i = 0; i < count; i++)
+			sum += words[i];
+	return timer_get_tick() - start;
+}
+
+/**
+ * Measure the DDR bandwidth left to the CPU while the LCDC fetches a base
+ * layer frame buffer and while the base layer shows its default color.
+ * The layer stays under the full-screen canvas, nothing visible changes.
+ */
+static void _bench_base(void)
+{
+	uint32_t bytes = BASE_BENCH_PASSES * sizeof(_history);
+	uint32_t fetch, color;
+
+#ifdef ENABLE_BASE_COLOR
+	/* no base buffer any more, fetch the canvas instead */
+	lcdc_base_show_buffer(_ovr1_buffer, CANVAS_BPP);
+	_print("- base layer fetching %u bytes per frame:\r\n",
+	       (unsigned)sizeof(_ovr1_buffer));
+#else
+	lcdc_base_show_buffer(_base_buffer, 24);
+	_print("- base layer fetching %u bytes per frame:\r\n",
+	       (unsigned)sizeof(_base_buffer));
+#endif // end of ENABLE_BASE_COLOR
+	/* let the layer change take effect at the next frame */
+	timer_wait(FRAME_PERIOD_US / TIMER_TICK_US);
+	fetch = _bench_ddr_read() * TIMER_TICK_US;
+	lcdc_base_show_color(COLOR_BLACK);
+	timer_wait(FRAME_PERIOD_US / TIMER_TICK_US);
+	color = _bench_ddr_read() * TIMER_TICK_US;
+#ifndef ENABLE_BASE_COLOR
+	lcdc_base_show_buffer(_base_buffer, 24);
+#endif // end of ENABLE_BASE_COLOR
+
+	_print("- DDR read: %u MB/s fetched, %u MB/s default color\r\n",
+	       (unsigned)(fetch ? bytes / fetch : 0),
+	       (unsigned)(color ? bytes / color : 0));
+}
+
+#ifdef ENABLE_BAND_STAGING
+/**
+ * Time BAND_BENCH_PASSES repaints of every pane.
+ *
+ * \return Elapsed ticks.
+ */
+static uint32_t _bench_repaint(void)
+{
+	uint32_t start = timer_get_tick();
+	int pass, i;
+
+	for (pass = 0; pass < BAND_BENCH_PASSES; pass++) {
+		for (i = 0; i < CHANNEL_COUNT; i++) {
+			view_reset(&channels[i].view);
+#ifdef ENABLE_HEXVIEW
+			hexview_reset(&channels[i].hexview);
+#endif // end of ENABLE_HEXVIEW
 		}
+		screen_update();
+	}
+	return timer_get_tick() - start;
+}
+
+/**
+ * Compare repaints drawn straight to the canvas and through the staging
+ * band.
+ */
+static void _bench_band(void)
+{
+	uint32_t direct, staged;
+
+	lcd_set_band_buffer(NULL, 0);
+	direct = _bench_repaint();
+	lcd_set_band_buffer(_band_buffer, sizeof(_band_buffer));
+	staged = _bench_repaint();
+
+	_print("- repaint: direct %u us, staged %u us\r\n",
+	       (unsigned)(direct * TIMER_TICK_US / BAND_BENCH_PASSES),
+	       (unsigned)(staged * TIMER_TICK_US / BAND_BENCH_PASSES));
+}
+#endif // end of ENABLE_BAND_STAGING
+#endif
+
+#ifdef ENABLE_COMMANDS
+static void _print_commands(void)
+{
+	_print("- keys:\r\n");
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_HIGHLIGHT)
+	_print("  0 all lines, 1 fatal, 2 +error, 3 +warning, u toggle keywords\r\n");
+#endif
+#ifdef ENABLE_MIRROR
+	_print("  m toggle console mirror\r\n");
+#endif // end of ENABLE_MIRROR
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_SEARCH)
+	_print("  / search, n older match, f follow new lines\r\n");
+#endif
+#ifdef ENABLE_TRIGGER
+	_print("  r re-arm trigger, z or PD18 toggle snapshot/live\r\n");
+#endif // end of ENABLE_TRIGGER
+#ifdef ENABLE_HEXVIEW
+	_print("  x toggle lines/hex dump\r\n");
+#endif // end of ENABLE_HEXVIEW
+#ifdef ENABLE_DISPLAY
+	_print("  c clear panes, g glyph drawing benchmark\r\n");
+	_print("  w base layer bandwidth benchmark\r\n");
 #endif // end of ENABLE_DISPLAY
+#ifdef ENABLE_BAND_STAGING
+	_print("  b band staging benchmark\r\n");
+#endif // end of ENABLE_BAND_STAGING
+	_print("  s statistics, h help\r\n");
+}
+
+/**
+ * Handle the keys typed on the console.
+ */
+static void _poll_commands(void)
+{
+	uint8_t c;
 
-		printf("%c", key);
+	while (ring_get(&command_ring, &c)) {
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_SEARCH)
+		if (_query_edit) {
+			_query_edit = _query_input(c);
+			continue;
+		}
+#endif
+		switch (c) {
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_HIGHLIGHT)
+		case '0':
+			_set_filter(VIEW_FILTER_NONE);
+			break;
+		case '1':
+			_set_filter(1 << TAG_FATAL);
+			break;
+		case '2':
+			_set_filter((1 << TAG_FATAL) | (1 << TAG_ERROR));
+			break;
+		case '3':
+			_set_filter((1 << TAG_FATAL) | (1 << TAG_ERROR) |
+				    (1 << TAG_WARN));
+			break;
+		case 'u':
+			_set_filter(_filter ^ (1 << TAG_USER));
+			break;
+#endif
+#ifdef ENABLE_MIRROR
+		case 'm':
+			mirror_enabled = !mirror_enabled;
+			_print("- mirror %s\r\n", mirror_enabled ? "on" : "off");
+			break;
+#endif // end of ENABLE_MIRROR
+#if defined(ENABLE_DISPLAY) && defined(ENABLE_SEARCH)
+		case '/':
+			_query_len = 0;
+			_query[0] = 0;
+			_query_edit = true;
+			_print("/");
+			break;
+		case 'n':
+			_search(true);
+			break;
+		case 'f':
+			_follow();
+			break;
+#endif
+#ifdef ENABLE_TRIGGER
+		case 'r':
+			_trigger_arm_all();
+			break;
+		case 'z':
+			_toggle_frozen();
+			break;
+#endif // end of ENABLE_TRIGGER
+#ifdef ENABLE_HEXVIEW
+		case 'x':
+			_toggle_hex();
+			break;
+#endif // end of ENABLE_HEXVIEW
+#ifdef ENABLE_DISPLAY
+		case 'c':
+			screen_clean();
+			break;
+		case 'g':
+			_bench_glyphs();
+			break;
+		case 'w':
+			_bench_base();
+			break;
+#endif // end of ENABLE_DISPLAY
+#ifdef ENABLE_BAND_STAGING
+		case 'b':
+			_bench_band();
+			break;
+#endif // end of ENABLE_BAND_STAGING
+		case 's':
+			_print_rx_stats();
+			break;
+		case 'h':
+		case '?':
+			_print_commands();
+			break;
+		}
 	}
 }
-#endif // end of ENABLE_MBUS_UART
+#endif // end of ENABLE_COMMANDS
+
+#ifdef ENABLE_CAPTURE
+/**
+ * Freeze the capture ring into a blob which can be dumped with the debugger
+ * and replayed later, then restart recording.
+ */
+static void _capture_snapshot(void)
+{
+	uint32_t len;
+
+	capture_stop(&capture);
+	len = capture_export(&capture, _capture_export, sizeof(_capture_export));
+	_print("- capture: %u records (%u evicted), blob %u bytes at 0x%08x\r\n",
+	       (unsigned)capture.records, (unsigned)capture.evicted,
+	       (unsigned)len, (unsigned)(uintptr_t)_capture_export);
+	capture_start(&capture);
+}
+#endif // end of ENABLE_CAPTURE
+
+#ifdef ENABLE_REPLAY
+static bool _replay_active;
+
+static void _replay_begin(void)
+{
+	if (replay_start(&replay, replay_data, replay_data_size,
+			 REPLAY_SPEED, _clock_us()) < 0) {
+		_print("-E- replay blob not recognized\r\n");
+		return;
+	}
+#ifdef ENABLE_MBUS_UART
+	/* the live port shares the input path, mute it for a deterministic run */
+	irq_disable(get_usart_id_from_addr(channels[0].cfg->addr));
+#endif
+	_print("- replay: %u bytes, speed %u\r\n",
+	       (unsigned)replay_data_size, (unsigned)REPLAY_SPEED);
+	_replay_active = true;
+}
+
+/**
+ * Feed the bytes which are due into the receive ring of the first channel.
+ *
+ * \return true while the replay runs.
+ */
+static bool _replay_poll(void)
+{
+	uint32_t now;
+	uint8_t key;
+	int n = 0;
+
+	if (!_replay_active)
+		return false;
+
+	now = _clock_us();
+	while (n < REPLAY_BURST && ring_free(&channels[0].ring) > 0 &&
+	       replay_next(&replay, now, &key)) {
+		_rx_put(&channels[0], key);
+		n++;
+	}
+
+	/* report once the input path has consumed everything */
+	if (replay_done(&replay) && ring_count(&channels[0].ring) == 0) {
+		_replay_active = false;
+		_print("- replay done: %u bytes in %u us\r\n",
+		       (unsigned)replay.bytes,
+		       (unsigned)(_clock_us() - replay.start_us));
+#ifdef ENABLE_MBUS_UART
+		irq_enable(get_usart_id_from_addr(channels[0].cfg->addr));
+#endif
+	}
+	return _replay_active;
+}
+#endif // end of ENABLE_REPLAY
 
 
 /*----------------------------------------------------------------------------
@@ -302,6 +2170,8 @@ static void _usart_irq_handler(uint32_t source, void* user_arg)
  *----------------------------------------------------------------------------*/
 int main (void)
 {
+	int i;
+
 #ifdef ENABLE_DISPLAY
 	gKeyPressed = 0;
 #endif // end of ENABLE_DISPLAY
@@ -309,17 +2179,49 @@ int main (void)
 	/* Output example information */
 	console_example_info("USART Example");
 
+#ifdef USE_TSTAMP_COUNTER
+	_tstamp_start();
+#endif // end of USE_TSTAMP_COUNTER
+
+#ifdef ENABLE_HIGHLIGHT
+	if (match_compile(&matcher, _keywords, ARRAY_SIZE(_keywords), true,
+			  _match_table, ARRAY_SIZE(_match_table)) < 0)
+		_print("-E- keywords do not fit the automaton\r\n");
+	else
+		_print("- highlight: %u keywords, %u states\r\n",
+		       (unsigned)ARRAY_SIZE(_keywords), (unsigned)matcher.states);
+#endif // end of ENABLE_HIGHLIGHT
+
+	for (i = 0; i < CHANNEL_COUNT; i++)
+		_channel_init(&channels[i], i);
+
+#ifdef ENABLE_MIRROR
+	/* received bytes are echoed on the console from the DBGU transmit
+	 * interrupt, the input path never waits for the console */
+	ring_init(&mirror_ring, _mirror_buffer, sizeof(_mirror_buffer));
+#endif // end of ENABLE_MIRROR
+#ifdef ENABLE_COMMANDS
+	ring_init(&command_ring, _command_buffer, sizeof(_command_buffer));
+	DBGU->DBGU_IER = DBGU_IER_RXRDY;
+#endif // end of ENABLE_COMMANDS
+#if defined(ENABLE_MIRROR) || defined(ENABLE_COMMANDS)
+	irq_add_handler(ID_DBGU, _dbgu_irq_handler, NULL);
+	irq_enable(ID_DBGU);
+#endif
+
 #ifdef ENABLE_MBUS_UART
 	// UART pin select
 	pio_configure(&pio_output, 1);
 	pio_clear(&pio_output);
 	
-	uint32_t id = get_usart_id_from_addr(USART_ADDR);
-	pio_configure(usart_pins, ARRAY_SIZE(usart_pins));
-	usartd_configure(0, &usart_desc);
-	irq_add_handler(id, _usart_irq_handler, NULL);
-	usart_enable_it(USART_ADDR, US_IER_RXRDY);
-	irq_enable(id);
+#ifdef ENABLE_CAPTURE
+	/* the first channel is recorded */
+	capture_init(&capture, _capture_buffer, sizeof(_capture_buffer),
+		     tstamp.freq);
+	capture_start(&capture);
+#endif // end of ENABLE_CAPTURE
+	for (i = 0; i < CHANNEL_COUNT; i++)
+		_channel_start_usart(&channels[i]);
 	
 	_usart_write_buffer((uint8_t *)test_patten, sizeof(test_patten));
 #endif // end of ENABLE_MBUS_UART
@@ -341,18 +2243,47 @@ int main (void)
 	/* Configure LCD */
 	_LcdOn();
 
-	printf("Width = %d, Height=%d\r\n", BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT);
+	_print("Width = %d, Height=%d\r\n", BOARD_LCD_WIDTH, BOARD_LCD_HEIGHT);
 #endif // end of ENABLE_DISPLAY
 
+#ifdef ENABLE_REPLAY
+	_replay_begin();
+#endif // end of ENABLE_REPLAY
+
+#ifdef ENABLE_COMMANDS
+	_print_commands();
+#endif // end of ENABLE_COMMANDS
+
 	while (1) {
-		cpu_idle();
+		bool busy = false;
+
+#ifdef ENABLE_REPLAY
+		/* do not sleep while a replay runs, the next byte may be due
+		 * long before the next system tick */
+		busy = _replay_poll();
+#endif // end of ENABLE_REPLAY
+		_rx_drain();
+#ifdef ENABLE_COMMANDS
+		_poll_commands();
+#endif // end of ENABLE_COMMANDS
+
+		if (!busy && _rx_idle())
+			cpu_idle();
 #ifdef ENABLE_KEYINPUT
 		if( gKeyPressed ) {
-			printf("key pressed\n\r");
+			_print("key pressed\n\r");
 			gKeyPressed = 0;
+#ifdef ENABLE_TRIGGER
+			_toggle_frozen();
+#else
+			_print_rx_stats();
 #ifdef ENABLE_DISPLAY
 			screen_clean();
 #endif // end of ENABLE_DISPLAY
+#endif // end of ENABLE_TRIGGER
+#ifdef ENABLE_CAPTURE
+			_capture_snapshot();
+#endif // end of ENABLE_CAPTURE
 
 		}
 #endif //  end of ENABLE_KEYINPUT
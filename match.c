@@ -0,0 +1,207 @@
+/**
+ * \file
+ *
+ * Multi-pattern keyword matcher, see match.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "match.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint8_t _fold(uint8_t c, bool nocase)
+{
+	if (nocase && c >= 'a' && c <= 'z')
+		return c - 'a' + 'A';
+	return c;
+}
+
+/**
+ * Allocate a state with no transitions.
+ *
+ * \return The state, or 0 if the table is full.
+ */
+static uint16_t _new_state(struct _match *m)
+{
+	uint32_t width = 1 + m->classes;
+	uint16_t s = m->states;
+
+	if (s == MATCH_MAX_STATES || (s + 1) * width > m->size)
+		return 0;
+	memset(&m->table[s * width], 0, width * sizeof(m->table[0]));
+	m->states++;
+	return s;
+}
+
+/**
+ * Turn \a m into an automaton which matches nothing, after a failed compile.
+ */
+static int _fail(struct _match *m)
+{
+	static uint16_t empty[2];
+
+	memset(m->cls, 0, sizeof(m->cls));
+	m->classes = 1;
+	m->states = 1;
+	m->table = empty;
+	m->size = sizeof(empty) / sizeof(empty[0]);
+	return -1;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Compile a keyword list.
+ *
+ * \param m         Matcher instance.
+ * \param patterns  Keywords, empty ones are ignored.
+ * \param count     Number of keywords.
+ * \param nocase    Match ASCII letters regardless of case.
+ * \param table     Transition table storage.
+ * \param size      Number of 16-bit entries in \a table, at most 65536.
+ *
+ * \return 0 on success, -1 if the keywords do not fit; the matcher then
+ * matches nothing.
+ */
+int match_compile(struct _match *m, const struct _match_pattern *patterns,
+		  uint32_t count, bool nocase, uint16_t *table, uint32_t size)
+{
+	uint32_t width, head = 0, tail = 0;
+	uint32_t i, k;
+	uint16_t s, t;
+	const char *p;
+
+	if (size > 65536)
+		size = 65536;
+
+	/* input classes */
+	memset(m->cls, 0, sizeof(m->cls));
+	m->classes = 1;
+	for (i = 0; i < count; i++) {
+		if (patterns[i].tag >= MATCH_MAX_TAGS)
+			return _fail(m);
+		for (p = patterns[i].text; *p; p++) {
+			uint8_t c = _fold(*p, nocase);
+
+			if (m->cls[c])
+				continue;
+			if (m->classes == MATCH_MAX_CLASSES)
+				return _fail(m);
+			m->cls[c] = m->classes++;
+		}
+	}
+	if (nocase) {
+		for (k = 'a'; k <= 'z'; k++)
+			m->cls[k] = m->cls[k - 'a' + 'A'];
+	}
+	width = 1 + m->classes;
+
+	/* keyword trie, entry 0 of a row holds the tags */
+	m->table = table;
+	m->size = size;
+	m->states = 0;
+	if (m->size < width)
+		return _fail(m);
+	_new_state(m);
+	for (i = 0; i < count; i++) {
+		if (!*patterns[i].text)
+			continue;
+		s = MATCH_ROOT;
+		for (p = patterns[i].text; *p; p++) {
+			uint16_t *next = &table[s * width + 1 + m->cls[_fold(*p, nocase)]];
+
+			if (!*next) {
+				t = _new_state(m);
+				if (!t)
+					return _fail(m);
+				*next = t;
+			}
+			s = *next;
+		}
+		table[s * width] |= 1 << patterns[i].tag;
+	}
+
+	/* failure links in breadth first order, missing transitions take the
+	 * transition of the failure state */
+	for (k = 1; k < m->classes; k++) {
+		t = table[1 + k];
+		if (t) {
+			m->fail[t] = MATCH_ROOT;
+			m->queue[tail++] = t;
+		}
+	}
+	while (head < tail) {
+		s = m->queue[head++];
+		table[s * width] |= table[m->fail[s] * width];
+		for (k = 0; k < m->classes; k++) {
+			uint16_t *next = &table[s * width + 1 + k];
+			uint16_t f = table[m->fail[s] * width + 1 + k];
+
+			if (*next) {
+				m->fail[*next] = f;
+				m->queue[tail++] = *next;
+			} else {
+				*next = f;
+			}
+		}
+	}
+
+	/* transitions as row offsets, saves a multiply per byte */
+	for (i = 0; i < m->states; i++)
+		for (k = 0; k < m->classes; k++)
+			table[i * width + 1 + k] *= width;
+	return 0;
+}
+
+/**
+ * \brief Advance the automaton by one byte.
+ *
+ * \return The new state.
+ */
+uint16_t match_step(const struct _match *m, uint16_t state, uint8_t c)
+{
+	return m->table[state + 1 + m->cls[c]];
+}
+
+/**
+ * \brief Tags of the keywords ending at \a state.
+ */
+uint16_t match_tags(const struct _match *m, uint16_t state)
+{
+	return m->table[state];
+}
+
+/**
+ * \brief Run the automaton over a buffer.
+ *
+ * \param m      Matcher instance.
+ * \param state  Start state, updated.
+ * \param data   Input bytes.
+ * \param len    Number of bytes.
+ *
+ * \return Tags of all the keywords found.
+ */
+uint16_t match_run(const struct _match *m, uint16_t *state,
+		   const uint8_t *data, uint32_t len)
+{
+	const uint16_t *table = m->table;
+	const uint8_t *cls = m->cls;
+	uint16_t s = *state, tags = 0;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		s = table[s + 1 + cls[data[i]]];
+		tags |= table[s];
+	}
+	*state = s;
+	return tags;
+}
@@ -0,0 +1,80 @@
+/**
+ * \file
+ *
+ * Multi-pattern keyword matcher (Aho-Corasick).
+ *
+ * The keyword list is compiled once into a deterministic automaton: every
+ * state has a transition for every input class, so matching costs one
+ * table load per byte whatever the number of keywords. Bytes that occur
+ * in no keyword share one input class, which keeps the table small.
+ *
+ * Each keyword carries a tag bit. Every state holds the tags of all the
+ * keywords which end there, including the ones which are suffixes of
+ * longer keywords, so the tags of a line are the OR of the tags of the
+ * states it visits.
+ *
+ * Table rows are (1 + classes) 16-bit entries: the tags of the state
+ * followed by the transitions, stored as row offsets.
+ */
+
+#ifndef _MATCH_H_
+#define _MATCH_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest automaton: total keyword length + 1 */
+#define MATCH_MAX_STATES        1024
+/** Distinct keyword bytes + 1 */
+#define MATCH_MAX_CLASSES       96
+/** Number of tag bits */
+#define MATCH_MAX_TAGS          16
+
+/** Start state, at the beginning of every line */
+#define MATCH_ROOT              0
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _match_pattern {
+	const char *text;
+	uint8_t tag;            /* tag bit, 0 .. MATCH_MAX_TAGS - 1 */
+};
+
+struct _match {
+	uint8_t cls[256];       /* input class of every byte */
+	uint16_t classes;
+	uint16_t states;
+	uint16_t *table;        /* states x (1 + classes) entries */
+	uint32_t size;          /* table entries available */
+
+	/* compile scratch */
+	uint16_t fail[MATCH_MAX_STATES];
+	uint16_t queue[MATCH_MAX_STATES];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern int match_compile(struct _match *m, const struct _match_pattern *patterns,
+			 uint32_t count, bool nocase, uint16_t *table,
+			 uint32_t size);
+
+extern uint16_t match_step(const struct _match *m, uint16_t state, uint8_t c);
+
+extern uint16_t match_tags(const struct _match *m, uint16_t state);
+
+extern uint16_t match_run(const struct _match *m, uint16_t *state,
+			  const uint8_t *data, uint32_t len);
+
+#endif /* _MATCH_H_ */
@@ -0,0 +1,108 @@
+/**
+ * \file
+ *
+ * Receive pipeline, see pipeline.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "pipeline.h"
+
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _stage_feed(struct _pipe_stage *stage, const uint8_t *data,
+			uint32_t len)
+{
+	stage->bytes_in += len;
+	stage->feed(stage, data, len);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty pipeline, which hands its input to \a text.
+ *
+ * \param pipe   Pipeline instance.
+ * \param text   Receives the output of the last stage.
+ * \param frame  Receives the binary frames of every stage, may be NULL to
+ *               drop them.
+ * \param arg    Argument passed to the sinks.
+ */
+void pipeline_init(struct _pipeline *pipe, pipe_sink_t text, pipe_sink_t frame,
+		   void *arg)
+{
+	pipe->first = NULL;
+	pipe->last = NULL;
+	pipe->text = text;
+	pipe->frame = frame;
+	pipe->arg = arg;
+}
+
+/**
+ * \brief Append a stage.
+ *
+ * \param pipe   Pipeline instance.
+ * \param stage  Stage instance, owned by the caller.
+ * \param name   Tag in the statistics.
+ * \param feed   Decoder entry point.
+ * \param ctx    Decoder instance, for \a feed.
+ */
+void pipeline_add(struct _pipeline *pipe, struct _pipe_stage *stage,
+		  const char *name, pipe_feed_t feed, void *ctx)
+{
+	stage->name = name;
+	stage->feed = feed;
+	stage->ctx = ctx;
+	stage->pipe = pipe;
+	stage->next = NULL;
+	stage->bytes_in = 0;
+	stage->bytes_out = 0;
+	stage->frames = 0;
+
+	if (pipe->last)
+		pipe->last->next = stage;
+	else
+		pipe->first = stage;
+	pipe->last = stage;
+}
+
+/**
+ * \brief Feed a segment of received bytes to the first stage.
+ */
+void pipeline_feed(struct _pipeline *pipe, const uint8_t *data, uint32_t len)
+{
+	if (pipe->first)
+		_stage_feed(pipe->first, data, len);
+	else
+		pipe->text(pipe->arg, data, len);
+}
+
+/**
+ * \brief Pass decoded bytes from a stage to the next one.
+ */
+void pipe_emit(struct _pipe_stage *stage, const uint8_t *data, uint32_t len)
+{
+	stage->bytes_out += len;
+	if (stage->next)
+		_stage_feed(stage->next, data, len);
+	else
+		stage->pipe->text(stage->pipe->arg, data, len);
+}
+
+/**
+ * \brief Hand a binary frame from a stage to the frame sink.
+ */
+void pipe_frame(struct _pipe_stage *stage, const uint8_t *data, uint32_t len)
+{
+	stage->frames++;
+	if (stage->pipe->frame)
+		stage->pipe->frame(stage->pipe->arg, data, len);
+}
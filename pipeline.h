@@ -0,0 +1,83 @@
+/**
+ * \file
+ *
+ * Receive pipeline: a chain of decoder stages between the receive ring and
+ * the line store.
+ *
+ * Stages are registered in order with pipeline_add(). Segments of received
+ * bytes enter the first stage; every stage hands what it decodes to the
+ * next one with pipe_emit(), and the last one to the text sink of the
+ * pipeline. A stage which extracts binary data hands it to the frame sink
+ * with pipe_frame() instead, it does not go through the following stages.
+ *
+ * Segments are passed by pointer. A stage which lets a run of bytes through
+ * unchanged emits it in place, so plain text crosses every stage without
+ * being copied; only decoded data lives in the buffers of the stages.
+ *
+ * Every stage counts the bytes it received and passed on.
+ */
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _pipe_stage;
+struct _pipeline;
+
+/** Decode a segment, output goes to pipe_emit() and pipe_frame() */
+typedef void (*pipe_feed_t)(struct _pipe_stage *stage, const uint8_t *data,
+			    uint32_t len);
+
+/** Output of the pipeline */
+typedef void (*pipe_sink_t)(void *arg, const uint8_t *data, uint32_t len);
+
+struct _pipe_stage {
+	const char *name;      /* tag in the statistics */
+	pipe_feed_t feed;
+	void *ctx;             /* decoder instance */
+	struct _pipeline *pipe;
+	struct _pipe_stage *next;
+
+	/* statistics */
+	uint32_t bytes_in;     /* bytes fed */
+	uint32_t bytes_out;    /* bytes passed to the next stage */
+	uint32_t frames;       /* binary frames handed to the frame sink */
+};
+
+struct _pipeline {
+	struct _pipe_stage *first;
+	struct _pipe_stage *last;
+	pipe_sink_t text;      /* output of the last stage */
+	pipe_sink_t frame;     /* binary frames of any stage */
+	void *arg;             /* argument of the sinks */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void pipeline_init(struct _pipeline *pipe, pipe_sink_t text,
+			  pipe_sink_t frame, void *arg);
+
+extern void pipeline_add(struct _pipeline *pipe, struct _pipe_stage *stage,
+			 const char *name, pipe_feed_t feed, void *ctx);
+
+extern void pipeline_feed(struct _pipeline *pipe, const uint8_t *data,
+			  uint32_t len);
+
+extern void pipe_emit(struct _pipe_stage *stage, const uint8_t *data,
+		      uint32_t len);
+
+extern void pipe_frame(struct _pipe_stage *stage, const uint8_t *data,
+		       uint32_t len);
+
+#endif /* _PIPELINE_H_ */
@@ -0,0 +1,62 @@
+/**
+ * \file
+ *
+ * Capture blob replayed when ENABLE_REPLAY is set in main.c.
+ *
+ * Replace the table with a field capture: dump the output of
+ * capture_export() from the target memory (or record it on the host) and
+ * convert it with "xxd -i".
+ */
+
+#include "capture.h"
+
+const uint8_t replay_data[] = {
+	0x55, 0x43, 0x41, 0x50, 0x01, 0x00, 0x00, 0x00, 0x00, 0x5B, 0x57, 0x20,
+	0x57, 0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x30, 0x57, 0x2E, 0x57, 0x30,
+	0x57, 0x30, 0x57, 0x30, 0x57, 0x30, 0x57, 0x30, 0x57, 0x30, 0x57, 0x5D,
+	0x57, 0x20, 0x57, 0x62, 0x57, 0x6F, 0x57, 0x6F, 0x57, 0x74, 0x57, 0x3A,
+	0x57, 0x20, 0x57, 0x53, 0x57, 0x41, 0x57, 0x4D, 0x57, 0x39, 0x57, 0x58,
+	0x57, 0x36, 0x57, 0x30, 0x57, 0x20, 0x57, 0x72, 0x57, 0x65, 0x57, 0x76,
+	0x57, 0x20, 0x57, 0x42, 0x57, 0x2C, 0x57, 0x20, 0x57, 0x44, 0x57, 0x44,
+	0x57, 0x52, 0x57, 0x20, 0x57, 0x36, 0x57, 0x34, 0x57, 0x4D, 0x57, 0x42,
+	0x57, 0x0D, 0x57, 0x0A, 0x98, 0x75, 0x5B, 0x57, 0x20, 0x57, 0x20, 0x57,
+	0x20, 0x57, 0x20, 0x57, 0x30, 0x57, 0x2E, 0x57, 0x30, 0x57, 0x30, 0x57,
+	0x31, 0x57, 0x32, 0x57, 0x35, 0x57, 0x30, 0x57, 0x5D, 0x57, 0x20, 0x57,
+	0x63, 0x57, 0x6C, 0x57, 0x6B, 0x57, 0x3A, 0x57, 0x20, 0x57, 0x50, 0x57,
+	0x4C, 0x57, 0x4C, 0x57, 0x41, 0x57, 0x20, 0x57, 0x36, 0x57, 0x30, 0x57,
+	0x30, 0x57, 0x4D, 0x57, 0x48, 0x57, 0x7A, 0x57, 0x2C, 0x57, 0x20, 0x57,
+	0x4D, 0x57, 0x43, 0x57, 0x4B, 0x57, 0x20, 0x57, 0x32, 0x57, 0x30, 0x57,
+	0x30, 0x57, 0x4D, 0x57, 0x48, 0x57, 0x7A, 0x57, 0x0D, 0x57, 0x0A, 0xD0,
+	0x0F, 0x5B, 0x57, 0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x30,
+	0x57, 0x2E, 0x57, 0x30, 0x57, 0x30, 0x57, 0x34, 0x57, 0x37, 0x57, 0x31,
+	0x57, 0x31, 0x57, 0x5D, 0x57, 0x20, 0x57, 0x6E, 0x57, 0x65, 0x57, 0x74,
+	0x57, 0x3A, 0x57, 0x20, 0x57, 0x65, 0x57, 0x74, 0x57, 0x68, 0x57, 0x30,
+	0x57, 0x20, 0x57, 0x6C, 0x57, 0x69, 0x57, 0x6E, 0x57, 0x6B, 0x57, 0x20,
+	0x57, 0x75, 0x57, 0x70, 0x57, 0x20, 0x57, 0x31, 0x57, 0x30, 0x57, 0x30,
+	0x57, 0x4D, 0x57, 0x62, 0x57, 0x70, 0x57, 0x73, 0x57, 0x20, 0x57, 0x66,
+	0x57, 0x75, 0x57, 0x6C, 0x57, 0x6C, 0x57, 0x0D, 0x57, 0x0A, 0xC0, 0xB8,
+	0x02, 0x5B, 0x57, 0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x30,
+	0x57, 0x2E, 0x57, 0x30, 0x57, 0x31, 0x57, 0x32, 0x57, 0x30, 0x57, 0x30,
+	0x57, 0x33, 0x57, 0x5D, 0x57, 0x20, 0x57, 0x61, 0x57, 0x70, 0x57, 0x70,
+	0x57, 0x3A, 0x57, 0x20, 0x57, 0x73, 0x57, 0x65, 0x57, 0x6E, 0x57, 0x73,
+	0x57, 0x6F, 0x57, 0x72, 0x57, 0x20, 0x57, 0x70, 0x57, 0x6F, 0x57, 0x6C,
+	0x57, 0x6C, 0x57, 0x20, 0x57, 0x73, 0x57, 0x74, 0x57, 0x61, 0x57, 0x72,
+	0x57, 0x74, 0x57, 0x0D, 0x57, 0x0A, 0xA0, 0x06, 0x57, 0x57, 0x41, 0x57,
+	0x52, 0x57, 0x4E, 0x57, 0x3A, 0x57, 0x20, 0x57, 0x73, 0x57, 0x65, 0x57,
+	0x6E, 0x57, 0x73, 0x57, 0x6F, 0x57, 0x72, 0x57, 0x20, 0x57, 0x33, 0x57,
+	0x20, 0x57, 0x74, 0x57, 0x69, 0x57, 0x6D, 0x57, 0x65, 0x57, 0x6F, 0x57,
+	0x75, 0x57, 0x74, 0x57, 0x2C, 0x57, 0x20, 0x57, 0x72, 0x57, 0x65, 0x57,
+	0x74, 0x57, 0x72, 0x57, 0x79, 0x57, 0x20, 0x57, 0x31, 0x57, 0x0D, 0x57,
+	0x0A, 0x5A, 0x45, 0x57, 0x52, 0x57, 0x52, 0x57, 0x4F, 0x57, 0x52, 0x57,
+	0x3A, 0x57, 0x20, 0x57, 0x73, 0x57, 0x65, 0x57, 0x6E, 0x57, 0x73, 0x57,
+	0x6F, 0x57, 0x72, 0x57, 0x20, 0x57, 0x33, 0x57, 0x20, 0x57, 0x6E, 0x57,
+	0x6F, 0x57, 0x74, 0x57, 0x20, 0x57, 0x72, 0x57, 0x65, 0x57, 0x73, 0x57,
+	0x70, 0x57, 0x6F, 0x57, 0x6E, 0x57, 0x64, 0x57, 0x69, 0x57, 0x6E, 0x57,
+	0x67, 0x57, 0x0D, 0x57, 0x0A, 0x90, 0xA1, 0x0F, 0x5B, 0x57, 0x20, 0x57,
+	0x20, 0x57, 0x20, 0x57, 0x20, 0x57, 0x30, 0x57, 0x2E, 0x57, 0x35, 0x57,
+	0x31, 0x57, 0x32, 0x57, 0x34, 0x57, 0x34, 0x57, 0x30, 0x57, 0x5D, 0x57,
+	0x20, 0x57, 0x61, 0x57, 0x70, 0x57, 0x70, 0x57, 0x3A, 0x57, 0x20, 0x57,
+	0x69, 0x57, 0x64, 0x57, 0x6C, 0x57, 0x65, 0x57, 0x0D, 0x57, 0x0A,
+};
+
+const uint32_t replay_data_size = sizeof(replay_data);
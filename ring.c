@@ -0,0 +1,111 @@
+/**
+ * \file
+ *
+ * Single producer / single consumer byte ring.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "ring.h"
+
+#include <assert.h>
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty ring.
+ *
+ * \param ring    Ring instance.
+ * \param buffer  Ring memory.
+ * \param size    Ring size in bytes, power of two.
+ */
+void ring_init(struct _ring *ring, uint8_t *buffer, uint32_t size)
+{
+	assert(size && (size & (size - 1)) == 0);
+
+	ring->buffer = buffer;
+	ring->mask = size - 1;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->overruns = 0;
+}
+
+/**
+ * \brief Number of bytes waiting in the ring.
+ */
+uint32_t ring_count(const struct _ring *ring)
+{
+	return ring->head - ring->tail;
+}
+
+/**
+ * \brief Number of bytes which can still be written.
+ */
+uint32_t ring_free(const struct _ring *ring)
+{
+	return ring->mask + 1 - (ring->head - ring->tail);
+}
+
+/**
+ * \brief Write one byte, producer side.
+ *
+ * \return false if the ring was full and the byte was dropped.
+ */
+bool ring_put(struct _ring *ring, uint8_t data)
+{
+	uint32_t head = ring->head;
+
+	if (head - ring->tail > ring->mask) {
+		ring->overruns++;
+		return false;
+	}
+	ring->buffer[head & ring->mask] = data;
+	ring->head = head + 1;
+	return true;
+}
+
+/**
+ * \brief Read one byte, consumer side.
+ *
+ * \return false if the ring was empty.
+ */
+bool ring_get(struct _ring *ring, uint8_t *data)
+{
+	uint32_t tail = ring->tail;
+
+	if (tail == ring->head)
+		return false;
+	*data = ring->buffer[tail & ring->mask];
+	ring->tail = tail + 1;
+	return true;
+}
+
+/**
+ * \brief Get the contiguous readable segment at the tail, consumer side.
+ *
+ * \param ring  Ring instance.
+ * \param data  Returned pointer to the first byte.
+ *
+ * \return Segment length in bytes, 0 if the ring is empty.
+ */
+uint32_t ring_peek(const struct _ring *ring, const uint8_t **data)
+{
+	uint32_t tail = ring->tail;
+	uint32_t count = ring->head - tail;
+	uint32_t to_end = ring->mask + 1 - (tail & ring->mask);
+
+	*data = &ring->buffer[tail & ring->mask];
+	return count < to_end ? count : to_end;
+}
+
+/**
+ * \brief Release bytes returned by ring_peek(), consumer side.
+ */
+void ring_consume(struct _ring *ring, uint32_t count)
+{
+	ring->tail += count;
+}
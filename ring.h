@@ -0,0 +1,53 @@
+/**
+ * \file
+ *
+ * Single producer / single consumer byte ring, used between the receive
+ * interrupt and the main loop and between the main loop and the console
+ * mirror transmit interrupt.
+ *
+ * Head and tail are free running byte counters, the ring size must be a
+ * power of two. The consumer reads the ring in place: ring_peek() returns
+ * the longest contiguous readable segment and ring_consume() releases it.
+ */
+
+#ifndef _RING_H_
+#define _RING_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _ring {
+	uint8_t *buffer;
+	uint32_t mask;            /* size - 1 */
+	volatile uint32_t head;   /* bytes written, producer only */
+	volatile uint32_t tail;   /* bytes read, consumer only */
+	uint32_t overruns;        /* bytes dropped because the ring was full */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void ring_init(struct _ring *ring, uint8_t *buffer, uint32_t size);
+
+extern uint32_t ring_count(const struct _ring *ring);
+
+extern uint32_t ring_free(const struct _ring *ring);
+
+extern bool ring_put(struct _ring *ring, uint8_t data);
+
+extern bool ring_get(struct _ring *ring, uint8_t *data);
+
+extern uint32_t ring_peek(const struct _ring *ring, const uint8_t **data);
+
+extern void ring_consume(struct _ring *ring, uint32_t count);
+
+#endif /* _RING_H_ */
@@ -0,0 +1,218 @@
+/**
+ * \file
+ *
+ * Trigram index over a line store, see search.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "search.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint8_t _fold(uint8_t c)
+{
+	if (c >= 'A' && c <= 'Z')
+		return c - 'A' + 'a';
+	return c;
+}
+
+static uint32_t _bucket(const char *p)
+{
+	uint32_t t = (_fold(p[0]) << 16) | (_fold(p[1]) << 8) | _fold(p[2]);
+
+	return (t * 2654435761u) >> 20;	/* 12 bits: SEARCH_BUCKETS */
+}
+
+/**
+ * Posting referred to by \a ref, NULL if there is none or it was
+ * overwritten.
+ */
+static const struct _search_posting* _posting(const struct _search *search,
+					      uint32_t ref)
+{
+	if (ref == 0 || search->count - ref > search->mask)
+		return NULL;
+	return &search->postings[(ref - 1) & search->mask];
+}
+
+/**
+ * Oldest line whose postings are all in the pool, lines before it are
+ * searched by their text.
+ */
+static uint32_t _horizon(const struct _search *search)
+{
+	uint32_t first = line_store_first(search->store);
+	uint32_t horizon;
+
+	if (search->count <= search->mask)
+		return first;
+
+	/* the next posting to be overwritten is the oldest one, its line
+	 * may already have lost some */
+	horizon = search->postings[search->count & search->mask].seq + 1;
+	return (int32_t)(horizon - first) > 0 ? horizon : first;
+}
+
+/**
+ * Case folded substring check.
+ */
+static bool _contains(const char *text, const char *query, uint32_t qlen)
+{
+	uint32_t i;
+
+	for (; *text; text++) {
+		for (i = 0; i < qlen; i++) {
+			if (!text[i] || _fold(text[i]) != _fold(query[i]))
+				break;
+		}
+		if (i == qlen)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Search by reading the text of every line, newest first.
+ */
+static bool _scan(const struct _search *search, const char *query,
+		  uint32_t qlen, uint32_t before, uint32_t *seq)
+{
+	uint32_t first = line_store_first(search->store);
+	uint32_t s = before;
+
+	while ((int32_t)(s - first) > 0) {
+		const struct _line *line = line_store_get(search->store, --s);
+
+		if (line && _contains(line->text, query, qlen)) {
+			*seq = s;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize an empty index.
+ *
+ * \param search    Index instance.
+ * \param store     Line store indexed.
+ * \param postings  Posting pool.
+ * \param size      Number of postings, a power of two. A line takes one
+ *                  per distinct trigram, at most its length less two.
+ */
+void search_init(struct _search *search, const struct _line_store *store,
+		 struct _search_posting *postings, uint32_t size)
+{
+	assert((size & (size - 1)) == 0);
+
+	memset(search->buckets, 0, sizeof(search->buckets));
+	search->store = store;
+	search->postings = postings;
+	search->mask = size - 1;
+	search->count = 0;
+	search->lines = 0;
+}
+
+/**
+ * \brief Index a line just committed to the store.
+ */
+void search_add(struct _search *search, uint32_t seq)
+{
+	const struct _line *line = line_store_get(search->store, seq);
+	uint32_t i;
+
+	if (!line)
+		return;
+
+	for (i = 0; i + 3 <= line->len; i++) {
+		uint32_t *bucket = &search->buckets[_bucket(&line->text[i])];
+		const struct _search_posting *last = _posting(search, *bucket);
+		struct _search_posting *p;
+
+		/* one posting per bucket and line */
+		if (last && last->seq == seq)
+			continue;
+
+		p = &search->postings[search->count & search->mask];
+		p->seq = seq;
+		p->prev = *bucket;
+		*bucket = ++search->count;
+	}
+	search->lines++;
+}
+
+/**
+ * \brief Find the newest line before \a before containing \a query,
+ * ignoring ASCII case.
+ *
+ * \param search  Index instance.
+ * \param query   Text looked for, at most SEARCH_MAX_QUERY characters.
+ * \param before  Sequence number to search back from, line_store_end() for
+ *                the whole history.
+ * \param seq     Receives the sequence number of the line found.
+ *
+ * \return true if a line was found.
+ */
+bool search_find(const struct _search *search, const char *query,
+		 uint32_t before, uint32_t *seq)
+{
+	const struct _search_posting *cursor[SEARCH_MAX_QUERY];
+	uint32_t horizon = _horizon(search);
+	uint32_t qlen = strlen(query);
+	uint32_t n, i, c;
+	bool moved;
+
+	if (qlen == 0 || qlen > SEARCH_MAX_QUERY)
+		return false;
+	if (qlen < 3)
+		return _scan(search, query, qlen, before, seq);
+
+	n = qlen - 2;
+	for (i = 0; i < n; i++)
+		cursor[i] = _posting(search, search->buckets[_bucket(&query[i])]);
+
+	/* candidate: the newest line which may hold every trigram, the lists
+	 * only go back in time */
+	c = before - 1;
+	for (;;) {
+		/* a list which lacks c moves the candidate back to its next
+		 * line, then every list is checked against the new one */
+		do {
+			moved = false;
+			for (i = 0; i < n; i++) {
+				while (cursor[i] && (int32_t)(cursor[i]->seq - c) > 0)
+					cursor[i] = _posting(search, cursor[i]->prev);
+				if (!cursor[i] ||
+				    (int32_t)(cursor[i]->seq - horizon) < 0) {
+					/* no indexed line left, older lines
+					 * may have lost their postings */
+					if ((int32_t)(c + 1 - horizon) < 0)
+						horizon = c + 1;
+					return _scan(search, query, qlen, horizon, seq);
+				}
+				if (cursor[i]->seq != c) {
+					c = cursor[i]->seq;
+					moved = true;
+				}
+			}
+		} while (moved);
+
+		if (_contains(line_store_get(search->store, c)->text, query, qlen)) {
+			*seq = c;
+			return true;
+		}
+		c--;
+	}
+}
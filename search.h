@@ -0,0 +1,79 @@
+/**
+ * \file
+ *
+ * Trigram index over a line store, for searching the history.
+ *
+ * Every committed line adds one posting per distinct trigram (three
+ * consecutive characters, ASCII case folded) to the hash bucket of the
+ * trigram. Postings live in a FIFO pool in arrival order and each one
+ * links to the previous posting of its bucket, so a bucket is a list
+ * going back in time. When the pool wraps, the oldest postings are simply
+ * overwritten: a list walk stops at the first posting which is overwritten
+ * or whose line left the store, nothing is ever unlinked.
+ *
+ * A pool smaller than the trigrams of the whole history only indexes the
+ * newest lines. Lines older than the oldest posting are searched by their
+ * text, so a smaller pool makes searches deep into the history slower but
+ * never misses a line.
+ *
+ * A query walks the lists of its trigrams in step to find lines holding
+ * all of them, newest first, and checks the text of each candidate, since
+ * trigrams may collide in a bucket or appear in another order. Queries of
+ * fewer than three characters scan the text.
+ */
+
+#ifndef _SEARCH_H_
+#define _SEARCH_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "line_store.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of hash buckets, a power of two */
+#define SEARCH_BUCKETS          4096
+/** Longest query */
+#define SEARCH_MAX_QUERY        32
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _search_posting {
+	uint32_t seq;           /* line holding the trigram */
+	uint32_t prev;          /* previous posting of the bucket, see below */
+};
+
+/* Postings are referred to by their free running number + 1, 0 is none */
+struct _search {
+	const struct _line_store *store;
+	uint32_t buckets[SEARCH_BUCKETS];
+	struct _search_posting *postings;
+	uint32_t mask;          /* pool size - 1 */
+	uint32_t count;         /* postings ever added */
+
+	/* statistics */
+	uint32_t lines;         /* lines indexed */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void search_init(struct _search *search, const struct _line_store *store,
+			struct _search_posting *postings, uint32_t size);
+
+extern void search_add(struct _search *search, uint32_t seq);
+
+extern bool search_find(const struct _search *search, const char *query,
+			uint32_t before, uint32_t *seq);
+
+#endif /* _SEARCH_H_ */
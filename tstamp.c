@@ -0,0 +1,122 @@
+/**
+ * \file
+ *
+ * Arrival timestamps of received lines, see tstamp.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "tstamp.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a counter extension.
+ *
+ * \param ts    Extension instance.
+ * \param freq  Counter frequency in Hz.
+ * \param raw   Current counter value, taken as tick 0.
+ */
+void tstamp_init(struct _tstamp *ts, uint32_t freq, uint32_t raw)
+{
+	ts->freq = freq;
+	ts->last = raw;
+	ts->ticks = 0;
+}
+
+/**
+ * \brief Advance the extension to the current counter value.
+ *
+ * \return Extended tick count.
+ */
+uint64_t tstamp_update(struct _tstamp *ts, uint32_t raw)
+{
+	ts->ticks += raw - ts->last;
+	ts->last = raw;
+	return ts->ticks;
+}
+
+/**
+ * \brief Extend a counter value taken within half a counter period of
+ * the last update, before or after it.
+ */
+uint64_t tstamp_extend(const struct _tstamp *ts, uint32_t raw)
+{
+	return ts->ticks + (int32_t)(raw - ts->last);
+}
+
+/**
+ * \brief Convert a tick count to microseconds.
+ */
+uint64_t tstamp_to_us(const struct _tstamp *ts, uint64_t ticks)
+{
+	return (ticks / ts->freq) * 1000000 +
+	       (ticks % ts->freq) * 1000000 / ts->freq;
+}
+
+/**
+ * \brief Initialize an empty mark queue.
+ *
+ * \param q      Queue instance.
+ * \param marks  Storage.
+ * \param size   Number of marks, a power of two.
+ */
+void tstamp_marks_init(struct _tstamp_marks *q, struct _tstamp_mark *marks,
+		       uint32_t size)
+{
+	assert((size & (size - 1)) == 0);
+
+	q->marks = marks;
+	q->mask = size - 1;
+	q->head = 0;
+	q->tail = 0;
+	q->lost = 0;
+}
+
+/**
+ * \brief Queue a mark, producer side.
+ *
+ * \return false if the queue is full and the mark was dropped.
+ */
+bool tstamp_mark_put(struct _tstamp_marks *q, uint32_t pos, uint32_t raw)
+{
+	uint32_t head = q->head;
+	struct _tstamp_mark *mark;
+
+	if (head - q->tail > q->mask) {
+		q->lost++;
+		return false;
+	}
+	mark = &q->marks[head & q->mask];
+	mark->pos = pos;
+	mark->raw = raw;
+	q->head = head + 1;
+	return true;
+}
+
+/**
+ * \brief Oldest queued mark, consumer side.
+ *
+ * \return The mark, or NULL if the queue is empty.
+ */
+const struct _tstamp_mark* tstamp_mark_peek(const struct _tstamp_marks *q)
+{
+	if (q->head == q->tail)
+		return NULL;
+	return &q->marks[q->tail & q->mask];
+}
+
+/**
+ * \brief Release the mark returned by tstamp_mark_peek().
+ */
+void tstamp_mark_drop(struct _tstamp_marks *q)
+{
+	q->tail++;
+}
@@ -0,0 +1,73 @@
+/**
+ * \file
+ *
+ * Arrival timestamps of received lines.
+ *
+ * The receive interrupt reads a free running 32-bit hardware counter only
+ * when a byte starts a line (it follows a '\n' or arrives on an empty
+ * ring) and queues a mark holding the ring position of the byte and the
+ * raw counter value. The main loop extends raw values to 64-bit tick
+ * counts and converts them to microseconds, so the interrupt pays a
+ * compare per byte and a counter read per line.
+ *
+ * tstamp_update() must see the counter at least once per half counter
+ * period for the extension to be unambiguous.
+ */
+
+#ifndef _TSTAMP_H_
+#define _TSTAMP_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Extension of a 32-bit counter, main loop only */
+struct _tstamp {
+	uint32_t freq;            /* counter frequency in Hz */
+	uint32_t last;            /* raw value of the last update */
+	uint64_t ticks;           /* extended value of the last update */
+};
+
+struct _tstamp_mark {
+	uint32_t pos;             /* ring position of the first byte of a line */
+	uint32_t raw;             /* counter value when it arrived */
+};
+
+/** Single producer / single consumer queue of marks */
+struct _tstamp_marks {
+	struct _tstamp_mark *marks;
+	uint32_t mask;            /* size - 1 */
+	volatile uint32_t head;   /* producer only */
+	volatile uint32_t tail;   /* consumer only */
+	uint32_t lost;            /* marks dropped because the queue was full */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void tstamp_init(struct _tstamp *ts, uint32_t freq, uint32_t raw);
+
+extern uint64_t tstamp_update(struct _tstamp *ts, uint32_t raw);
+
+extern uint64_t tstamp_extend(const struct _tstamp *ts, uint32_t raw);
+
+extern uint64_t tstamp_to_us(const struct _tstamp *ts, uint64_t ticks);
+
+extern void tstamp_marks_init(struct _tstamp_marks *q,
+			      struct _tstamp_mark *marks, uint32_t size);
+
+extern bool tstamp_mark_put(struct _tstamp_marks *q, uint32_t pos, uint32_t raw);
+
+extern const struct _tstamp_mark* tstamp_mark_peek(const struct _tstamp_marks *q);
+
+extern void tstamp_mark_drop(struct _tstamp_marks *q);
+
+#endif /* _TSTAMP_H_ */
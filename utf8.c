@@ -0,0 +1,101 @@
+/**
+ * \file
+ *
+ * Incremental UTF-8 decoder, see utf8.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "utf8.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Start a sequence with a byte which is not a continuation byte.
+ *
+ * \return Number of codepoints completed: 1 for ASCII and invalid lead
+ * bytes, 0 when continuation bytes follow.
+ */
+static uint32_t _start(struct _utf8 *u, uint8_t byte, uint32_t *out)
+{
+	if (byte < 0x80) {
+		*out = byte;
+		return 1;
+	}
+	if (byte >= 0xC2 && byte <= 0xDF) {
+		u->codepoint = byte & 0x1F;
+		u->min = 0x80;
+		u->left = 1;
+	} else if (byte >= 0xE0 && byte <= 0xEF) {
+		u->codepoint = byte & 0x0F;
+		u->min = 0x800;
+		u->left = 2;
+	} else if (byte >= 0xF0 && byte <= 0xF4) {
+		u->codepoint = byte & 0x07;
+		u->min = 0x10000;
+		u->left = 3;
+	} else {
+		/* C0, C1 and F5 to FF never start a sequence */
+		*out = UTF8_REPLACEMENT;
+		return 1;
+	}
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the decoder, outside any sequence.
+ */
+void utf8_init(struct _utf8 *u)
+{
+	u->codepoint = 0;
+	u->min = 0;
+	u->left = 0;
+}
+
+/**
+ * \brief Feed a byte.
+ *
+ * \param u     Decoder instance.
+ * \param byte  Next byte of the stream.
+ * \param out   Receives the codepoints completed.
+ *
+ * \return Number of codepoints completed, 0 to 2: a byte which cuts a
+ * sequence short completes U+FFFD, then may complete itself.
+ */
+uint32_t utf8_feed(struct _utf8 *u, uint8_t byte, uint32_t out[2])
+{
+	uint32_t cp;
+
+	if (u->left == 0) {
+		if ((byte & 0xC0) == 0x80) {
+			*out = UTF8_REPLACEMENT;	/* stray continuation */
+			return 1;
+		}
+		return _start(u, byte, out);
+	}
+
+	if ((byte & 0xC0) != 0x80) {
+		/* sequence cut short */
+		u->left = 0;
+		out[0] = UTF8_REPLACEMENT;
+		return 1 + _start(u, byte, &out[1]);
+	}
+
+	u->codepoint = (u->codepoint << 6) | (byte & 0x3F);
+	if (--u->left)
+		return 0;
+
+	cp = u->codepoint;
+	if (cp < u->min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+		cp = UTF8_REPLACEMENT;
+	*out = cp;
+	return 1;
+}
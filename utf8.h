@@ -0,0 +1,47 @@
+/**
+ * \file
+ *
+ * Incremental UTF-8 decoder for the receive text path.
+ *
+ * Bytes are fed one at a time as they arrive, a codepoint may span two
+ * segments of the receive ring. ASCII bytes outside a sequence come out
+ * unchanged. Malformed input (a stray continuation byte, a sequence cut
+ * short, an overlong form, a surrogate or a codepoint past U+10FFFF) comes
+ * out as U+FFFD, once per malformed sequence; the byte which cut a
+ * sequence short starts over.
+ */
+
+#ifndef _UTF8_H_
+#define _UTF8_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define UTF8_REPLACEMENT	0xFFFD
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _utf8 {
+	uint32_t codepoint;    /* bits of the sequence so far */
+	uint32_t min;          /* smallest codepoint of the sequence length */
+	uint8_t left;          /* continuation bytes still expected */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void utf8_init(struct _utf8 *u);
+
+extern uint32_t utf8_feed(struct _utf8 *u, uint8_t byte, uint32_t out[2]);
+
+#endif /* _UTF8_H_ */
@@ -0,0 +1,503 @@
+/**
+ * \file
+ *
+ * Text view rendering, see view.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "view.h"
+
+#include "lcd_color.h"
+#include "lcd_draw.h"
+#include "lcd_font.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Write back the cache lines covering the given rows so the LCDC sees them.
+ */
+static void _clean_rows(const struct _view *view, uint32_t row, uint32_t n)
+{
+	lcd_clean_rows(view->y + row * view->row_height, n * view->row_height);
+}
+
+/**
+ * Width of a cell of the time and repeat columns: a VIEW_COLUMNS-th part
+ * of the view, or a digit of a font drawn wider than that.
+ */
+static uint32_t _pitch(const struct _view *view)
+{
+	uint32_t pitch = view->width / VIEW_COLUMNS;
+	uint32_t digit = lcd_char_advance('0');
+
+	return digit > pitch ? digit : pitch;
+}
+
+/**
+ * Advance of a text. Committed lines are not measured again, the store
+ * keeps their width.
+ */
+static uint32_t _advance(const char *text)
+{
+	uint32_t prefix = 0;
+	char prev = 0;
+
+	for (; *text; text++) {
+		prefix += lcd_char_kerning(prev, *text) + lcd_char_advance(*text);
+		prev = *text;
+	}
+	return prefix;
+}
+
+/**
+ * Clear a row and draw a text on it.
+ */
+static void _draw_row(const struct _view *view, uint32_t row,
+		      const char *text, uint32_t color)
+{
+	uint32_t y = view->y + row * view->row_height;
+	bool staged = lcd_begin_band(y, view->row_height);
+
+	lcd_draw_filled_rectangle(view->x, y, view->x + view->width - 1,
+				  y + view->row_height - 1, view->bg);
+	if (text && *text)
+		lcd_draw_string(view->x, y, text, color);
+	if (staged)
+		lcd_end_band();
+}
+
+/**
+ * Draw the repeat count of a line over the end of its row.
+ */
+static void _draw_repeat(const struct _view *view, uint32_t row,
+			 const struct _line *line, uint32_t color)
+{
+	char count[VIEW_REPEAT_CHARS + 1];
+	uint32_t end;
+	uint32_t y = view->y + row * view->row_height;
+	uint32_t pitch = _pitch(view);
+	uint32_t x = view->x + view->width - VIEW_REPEAT_CHARS * pitch;
+	bool staged = lcd_begin_band(y, view->row_height);
+
+	snprintf(count, sizeof(count), " x%u", (unsigned)line->repeat + 1);
+	lcd_draw_filled_rectangle(x, y, view->x + view->width - 1,
+				  y + view->row_height - 1, view->bg);
+	/* right aligned in the count cells */
+	end = x + VIEW_REPEAT_CHARS * pitch;
+	lcd_draw_string(end - _advance(count), y, count, color);
+	if (staged)
+		lcd_end_band();
+}
+
+/**
+ * Text color of a line.
+ */
+static uint32_t _line_color(const struct _view *view, uint32_t seq)
+{
+	uint16_t tags = line_store_tags(view->store, seq);
+	uint8_t bit;
+
+	for (bit = 0; tags && bit < view->tag_count; bit++, tags >>= 1) {
+		if (tags & 1)
+			return view->tag_colors[bit];
+	}
+	return view->fg;
+}
+
+/**
+ * Draw a committed line, with its time column if enabled.
+ */
+static void _draw_line(const struct _view *view, uint32_t row, uint32_t seq,
+		       bool mark)
+{
+	const struct _line *line = line_store_get(view->store, seq);
+	const struct _line *prev;
+	char column[VIEW_TIME_CHARS + 1];
+	uint32_t y = view->y + row * view->row_height;
+	uint32_t pitch = _pitch(view);
+	uint32_t color = mark ? view->marker : _line_color(view, seq);
+	bool staged;
+	uint64_t us;
+
+	/* the whole row in one band, the calls below do not open their own */
+	staged = lcd_begin_band(y, view->row_height);
+
+	if (!line || view->time_mode == VIEW_TIME_OFF) {
+		_draw_row(view, row, line ? line->text : NULL, color);
+		if (line && line->repeat)
+			_draw_repeat(view, row, line, color);
+		if (staged)
+			lcd_end_band();
+		return;
+	}
+
+	column[0] = 0;
+	if (view->time_mode == VIEW_TIME_ABSOLUTE) {
+		us = line_stamp(line);
+		snprintf(column, sizeof(column), "%5u.%06u ",
+			 (unsigned)(us / 1000000 % 100000), (unsigned)(us % 1000000));
+	} else {
+		prev = line_store_get(view->store, seq - 1);
+		if (prev) {
+			us = line_stamp(line) - line_stamp(prev);
+			snprintf(column, sizeof(column), "+%4u.%06u ",
+				 (unsigned)(us / 1000000 % 10000),
+				 (unsigned)(us % 1000000));
+		}
+	}
+
+	_draw_row(view, row, column, view->time_color);
+	if (line->len > 0) {
+		char text[LINE_MAX_CHARS + 1];
+
+		/* what fits right of the time column, counted by the store */
+		memcpy(text, line->text, line->fit);
+		text[line->fit] = 0;
+		lcd_draw_string(view->x + VIEW_TIME_CHARS * pitch, y, text, color);
+	}
+	if (line->repeat)
+		_draw_repeat(view, row, line, color);
+	if (staged)
+		lcd_end_band();
+}
+
+/**
+ * Update the row of a line whose repeat count may have changed, if it is
+ * on screen. Unless the text reaches the count, only the count cells are
+ * redrawn.
+ */
+static void _update_repeat(const struct _view *view, uint32_t seq)
+{
+	const struct _line *line = line_store_get(view->store, seq);
+	uint32_t pitch = _pitch(view);
+	uint32_t row, start;
+
+	/* the repeats went to a newer line */
+	if (!line || line->repeat == 0)
+		return;
+
+	if (view->hold || view->filter == VIEW_FILTER_NONE) {
+		row = seq - view->top;
+		if (row >= view->rows)
+			return;
+	} else {
+		for (row = 0; row < view->shown && view->page[row] != seq; row++)
+			;
+		if (row == view->shown)
+			return;
+	}
+
+	start = view->time_mode == VIEW_TIME_OFF ? 0 : VIEW_TIME_CHARS * pitch;
+	if (start + line->width <= view->width - VIEW_REPEAT_CHARS * pitch)
+		_draw_repeat(view, row, line,
+			     (view->hold && seq == view->anchor) ?
+			     view->marker : _line_color(view, seq));
+	else
+		_draw_line(view, row, seq, view->hold && seq == view->anchor);
+	_clean_rows(view, row, 1);
+}
+
+/**
+ * Render with a filter set.
+ */
+static void _render_filtered(struct _view *view)
+{
+	uint32_t first = line_store_first(view->store);
+	uint32_t end = line_store_end(view->store);
+	uint32_t found[VIEW_MAX_ROWS];
+	uint32_t n, row, keep;
+
+	/* a line shown was evicted, start over */
+	if (view->shown && (int32_t)(view->page[0] - first) < 0)
+		view->redraw = true;
+
+	if (view->redraw) {
+		view->shown = line_store_find(view->store, first, end, view->filter,
+					      view->page, view->rows);
+		for (row = 0; row < view->rows; row++) {
+			if (row < view->shown)
+				_draw_line(view, row, view->page[row], false);
+			else
+				_draw_row(view, row, NULL, view->fg);
+		}
+		_clean_rows(view, 0, view->rows);
+		view->frames++;
+	} else {
+		n = line_store_find(view->store, view->end, end, view->filter,
+				    found, view->rows);
+		if (n == 0) {
+			/* nothing new passes the filter */
+		} else if (view->shown + n <= view->rows) {
+			for (row = 0; row < n; row++) {
+				view->page[view->shown + row] = found[row];
+				_draw_line(view, view->shown + row, found[row], false);
+			}
+			_clean_rows(view, view->shown, n);
+			view->shown += n;
+			view->frames++;
+		} else {
+			keep = view->rows - n;
+			memmove(view->page, &view->page[view->shown - keep],
+				keep * sizeof(view->page[0]));
+			memcpy(&view->page[keep], found, n * sizeof(found[0]));
+			view->shown = view->rows;
+			for (row = 0; row < view->rows; row++)
+				_draw_line(view, row, view->page[row], false);
+			_clean_rows(view, 0, view->rows);
+			view->frames++;
+		}
+	}
+
+	view->end = end;
+	view->redraw = false;
+}
+
+/**
+ * Render while held on the anchor line: the anchor is kept in the middle
+ * row while the history allows, the page only moves when its lines are
+ * evicted.
+ */
+static void _render_hold(struct _view *view)
+{
+	uint32_t first = line_store_first(view->store);
+	uint32_t end = line_store_end(view->store);
+	uint32_t top, row;
+
+	if (end - first <= view->rows) {
+		top = first;
+	} else {
+		top = view->anchor - view->rows / 2;
+		if ((int32_t)(top - first) < 0)
+			top = first;
+		if ((int32_t)(end - view->rows - top) < 0)
+			top = end - view->rows;
+	}
+
+	if (view->redraw || top != view->top) {
+		for (row = 0; row < view->rows; row++)
+			_draw_line(view, row, top + row, top + row == view->anchor);
+		_clean_rows(view, 0, view->rows);
+		view->frames++;
+	}
+
+	view->top = top;
+	view->end = end;
+	view->redraw = false;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a view showing the tail of \a store.
+ *
+ * \param view        View instance.
+ * \param store       Line store to show.
+ * \param x           X-coordinate of the text area.
+ * \param y           Y-coordinate of the text area.
+ * \param width       Text area width in pixels.
+ * \param rows        Number of text rows, at most VIEW_MAX_ROWS.
+ * \param row_height  Row pitch in pixels.
+ * \param fg          Text color.
+ * \param bg          Background color.
+ */
+void view_init(struct _view *view, const struct _line_store *store,
+	       uint32_t x, uint32_t y, uint32_t width, uint16_t rows,
+	       uint16_t row_height, uint32_t fg, uint32_t bg)
+{
+	assert(rows <= VIEW_MAX_ROWS);
+
+	view->store = store;
+	view->x = x;
+	view->y = y;
+	view->width = width;
+	view->rows = rows;
+	view->row_height = row_height;
+	view->fg = fg;
+	view->bg = bg;
+	view->marker = COLOR_YELLOW;
+	view->time_color = COLOR_DARKGRAY;
+	view->time_mode = VIEW_TIME_OFF;
+	view->tag_colors = NULL;
+	view->tag_count = 0;
+	view->filter = VIEW_FILTER_NONE;
+	view->hold = false;
+	view->frames = 0;
+	view->skipped = 0;
+	view_reset(view);
+}
+
+/**
+ * \brief Width of the text of a line right of the time column, the width
+ * the store counts the characters which fit by, see line_store_set_width().
+ */
+uint32_t view_fit_width(const struct _view *view)
+{
+	return view->width - VIEW_TIME_CHARS * _pitch(view);
+}
+
+/**
+ * \brief Forget what is on screen, the next render repaints every row.
+ */
+void view_reset(struct _view *view)
+{
+	view->top = line_store_first(view->store);
+	view->end = view->top;
+	view->shown = 0;
+	view->repeats = view->store->repeats;
+	view->redraw = true;
+}
+
+/**
+ * \brief Show another store, the next render repaints every row.
+ */
+void view_set_store(struct _view *view, const struct _line_store *store)
+{
+	view->store = store;
+	view_reset(view);
+}
+
+/**
+ * \brief Select the time column, the next render repaints every row.
+ */
+void view_set_time_mode(struct _view *view, uint8_t mode)
+{
+	view->time_mode = mode;
+	view->redraw = true;
+}
+
+/**
+ * \brief Show only the lines having any of the \a filter tags, or every
+ * line with VIEW_FILTER_NONE. The next render rebuilds the page.
+ */
+void view_set_filter(struct _view *view, uint16_t filter)
+{
+	view->filter = filter;
+	view_reset(view);
+}
+
+/**
+ * \brief Hold the view on a line of the history.
+ */
+void view_show_line(struct _view *view, uint32_t seq)
+{
+	view->hold = true;
+	view->anchor = seq;
+	view->redraw = true;
+}
+
+/**
+ * \brief Return to the tail of the store.
+ */
+void view_follow(struct _view *view)
+{
+	view->hold = false;
+	view_reset(view);
+}
+
+/**
+ * \brief Color lines by their tags, the next render repaints every row.
+ *
+ * \param view    View instance.
+ * \param colors  Text color of tag bits 0 .. count - 1.
+ * \param count   Number of colors.
+ */
+void view_set_tag_colors(struct _view *view, const uint32_t *colors,
+			 uint8_t count)
+{
+	view->tag_colors = colors;
+	view->tag_count = count;
+	view->redraw = true;
+}
+
+/**
+ * \brief Check whether view_render() has anything to do.
+ */
+bool view_dirty(const struct _view *view)
+{
+	return view->redraw || view->end != line_store_end(view->store) ||
+	       view->repeats != view->store->repeats;
+}
+
+/**
+ * \brief Bring the screen up to date with the store.
+ *
+ * Only lines visible after the update are rasterized. If the screen does
+ * not scroll, only the new rows are drawn.
+ */
+void view_render(struct _view *view)
+{
+	uint32_t first = line_store_first(view->store);
+	uint32_t end = line_store_end(view->store);
+	uint32_t top, row, hidden = 0;
+	char marker[LINE_MAX_CHARS + 1];
+
+	if (!view_dirty(view))
+		return;
+
+	/* repeats only ever go to the newest line, which was the last one
+	 * shown or arrived since: the lines arrived are drawn with their
+	 * counts below, only the last one shown is updated here */
+	if (view->repeats != view->store->repeats) {
+		view->repeats = view->store->repeats;
+		if (!view->redraw) {
+			_update_repeat(view, view->end - 1);
+			if (view->end == end) {
+				view->frames++;
+				return;
+			}
+		}
+	}
+
+	if (view->hold) {
+		_render_hold(view);
+		return;
+	}
+	if (view->filter != VIEW_FILTER_NONE) {
+		_render_filtered(view);
+		return;
+	}
+
+	top = (end - first > view->rows) ? end - view->rows : first;
+
+	if (!view->redraw && top == view->top) {
+		/* no scrolling, append the new lines */
+		uint32_t from = view->end - top;
+
+		for (row = from; row < end - top; row++)
+			_draw_line(view, row, top + row, false);
+		_clean_rows(view, from, end - top - from);
+	} else {
+		/* lines which scrolled off before this frame, keep the top row
+		 * to tell how many */
+		if (!view->redraw && (int32_t)(top - view->end) > 0) {
+			hidden = top + 1 - view->end;
+			snprintf(marker, sizeof(marker), "-- %u lines skipped --",
+				 (unsigned)hidden);
+		}
+
+		for (row = 0; row < view->rows; row++) {
+			if (row == 0 && hidden)
+				_draw_row(view, row, marker, view->marker);
+			else
+				_draw_line(view, row, top + row, false);
+		}
+		_clean_rows(view, 0, view->rows);
+	}
+
+	view->top = top;
+	view->end = end;
+	view->redraw = false;
+	view->skipped += hidden;
+	view->frames++;
+}
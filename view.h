@@ -0,0 +1,141 @@
+/**
+ * \file
+ *
+ * Text view: renders the tail of a line store into a screen region.
+ *
+ * Rendering is decoupled from line arrival. The caller commits lines to the
+ * store at input rate and calls view_render() at frame rate; only the lines
+ * visible at that moment are rasterized. When more lines than the view can
+ * show arrived since the previous frame, the lines that scrolled off unseen
+ * are skipped and the top row shows how many were skipped.
+ *
+ * An optional time column shows the arrival time of each line, either
+ * since boot or since the previous line. The text is shortened to make
+ * room for it.
+ *
+ * The columns of the time and repeat count are VIEW_COLUMNS-th parts of
+ * the view width, or as wide as a digit of a font drawn wider (see
+ * lcd_set_text_scale()). The text itself is laid out by the advance of
+ * every character, so proportional fonts fit as much of a line as its
+ * width allows. The store measures every line once as it arrives, with
+ * the view width and view_fit_width() (see line_store_set_width()); the
+ * view lays committed lines out from the width and fit count they keep.
+ *
+ * Lines can be colored by their tags (see line_store.h): the color of the
+ * lowest tag bit set which has a color is used.
+ *
+ * With a filter set, the view shows the newest lines having any of the
+ * filter tags. Switching filters rebuilds the page from the tag array of
+ * the store, the text is not looked at.
+ *
+ * view_show_line() holds the view on a line of the history, e.g. a search
+ * result, shown in the marker color; new lines do not scroll it until
+ * view_follow() returns to the tail.
+ *
+ * A line collapsing repeats (see line_store_collapse()) shows the number of
+ * copies at the end of its row. When only that number changes, only those
+ * cells are redrawn.
+ */
+
+#ifndef _VIEW_H_
+#define _VIEW_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "line_store.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Cells across a view, sets the pitch of the time and repeat columns */
+#define VIEW_COLUMNS		66
+
+/** Time column modes */
+enum {
+	VIEW_TIME_OFF = 0,
+	VIEW_TIME_ABSOLUTE,    /* seconds since boot */
+	VIEW_TIME_RELATIVE,    /* seconds since the previous line */
+};
+
+/** Characters taken by the time column, "sssss.uuuuuu " */
+#define VIEW_TIME_CHARS		13
+
+/** Characters taken by the repeat count, " x65536" */
+#define VIEW_REPEAT_CHARS	7
+
+/** Most rows of a view */
+#define VIEW_MAX_ROWS		32
+
+/** Filter showing every line */
+#define VIEW_FILTER_NONE	0
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _view {
+	const struct _line_store *store;
+	uint32_t x;            /* top-left corner of the text area */
+	uint32_t y;
+	uint32_t width;        /* text area width in pixels */
+	uint16_t rows;         /* text rows */
+	uint16_t row_height;   /* glyph height + line spacing */
+	uint32_t fg;           /* text color */
+	uint32_t bg;           /* background color */
+	uint32_t marker;       /* color of the skipped-lines marker */
+	uint32_t time_color;   /* color of the time column */
+	uint8_t time_mode;     /* VIEW_TIME_xxx */
+	const uint32_t *tag_colors; /* text color of tag bits 0 .. tag_count - 1 */
+	uint8_t tag_count;
+	uint16_t filter;       /* tags of the lines shown, VIEW_FILTER_NONE for all */
+
+	uint32_t top;          /* sequence number shown on the first row */
+	uint32_t end;          /* sequence number after the last line shown */
+	bool redraw;           /* repaint every row on the next render */
+	uint32_t page[VIEW_MAX_ROWS]; /* lines shown while filtering */
+	uint16_t shown;        /* entries in page */
+	bool hold;             /* showing the history around anchor */
+	uint32_t anchor;
+	uint32_t repeats;      /* repeats of the store at the previous render */
+
+	/* statistics */
+	uint32_t frames;       /* renders that touched the screen */
+	uint32_t skipped;      /* lines never rasterized */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+extern void view_init(struct _view *view, const struct _line_store *store,
+		      uint32_t x, uint32_t y, uint32_t width, uint16_t rows,
+		      uint16_t row_height, uint32_t fg, uint32_t bg);
+
+extern uint32_t view_fit_width(const struct _view *view);
+
+extern void view_reset(struct _view *view);
+
+extern void view_set_store(struct _view *view, const struct _line_store *store);
+
+extern void view_set_time_mode(struct _view *view, uint8_t mode);
+
+extern void view_set_filter(struct _view *view, uint16_t filter);
+
+extern void view_show_line(struct _view *view, uint32_t seq);
+
+extern void view_follow(struct _view *view);
+
+extern void view_set_tag_colors(struct _view *view, const uint32_t *colors,
+				uint8_t count);
+
+extern bool view_dirty(const struct _view *view);
+
+extern void view_render(struct _view *view);
+
+#endif /* _VIEW_H_ */